@@ -4,14 +4,15 @@
 #include <string.h>
 #include <stdlib.h>
 
-// Forward declarations for activity functions
-void runActivity1();
-void runActivity2();
-void runActivity3();
-void runActivity4();
-void runActivity6();
-void runActivity7();
-void runActivity8();
+#include "src/common/opengl_setup.h"
+#include "src/common/activity_host.h"
+#include "src/common/orbit_swarm.h"
+#include "src/common/clipper.h"
+#include "src/common/undistort.h"
+#include "src/common/gradient_fill.h"
+#include "src/common/regression.h"
+#include "src/common/calibration.h"
+#include "src/common/mapped_image.h"
 
 void printUsage(const char* programName) {
     printf("\n");
@@ -19,7 +20,11 @@ void printUsage(const char* programName) {
     printf("║        Computer Vision Assignments - Activity Launcher     ║\n");
     printf("╚════════════════════════════════════════════════════════════╝\n");
     printf("\n");
-    printf("Usage: %s <activity_number>\n\n", programName);
+    printf("Usage: %s <activity_number...|all> [options]\n", programName);
+    printf("       %s --bench <activity_number|all> [--frames K] [--json FILE] [options]\n", programName);
+    printf("       %s --bench-cpu <swarm|clip|undistort|gradient|calibrate|imageio> [--count N] [--headless]\n", programName);
+    printf("       %s --calibrate --board COLSxROWS [--square S] [--save FILE] image...\n", programName);
+    printf("       %s --regress [activity_number...|all] [--golden DIR] [--diff DIR] [--tolerance T] [options]\n\n", programName);
     printf("Available activities:\n");
     printf("  1  - Instalasi (Installation Test)\n");
     printf("       Verify OpenGL installation with a colored triangle\n\n");
@@ -34,79 +39,336 @@ void printUsage(const char* programName) {
     printf("  7  - Satelite Duo (Satellite Duo)\n");
     printf("       Simulate orbital motion with two satellites\n\n");
     printf("  8  - Undistorted Cray 2\n");
-    printf("       Demonstrate distortion correction with grid rendering\n\n");
+    printf("       Correct lens distortion in a photo behind a reference grid\n\n");
+    printf("Several activities (or 'all') run one after another in the same window\n");
+    printf("and GL context; ESC or the --frames limit moves on to the next one.\n\n");
+    printRenderOptionsUsage();
+    printf("\n");
     printf("Examples:\n");
     printf("  %s 1    # Run activity 1 (Instalasi)\n", programName);
     printf("  %s 4    # Run activity 4 (Bull's Eye)\n", programName);
+    printf("  %s 7 --headless --frames 120 --out frames/   # Render 120 frames offscreen\n", programName);
+    printf("  %s all --headless --frames 60 --out frames/  # Every activity in one context\n", programName);
+    printf("  %s 4 --renderer soft                         # Draw with the CPU rasterizer\n", programName);
+    printf("  %s 7 --gpu-trace trace.json                 # GPU ms per render section, Chrome trace\n", programName);
+    printf("  %s all --headless --frames 60 --gl-stats gl.csv  # Draws, state changes, upload bytes per frame\n", programName);
+    printf("  %s --bench all --frames 500                 # Frame-time table + JSON for every activity\n", programName);
+    printf("  %s --bench-cpu swarm --count 4000000        # Swarm body-updates/s vs thread count\n", programName);
+    printf("  %s --bench-cpu clip --count 10000000        # CPU clipping vs GPU-only triangles/s\n", programName);
+    printf("  %s --bench-cpu undistort --count 200        # 1080p lens remap MP/s and GB/s vs threads\n", programName);
+    printf("  %s --bench-cpu gradient --count 10          # 4K-16K gradient fill MP/s vs threads\n", programName);
+    printf("  %s --bench-cpu calibrate --count 200        # Lens fit from 200 synthetic checkerboard views\n", programName);
+    printf("  %s --bench-cpu imageio --count 100         # 1080p PPM load + texture upload: fread vs mmap/PBO\n", programName);
+    printf("  %s --calibrate --board 9x6 --save lens.txt shots/*.pgm   # Estimate k1-k3, p1, p2\n", programName);
+    printf("  %s --regress all                            # Headless renders vs docs/*.png, in parallel\n", programName);
     printf("\n");
 }
 
-int main(int argc, char* argv[]) {
-    // Check if activity number is provided
-    if (argc != 2) {
-        printf("Error: Missing activity number\n");
+// Activities available in this assignment set (activity 5 is skipped)
+const Activity* const ACTIVITIES[] = {
+    &ACTIVITY1, &ACTIVITY2, &ACTIVITY3, &ACTIVITY4, &ACTIVITY6, &ACTIVITY7, &ACTIVITY8
+};
+const int ACTIVITY_COUNT = sizeof(ACTIVITIES) / sizeof(ACTIVITIES[0]);
+
+// The activity with this number, or NULL
+const Activity* findActivity(int activityNum) {
+    for (int i = 0; i < ACTIVITY_COUNT; i++)
+        if (ACTIVITIES[i]->number == activityNum) return ACTIVITIES[i];
+    return NULL;
+}
+
+// Parse activity numbers (or 'all') from argv[1..] up to the first option.
+// Returns the index of the first option, or -1 on an invalid activity number.
+int parseActivityList(int argc, char* argv[], std::vector<const Activity*>& activities) {
+    int i = 1;
+    for (; i < argc && strncmp(argv[i], "--", 2) != 0; i++) {
+        if (strcmp(argv[i], "all") == 0) {
+            activities.insert(activities.end(), ACTIVITIES, ACTIVITIES + ACTIVITY_COUNT);
+            continue;
+        }
+        const Activity* activity = findActivity(atoi(argv[i]));
+        if (!activity) {
+            printf("Error: Invalid activity number '%s'\n", argv[i]);
+            return -1;
+        }
+        activities.push_back(activity);
+    }
+    return i;
+}
+
+// Run activities one after another in one window and GL context.
+// With frame statistics on, each activity's results are appended to 'results'.
+bool launchActivities(const std::vector<const Activity*>& activities, std::vector<BenchResult>* results) {
+    ActivityHost host = { NULL, 0.0, 0.0, 0, "" };
+    bool ok = true;
+    for (size_t i = 0; i < activities.size() && ok; i++) {
+        const Activity& activity = *activities[i];
+        printf("Launching Activity %d: %s\n", activity.number, activity.name);
+        printf("═══════════════════════════════════════\n\n");
+        ok = runHostedActivity(host, activity);
+
+        if (ok && results) {
+            if (g_frameStats.wallMs.empty()) {
+                fprintf(stderr, "Activity %d did not render any frames\n", activity.number);
+                ok = false;
+            } else {
+                results->push_back(summarizeFrameStats(activity.number));
+            }
+        }
+    }
+    closeActivityHost(host);
+    return ok;
+}
+
+// ./main --bench <N|all> [--frames K] [--json FILE] [render options]
+int runBenchmark(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("Error: --bench needs an activity number or 'all'\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Pull out --json, pass everything else to the render option parser
+    const char* jsonPath = NULL;
+    std::vector<char*> renderArgs;
+    renderArgs.push_back(argv[0]);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            renderArgs.push_back(argv[i]);
+        }
+    }
+
+    g_renderOptions.frames = 300;  // Default frame count, overridable with --frames
+    if (!parseRenderOptions((int)renderArgs.size(), renderArgs.data(), 1)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    g_renderOptions.vsync = false;
+    g_frameStats.enabled = true;
+
+    std::vector<const Activity*> activities;
+    if (strcmp(argv[2], "all") == 0) {
+        activities.assign(ACTIVITIES, ACTIVITIES + ACTIVITY_COUNT);
+    } else if (findActivity(atoi(argv[2]))) {
+        activities.push_back(findActivity(atoi(argv[2])));
+    } else {
+        printf("Error: Invalid activity number '%s'\n", argv[2]);
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    if (!launchActivities(activities, &results))
+        return 1;
+
+    printf("\nBenchmark: %d frames per activity, vsync off%s\n",
+           g_renderOptions.frames, g_renderOptions.headless ? ", headless" : "");
+    printBenchTable(results);
+
+    if (jsonPath) {
+        FILE* jsonFile = fopen(jsonPath, "w");
+        if (!jsonFile) {
+            fprintf(stderr, "Failed to open '%s' for writing\n", jsonPath);
+            return 1;
+        }
+        writeBenchJson(jsonFile, results);
+        fclose(jsonFile);
+        printf("JSON results written to %s\n", jsonPath);
+    } else {
+        writeBenchJson(stdout, results);
+    }
+
+    return 0;
+}
+
+// ./main --bench-cpu <name> [--count N]: CPU engine benchmarks
+// (benchmarks that compare against the GPU open a context; --headless works too)
+int runCpuBenchmark(int argc, char* argv[]) {
+    g_renderOptions.frames = 1;
+    if (argc < 3 || !parseRenderOptions(argc, argv, 3)) {
         printUsage(argv[0]);
         return 1;
     }
+    size_t count = (size_t)g_renderOptions.count;
 
-    // Parse activity number
-    int activityNum = atoi(argv[1]);
-
-    // Launch the requested activity
-    switch (activityNum) {
-        case 1:
-            printf("Launching Activity 1: Instalasi\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity1();
-            break;
-
-        case 2:
-            printf("Launching Activity 2: Clipping\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity2();
-            break;
-
-        case 3:
-            printf("Launching Activity 3: Color Interpolation\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity3();
-            break;
-
-        case 4:
-            printf("Launching Activity 4: Bull's Eye Target\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity4();
-            break;
-
-        case 6:
-            printf("Launching Activity 6: Bola Merah Kuning Biru\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity6();
-            break;
-
-        case 7:
-            printf("Launching Activity 7: Satelite Duo\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity7();
-            break;
-
-        case 8:
-            printf("Launching Activity 8: Undistorted Cray 2\n");
-            printf("═══════════════════════════════════════\n\n");
-            runActivity8();
-            break;
-
-        default:
-            printf("Error: Invalid activity number '%d'\n", activityNum);
-            printf("Note: Activity 5 is not available in this assignment set\n\n");
+    if (strcmp(argv[2], "swarm") == 0) {
+        runSwarmBenchmark(count > 0 ? count : 1 << 22);
+    } else if (strcmp(argv[2], "clip") == 0) {
+        runClipBenchmark(count > 0 ? count : 10000000);
+    } else if (strcmp(argv[2], "undistort") == 0) {
+        runUndistortBenchmark(count > 0 ? (int)count : 100);
+    } else if (strcmp(argv[2], "gradient") == 0) {
+        runGradientBenchmark(count > 0 ? (int)count : 5);
+    } else if (strcmp(argv[2], "calibrate") == 0) {
+        runCalibrationBenchmark(count > 0 ? (int)count : 50);
+    } else if (strcmp(argv[2], "imageio") == 0) {
+        runImageStreamBenchmark(count > 0 ? (int)count : 50);
+    } else {
+        printf("Error: Unknown CPU benchmark '%s'\n", argv[2]);
+        printUsage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
+
+// ./main --regress [N...|all] [--golden DIR] [--diff DIR] [--tolerance T] [render options]
+// Render options (e.g. --renderer soft) are passed on to every child render.
+int runRegression(int argc, char* argv[]) {
+    RegressionOptions options = { argv[0], NULL, "regress-out", REGRESS_DEFAULT_TOLERANCE, "" };
+    std::vector<int> activities;
+    int i = 2;
+    for (; i < argc && strncmp(argv[i], "--", 2) != 0; i++) {
+        if (strcmp(argv[i], "all") == 0) {
+            for (int g = 0; g < GOLDEN_IMAGE_COUNT; g++)
+                activities.push_back(GOLDEN_IMAGES[g].activity);
+        } else if (findGoldenImage(atoi(argv[i]))) {
+            activities.push_back(atoi(argv[i]));
+        } else {
+            printf("Error: Activity '%s' has no golden image\n", argv[i]);
+            return 1;
+        }
+    }
+    if (activities.empty()) {
+        for (int g = 0; g < GOLDEN_IMAGE_COUNT; g++)
+            activities.push_back(GOLDEN_IMAGES[g].activity);
+    }
+
+    // Pull out the suite's own options; the rest is checked here and forwarded
+    std::vector<char*> renderArgs;
+    renderArgs.push_back(argv[0]);
+    for (; i < argc; i++) {
+        if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            options.goldenDir = argv[++i];
+        } else if (strcmp(argv[i], "--diff") == 0 && i + 1 < argc) {
+            options.outDir = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            options.tolerance = atoi(argv[++i]);
+        } else {
+            renderArgs.push_back(argv[i]);
+            options.renderArgs += " " + shellQuote(argv[i]);
+        }
+    }
+    g_renderOptions.frames = 1;
+    if (!parseRenderOptions((int)renderArgs.size(), renderArgs.data(), 1)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string goldenDir;
+    if (!options.goldenDir) {
+        goldenDir = findGoldenDirectory(argv[0]);
+        options.goldenDir = goldenDir.c_str();
+    }
+
+    return runRegressionSuite(options, activities) ? 0 : 1;
+}
+
+// ./main --calibrate --board COLSxROWS [--square S] [--save FILE] image...
+// COLSxROWS counts inner corners; S is the square size in the unit wanted for poses.
+int runCalibration(int argc, char* argv[]) {
+    int cols = 0, rows = 0;
+    double square = 1.0;
+    const char* savePath = NULL;
+    std::vector<const char*> paths;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &cols, &rows) != 2) cols = rows = 0;
+        } else if (strcmp(argv[i], "--square") == 0 && i + 1 < argc) {
+            square = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            printf("Error: Unknown option '%s'\n", argv[i]);
             printUsage(argv[0]);
             return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (cols < 2 || rows < 2 || square <= 0.0 || paths.empty()) {
+        printf("Error: --calibrate needs --board COLSxROWS (inner corners, at least 2x2) and images\n");
+        printUsage(argv[0]);
+        return 1;
     }
 
+    std::vector<Image> images(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!readPNM(paths[i], images[i]))
+            return 1;
+        if (images[i].width != images[0].width || images[i].height != images[0].height) {
+            printf("Error: %s is %dx%d, expected %dx%d like the first image\n", paths[i],
+                   images[i].width, images[i].height, images[0].width, images[0].height);
+            return 1;
+        }
+    }
+
+    ThreadPool pool;
+    std::vector<CalibrationView> views;
+    double start = wallTimeMs();
+    int found = detectCalibrationCorners(images, cols, rows, views, &pool);
+    double detectMs = wallTimeMs() - start;
+    for (size_t i = 0; i < views.size(); i++)
+        if (!views[i].found) printf("No %dx%d board in %s, skipped\n", cols, rows, paths[i]);
+    printf("Board found in %d of %zu images (%.1f ms, %d threads)\n", found, paths.size(), detectMs, pool.size());
+
+    CalibrationResult result;
+    start = wallTimeMs();
+    if (!calibrateLens(views, cols, rows, square, images[0].width, images[0].height, result, &pool))
+        return 1;
+    printf("Solved in %d iterations (%.1f ms), RMS reprojection error %.4f px\n",
+           result.iterations, wallTimeMs() - start, result.rms);
+    printLensModel(result.lens);
+    if (savePath) {
+        if (!writeLensModel(savePath, result.lens, images[0].width, images[0].height))
+            return 1;
+        printf("Lens saved to %s (use with: ./main 8 --lens %s --input IMAGE)\n", savePath, savePath);
+    }
     return 0;
 }
 
-// Include activity implementations
+int main(int argc, char* argv[]) {
+    // Check if activity number is provided
+    if (argc < 2) {
+        printf("Error: Missing activity number\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "--bench") == 0)
+        return runBenchmark(argc, argv);
+    if (strcmp(argv[1], "--bench-cpu") == 0)
+        return runCpuBenchmark(argc, argv);
+    if (strcmp(argv[1], "--regress") == 0)
+        return runRegression(argc, argv);
+    if (strcmp(argv[1], "--calibrate") == 0)
+        return runCalibration(argc, argv);
+
+    // Parse activity numbers and render options
+    std::vector<const Activity*> activities;
+    int firstOption = parseActivityList(argc, argv, activities);
+    if (firstOption < 0) {
+        printf("Note: Activity 5 is not available in this assignment set\n\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (activities.empty()) {
+        printf("Error: Missing activity number\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!parseRenderOptions(argc, argv, firstOption)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Launch the requested activities
+    return launchActivities(activities, NULL) ? 0 : 1;
+}
+
+// Include activity implementations (make release-lto/pgo compiles them as
+// separate objects with -DSEPARATE_ACTIVITIES and links them instead)
+#ifndef SEPARATE_ACTIVITIES
 #include "src/activities/activity1_instalasi.cpp"
 #include "src/activities/activity2_clipping.cpp"
 #include "src/activities/activity3_color_interpolation.cpp"
@@ -114,3 +376,4 @@ int main(int argc, char* argv[]) {
 #include "src/activities/activity6_bola_rgb.cpp"
 #include "src/activities/activity7_satelite_duo.cpp"
 #include "src/activities/activity8_undistorted_cray.cpp"
+#endif
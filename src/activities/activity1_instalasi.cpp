@@ -1,4 +1,5 @@
 #include "../common/opengl_setup.h"
+#include "../common/activity_host.h"
 
 /*
  * Activity 1: Instalasi (Installation)
@@ -6,10 +7,21 @@
  * Based on: square.cpp by Sumanta Guha
  */
 
-void runActivity1() {
-    // Initialize OpenGL window (500x500 to match original example)
-    GLFWwindow* window = initializeOpenGL("square.cpp", 500, 500);
-    if (!window) return;
+namespace activity1 {
+
+// CPU version of the square shader for --renderer soft: projection, black
+void softSquareShader(const float attribs[][4], const float* const uniforms[],
+                      float position[4], float varying[SOFT_VARYINGS]) {
+    softTransform(uniforms[0], attribs[0], position);
+    varying[0] = varying[1] = varying[2] = 0.0f;
+    varying[3] = 1.0f;
+}
+
+// GL objects, created by init()
+static unsigned int VAO, VBO, shaderProgram;
+
+bool init(GLFWwindow* window) {
+    (void)window;  // Unused parameter
 
     // Set clear color to white (matching original example)
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -30,7 +42,6 @@ void runActivity1() {
     };
 
     // Create and bind VAO
-    unsigned int VAO, VBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
@@ -56,7 +67,7 @@ void runActivity1() {
         "   FragColor = vec4(0.0, 0.0, 0.0, 1.0);  // Black color\n"
         "}\0";
 
-    unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource, softSquareShader);
 
     // Create orthographic projection matrix (0-100 coordinate space)
     // This is equivalent to glOrtho(0.0, 100.0, 0.0, 100.0, -1.0, 1.0)
@@ -76,33 +87,43 @@ void runActivity1() {
     printf("A black square should appear on white background.\n");
     printf("Square position: (20, 20) to (80, 80) in 100x100 coordinate space\n");
     printf("Press ESC to close.\n");
+    return true;
+}
 
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        // Clear the screen to white
-        glClear(GL_COLOR_BUFFER_BIT);
+void render(GLFWwindow* window) {
+    (void)window;  // Unused parameter
 
-        // Render the square
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);  // Draw 6 vertices (2 triangles)
+    // Clear the screen to white
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT);
 
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
+    // Render the square
+    beginGpuSection("square");
+    glUseProgram(shaderProgram);
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);  // Draw 6 vertices (2 triangles)
+    endGpuSection();
+}
 
-    // Cleanup
+void shutdown() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
 }
-
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity1();
-    return 0;
+} // namespace activity1
+
+// 500x500 window to match original example
+const Activity ACTIVITY1 = {
+    1, "Instalasi", "square.cpp", 500, 500,
+    activity1::init, NULL, activity1::render, activity1::shutdown, NULL
+};
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY1) ? 0 : 1;
 }
 #endif
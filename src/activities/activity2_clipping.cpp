@@ -1,43 +1,97 @@
 #include "../common/opengl_setup.h"
+#include "../common/clipper.h"
+#include "../common/activity_host.h"
+#include <vector>
 
 /*
  * Activity 2: Clipping
  * Purpose: Demonstrate viewport clipping with a triangle
  * Based on: Experiment 2.6 - Triangle for dramatic clipping illustration
- * TODO: Implement Cohen-Sutherland or other clipping algorithms
+ *
+ * The triangle is clipped on the CPU (Sutherland-Hodgman, src/common/clipper.h)
+ * before upload. The default window is the glOrtho view volume; press C to
+ * cycle through user-defined convex windows, drawn as a gray outline.
  */
 
-void runActivity2() {
-    // Initialize OpenGL window
-    GLFWwindow* window = initializeOpenGL("square.cpp", 500, 500);
-    if (!window) return;
+namespace activity2 {
+// Clip window outlines as counter-clockwise (x, y) points
+struct ClipWindowShape {
+    const char* name;
+    int pointCount;
+    float points[CLIP_MAX_PLANES * 2];
+};
+
+const ClipWindowShape CLIP_SHAPES[] = {
+    { "View volume (0-100)", 4, { 0.0f, 0.0f, 100.0f, 0.0f, 100.0f, 100.0f, 0.0f, 100.0f } },
+    { "Rectangle", 4, { 40.0f, 20.0f, 90.0f, 20.0f, 90.0f, 60.0f, 40.0f, 60.0f } },
+    { "Hexagon", 6, { 55.0f, 20.0f, 76.7f, 32.5f, 76.7f, 57.5f, 55.0f, 70.0f, 33.3f, 57.5f, 33.3f, 32.5f } },
+    { "Diamond", 4, { 50.0f, 15.0f, 85.0f, 50.0f, 50.0f, 85.0f, 15.0f, 50.0f } }
+};
+const int CLIP_SHAPE_COUNT = sizeof(CLIP_SHAPES) / sizeof(CLIP_SHAPES[0]);
+
+static int clipShapeIndex = 0;
+static bool clipShapeChanged = true;
+
+// Keyboard callback: C cycles the clip window
+void activity2KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    (void)scancode;  // Unused parameter
+    (void)mods;      // Unused parameter
+    if (action == GLFW_PRESS) {
+        if (key == GLFW_KEY_C) {
+            clipShapeIndex = (clipShapeIndex + 1) % CLIP_SHAPE_COUNT;
+            clipShapeChanged = true;
+        } else if (key == GLFW_KEY_ESCAPE) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+    }
+}
+
+// Triangle vertices (Experiment 2.6): right triangle in 0-100 coordinate space,
+// only 3 vertices for a clearer clipping demonstration. Format: position (x, y, z)
+const float TRIANGLE[] = {
+    30.0f, 30.0f, 0.0f,  // Bottom-left
+    70.0f, 30.0f, 0.0f,  // Bottom-right
+    70.0f, 70.0f, 0.0f   // Top-right
+};
+
+// Clipped triangles (rebuilt when the clip window changes)
+static std::vector<float> clippedVertices;
+static int clippedVertexCount = 0;
+
+// GL objects, created by init()
+static unsigned int VAO, VBO, outlineVAO, outlineVBO, shaderProgram;
+static int colorLoc;
+
+bool init(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+    clipShapeIndex = 0;
+    clipShapeChanged = true;
 
     // Set clear color to white
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
-    // Vertex data: Right triangle in 0-100 coordinate space
-    // Using only 3 vertices for better clipping demonstration
-    // Format: position (x, y, z)
-    float vertices[] = {
-        // Triangle vertices (Experiment 2.6)
-        30.0f, 30.0f, 0.0f,  // Bottom-left
-        70.0f, 30.0f, 0.0f,  // Bottom-right
-        70.0f, 70.0f, 0.0f   // Top-right
-    };
+    clippedVertices.reserve(CLIP_MAX_POLY * 9);
+    clippedVertexCount = 0;
 
-    // Create and bind VAO
-    unsigned int VAO, VBO;
+    // Create VAOs: clipped triangle and clip window outline
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenVertexArrays(1, &outlineVAO);
+    glGenBuffers(1, &outlineVBO);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     // Position attribute (only position, no color per vertex)
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // Outline: (x, y) points of the current clip window
+    glBindVertexArray(outlineVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, outlineVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
     // Create custom shaders with orthographic projection
     const char* vertexShaderSource = "#version 410 core\n"
         "layout (location = 0) in vec3 aPos;\n"
@@ -48,11 +102,13 @@ void runActivity2() {
 
     const char* fragmentShaderSource = "#version 410 core\n"
         "out vec4 FragColor;\n"
+        "uniform vec4 color;\n"
         "void main() {\n"
-        "   FragColor = vec4(0.0, 0.0, 0.0, 1.0);  // Black color\n"
+        "   FragColor = color;\n"
         "}\0";
 
-    unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource,
+                                        softProjectedUniformColorShader);
 
     // Create orthographic projection matrix (0-100 coordinate space)
     // This is equivalent to glOrtho(0.0, 100.0, 0.0, 100.0, -1.0, 1.0)
@@ -66,41 +122,89 @@ void runActivity2() {
     // Set the projection matrix uniform
     glUseProgram(shaderProgram);
     int projLoc = glGetUniformLocation(shaderProgram, "projection");
+    colorLoc = glGetUniformLocation(shaderProgram, "color");
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, projectionMatrix);
 
     printf("Activity 2: Clipping\n");
     printf("A black right triangle should appear on white background.\n");
     printf("Triangle vertices: (30,30), (70,30), (70,70)\n");
     printf("Simpler geometry makes clipping behavior more obvious.\n");
-    printf("TODO: Implement Cohen-Sutherland or Liang-Barsky clipping algorithms\n");
-    printf("Press ESC to close.\n");
-
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        // Clear the screen to white
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // Render the triangle
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 3);  // Draw 3 vertices (1 triangle)
-
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    printf("The triangle is clipped on the CPU (Sutherland-Hodgman) before drawing.\n");
+    printf("Press C to cycle clip windows, ESC to close.\n");
+    return true;
+}
+
+// Re-clip only when the window changes
+void update(double deltaSeconds) {
+    (void)deltaSeconds;  // Unused parameter
+    if (!clipShapeChanged) return;
+
+    const ClipWindowShape& shape = CLIP_SHAPES[clipShapeIndex];
+    clipShapeChanged = false;
+    ClipWindow clipWindow;
+    if (!makeConvexClipWindow(shape.points, shape.pointCount, clipWindow)) {
+        fprintf(stderr, "Clip window %s is not a convex CCW polygon\n", shape.name);
+        return;
     }
+    ClipStats stats = clipTriangles(clipWindow, TRIANGLE, 1, clippedVertices);
+    clippedVertexCount = (int)clippedVertices.size() / 3;
 
-    // Cleanup
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, clippedVertices.size() * sizeof(float),
+                 clippedVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, outlineVBO);
+    glBufferData(GL_ARRAY_BUFFER, shape.pointCount * 2 * sizeof(float), shape.points, GL_STATIC_DRAW);
+
+    printf("Clip window: %s -> %s, %d output triangle(s)\n", shape.name,
+           stats.accepted ? "inside" : (stats.rejected ? "outside" : "clipped"),
+           clippedVertexCount / 3);
+}
+
+void render(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+
+    // Clear the screen to white
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Render the clipped triangle
+    beginGpuSection("triangle");
+    glUseProgram(shaderProgram);
+    glUniform4f(colorLoc, 0.0f, 0.0f, 0.0f, 1.0f);  // Black
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, clippedVertexCount);
+
+    // Outline user-defined clip windows (the view volume is the window edge)
+    if (clipShapeIndex != 0) {
+        beginGpuSection("clip outline");
+        glUniform4f(colorLoc, 0.6f, 0.6f, 0.6f, 1.0f);  // Gray
+        glBindVertexArray(outlineVAO);
+        glDrawArrays(GL_LINE_LOOP, 0, CLIP_SHAPES[clipShapeIndex].pointCount);
+    }
+    endGpuSection();
+}
+
+void shutdown() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &outlineVAO);
+    glDeleteBuffers(1, &outlineVBO);
     glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
 }
-
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity2();
-    return 0;
+} // namespace activity2
+
+const Activity ACTIVITY2 = {
+    2, "Clipping", "square.cpp", 500, 500,
+    activity2::init, activity2::update, activity2::render, activity2::shutdown,
+    activity2::activity2KeyCallback
+};
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY2) ? 0 : 1;
 }
 #endif
@@ -1,50 +1,105 @@
 #include "../common/opengl_setup.h"
+#include "../common/gradient_fill.h"
+#include "../common/vertex_format.h"
+#include "../common/activity_host.h"
+#include <vector>
 
 /*
  * Activity 3: Color Interpolation
  * Purpose: Demonstrate bilinear color interpolation across a square
  * Based on: Experiment 2.7 - Four-corner color gradient
  * Shows smooth color gradients using vertex colors and GPU rasterization
+ *
+ * The first frame (and any frame after pressing V) is checked pixel by pixel
+ * against a CPU fill of the same vertices (src/common/gradient_fill.h).
+ * The vertex buffer holds them packed as half-float x, y and RGBA8 color
+ * (src/common/vertex_format.h); corners and colors are exact in that form.
  */
 
-void runActivity3() {
-    // Initialize OpenGL window (500x500 square)
-    GLFWwindow* window = initializeOpenGL("square.cpp", 500, 500);
-    if (!window) return;
+static bool validateNextFrame = true;
+
+// Keyboard callback: V validates the next frame against the CPU reference
+void activity3KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    (void)scancode;  // Unused parameter
+    (void)mods;      // Unused parameter
+    if (action == GLFW_PRESS) {
+        if (key == GLFW_KEY_V) {
+            validateNextFrame = true;
+        } else if (key == GLFW_KEY_ESCAPE) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+    }
+}
 
-    // Set clear color to white
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+// Compare the frame just drawn with the CPU reference fill of the same vertices
+void validateActivity3Frame(GLFWwindow* window, const float* vertices, int vertexCount, const float* projection) {
+    int width, height;
+    getFramebufferSize(window, width, height);
+    std::vector<unsigned char> frame((size_t)width * height * 3);
+    std::vector<unsigned char> expected(frame.size(), 255);  // White clear color
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, frame.data());
+
+    std::vector<GradientVertex> windowVertices;
+    std::vector<GradientTriangle> triangles;
+    projectGradientVertices(vertices, 6, vertexCount, projection, width, height, windowVertices);
+    setupGradientTriangles(windowVertices, width, height, triangles);
+    fillGradientReference(triangles, width, expected.data());
+
+    int maxDiff;
+    size_t mismatches = compareRGB(frame.data(), expected.data(), (size_t)width * height, 1, maxDiff);
+    printf("Frame %d (%dx%d) vs CPU reference: max channel difference %d, %zu pixels differ by more than 1\n",
+           g_renderTarget.frameIndex, width, height, maxDiff, mismatches);
+}
 
-    // Vertex data: Square with different color at each corner
-    // Format: position (x, y, z), color (r, g, b)
-    float vertices[] = {
-        // First triangle (bottom-left, bottom-right, top-left)
-        20.0f, 20.0f, 0.0f,  1.0f, 0.0f, 0.0f,  // Bottom-left: Red
-        80.0f, 20.0f, 0.0f,  0.0f, 1.0f, 0.0f,  // Bottom-right: Green
-        20.0f, 80.0f, 0.0f,  1.0f, 1.0f, 0.0f,  // Top-left: Yellow
+namespace activity3 {
+// Square with a different color at each corner
+// Format: position (x, y, z), color (r, g, b)
+const float VERTICES[] = {
+    // First triangle (bottom-left, bottom-right, top-left)
+    20.0f, 20.0f, 0.0f,  1.0f, 0.0f, 0.0f,  // Bottom-left: Red
+    80.0f, 20.0f, 0.0f,  0.0f, 1.0f, 0.0f,  // Bottom-right: Green
+    20.0f, 80.0f, 0.0f,  1.0f, 1.0f, 0.0f,  // Top-left: Yellow
+
+    // Second triangle (bottom-right, top-right, top-left)
+    80.0f, 20.0f, 0.0f,  0.0f, 1.0f, 0.0f,  // Bottom-right: Green
+    80.0f, 80.0f, 0.0f,  0.0f, 0.0f, 1.0f,  // Top-right: Blue
+    20.0f, 80.0f, 0.0f,  1.0f, 1.0f, 0.0f   // Top-left: Yellow
+};
+
+// Orthographic projection matrix (0-100 coordinate space)
+const float PROJECTION[16] = {
+    2.0f/100.0f,  0.0f,          0.0f,  0.0f,
+    0.0f,         2.0f/100.0f,   0.0f,  0.0f,
+    0.0f,         0.0f,         -1.0f,  0.0f,
+   -1.0f,        -1.0f,          0.0f,  1.0f
+};
+
+// GL objects, created by init()
+static unsigned int VAO, VBO, shaderProgram;
+
+bool init(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+    validateNextFrame = true;
 
-        // Second triangle (bottom-right, top-right, top-left)
-        80.0f, 20.0f, 0.0f,  0.0f, 1.0f, 0.0f,  // Bottom-right: Green
-        80.0f, 80.0f, 0.0f,  0.0f, 0.0f, 1.0f,  // Top-right: Blue
-        20.0f, 80.0f, 0.0f,  1.0f, 1.0f, 0.0f   // Top-left: Yellow
-    };
+    // Set clear color to white
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
     // Create and bind VAO
-    unsigned int VAO, VBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    std::vector<PackedColorVertex> packed;
+    packColorVertices(VERTICES, 6, 6, packed);
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedColorVertex), packed.data(), GL_STATIC_DRAW);
 
     // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    setVertexAttribute(0, VERTEX_HALFx2, sizeof(PackedColorVertex), offsetof(PackedColorVertex, x));
 
     // Color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    setVertexAttribute(1, VERTEX_UNORM8x4, sizeof(PackedColorVertex), offsetof(PackedColorVertex, color));
 
     // Create shaders with orthographic projection
     const char* vertexShaderSource = "#version 410 core\n"
@@ -64,53 +119,59 @@ void runActivity3() {
         "   FragColor = vec4(vertexColor, 1.0);\n"
         "}\0";
 
-    unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
-
-    // Create orthographic projection matrix (0-100 coordinate space)
-    float projectionMatrix[16] = {
-        2.0f/100.0f,  0.0f,          0.0f,  0.0f,
-        0.0f,         2.0f/100.0f,   0.0f,  0.0f,
-        0.0f,         0.0f,         -1.0f,  0.0f,
-       -1.0f,        -1.0f,          0.0f,  1.0f
-    };
+    shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource,
+                                        softProjectedVertexColorShader);
 
     // Set the projection matrix uniform
     glUseProgram(shaderProgram);
     int projLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projectionMatrix);
+    glUniformMatrix4fv(projLoc, 1, GL_FALSE, PROJECTION);
 
     printf("Activity 3: Color Interpolation (Experiment 2.7)\n");
     printf("Demonstrating bilinear color interpolation across a square.\n");
     printf("Corner colors: Red (BL), Green (BR), Yellow (TL), Blue (TR)\n");
     printf("GPU automatically interpolates colors between vertices.\n");
-    printf("Press ESC to close.\n");
+    printf("Press V to check the next frame against the CPU reference, ESC to close.\n");
+    return true;
+}
 
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        // Clear the screen to white
-        glClear(GL_COLOR_BUFFER_BIT);
+void render(GLFWwindow* window) {
+    // Clear the screen to white
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT);
 
-        // Render the square with interpolated colors
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);  // Draw 6 vertices (2 triangles)
+    // Render the square with interpolated colors
+    beginGpuSection("square");
+    glUseProgram(shaderProgram);
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);  // Draw 6 vertices (2 triangles)
+    endGpuSection();  // Validation reads pixels back; keep it out of the timings
 
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (validateNextFrame) {
+        validateActivity3Frame(window, VERTICES, 6, PROJECTION);
+        validateNextFrame = false;
     }
+}
 
-    // Cleanup
+void shutdown() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
 }
-
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity3();
-    return 0;
+} // namespace activity3
+
+// 500x500 square window
+const Activity ACTIVITY3 = {
+    3, "Color Interpolation", "square.cpp", 500, 500,
+    activity3::init, NULL, activity3::render, activity3::shutdown, activity3KeyCallback
+};
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY3) ? 0 : 1;
 }
 #endif
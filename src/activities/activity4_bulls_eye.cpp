@@ -1,4 +1,7 @@
 #include "../common/opengl_setup.h"
+#include "../common/geometry.h"
+#include "../common/vertex_format.h"
+#include "../common/activity_host.h"
 #include <cmath>
 #include <vector>
 
@@ -11,57 +14,47 @@
  * 1. Upper left: Overwriting technique (white disc over red disc)
  * 2. Upper right: Depth testing (multi-colored bull's eye with depth testing)
  * 3. Lower: True ring using triangle strip (toggleable wireframe)
+ *
+ * All discs share one unit-disc buffer and are drawn with a single instanced
+ * call; each instance supplies center, depth, radius and color. --count N
+ * gives the upper right bull's eye N rings at the same draw-call cost.
+ * Segment counts follow the on-screen radius (src/common/geometry.h).
+ *
+ * Vertices are packed (src/common/vertex_format.h): the unit disc as snorm16
+ * x, y, the ring as snorm16 of its 0-100 coordinates / 100 with the 100 put
+ * back in its projection, and instance colors as RGBA8.
  */
 
-#define N 40.0  // Number of vertices on the boundary of the disc
-
-// Use system M_PI from <cmath>
-#ifndef M_PI
-#endif
-
 // Global state
 static bool isWire = false;  // Wireframe toggle for lower annulus
 
-// Vertex generation functions
-std::vector<float> generateDiscVertices(float radius, float centerX, float centerY, float centerZ) {
-    std::vector<float> vertices;
-
-    // Center vertex
-    vertices.push_back(centerX);
-    vertices.push_back(centerY);
-    vertices.push_back(centerZ);
-
-    // Boundary vertices (triangle fan)
-    for (int i = 0; i <= N; ++i) {
-        float t = 2.0f * M_PI * i / N;
-        vertices.push_back(centerX + cos(t) * radius);
-        vertices.push_back(centerY + sin(t) * radius);
-        vertices.push_back(centerZ);
-    }
-
-    return vertices;
-}
-
-std::vector<float> generateRingVertices(float innerRadius, float outerRadius,
-                                        float centerX, float centerY, float centerZ) {
-    std::vector<float> vertices;
-
-    // Triangle strip: alternating inner and outer vertices
-    for (int i = 0; i <= N; ++i) {
-        float angle = 2.0f * M_PI * i / N;
-
-        // Inner vertex
-        vertices.push_back(centerX + cos(angle) * innerRadius);
-        vertices.push_back(centerY + sin(angle) * innerRadius);
-        vertices.push_back(centerZ);
-
-        // Outer vertex
-        vertices.push_back(centerX + cos(angle) * outerRadius);
-        vertices.push_back(centerY + sin(angle) * outerRadius);
-        vertices.push_back(centerZ);
-    }
-
-    return vertices;
+// Per-instance disc: center (x, y), depth z, radius and color
+struct DiscInstance {
+    float x, y, z;
+    float radius;
+    PackedColor color;
+};
+
+const float SCENE_EXTENT = 100.0f;  // Ring positions are packed as a fraction of it
+
+// Bull's eye colors from the outside in, repeated for extra rings
+const float BULLS_EYE_COLORS[5][3] = {
+    { 0.0f, 1.0f, 0.0f },  // Green
+    { 1.0f, 0.0f, 0.0f },  // Red
+    { 0.0f, 0.0f, 1.0f },  // Blue
+    { 1.0f, 1.0f, 0.0f },  // Yellow
+    { 0.6f, 0.0f, 0.8f }   // Purple/Magenta
+};
+
+// CPU version of the instanced disc shader for --renderer soft
+void softBullsEyeDiscShader(const float attribs[][4], const float* const uniforms[],
+                            float position[4], float varying[SOFT_VARYINGS]) {
+    const float* unit = attribs[0];
+    const float* disc = attribs[1];  // x, y, z, radius
+    float world[4] = { disc[0] + unit[0] * disc[3], disc[1] + unit[1] * disc[3], disc[2], 1.0f };
+    softTransform(uniforms[0], world, position);
+    memcpy(varying, attribs[2], 3 * sizeof(float));
+    varying[3] = 1.0f;
 }
 
 // Keyboard callback for wireframe toggle
@@ -78,59 +71,96 @@ void activity4KeyCallback(GLFWwindow* window, int key, int scancode, int action,
     }
 }
 
-void runActivity4() {
-    // Initialize OpenGL window
-    GLFWwindow* window = initializeOpenGL("Activity 4: Circular Annuluses", 500, 500);
-    if (!window) return;
+namespace activity4 {
+// GL objects and draw counts, created by init()
+static unsigned int discVAO, discVBO, instanceVBO, ringVAO, ringVBO;
+static unsigned int shaderProgram, discProgram;
+static int discCount, discVertices, ringVertices;
 
-    // Set keyboard callback (override default to handle SPACE)
-    glfwSetKeyCallback(window, activity4KeyCallback);
+bool init(GLFWwindow* window) {
+    isWire = false;
 
     // Set clear color to white
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
-    // Enable depth testing capability (will enable/disable during rendering)
+    // Depth testing stays on for the whole frame. GL_LEQUAL lets a later
+    // instance at equal depth overwrite an earlier one (upper left technique).
     glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
 
-    // Generate vertex data for all geometry
-    // Upper left annulus (overwriting technique)
-    auto upperLeftRed = generateDiscVertices(20.0f, 25.0f, 75.0f, 0.0f);
-    auto upperLeftWhite = generateDiscVertices(10.0f, 25.0f, 75.0f, 0.0f);
+    // Segment count for the largest radius (20 units of the 0-100 view) on screen
+    int width, height;
+    getFramebufferSize(window, width, height);
+    int segments = circleSegmentsForRadius(projectedRadiusPixels(20.0f, 100.0f, width < height ? width : height));
 
-    // Upper right multi-colored bull's eye (depth testing technique)
-    // 5 concentric discs with different colors and z-values
-    auto bullsEyeGreen = generateDiscVertices(20.0f, 75.0f, 75.0f, 0.0f);    // Outermost - Green
-    auto bullsEyeRed = generateDiscVertices(16.0f, 75.0f, 75.0f, 0.1f);      // Red
-    auto bullsEyeBlue = generateDiscVertices(12.0f, 75.0f, 75.0f, 0.2f);     // Blue
-    auto bullsEyeYellow = generateDiscVertices(8.0f, 75.0f, 75.0f, 0.3f);    // Yellow
-    auto bullsEyePurple = generateDiscVertices(4.0f, 75.0f, 75.0f, 0.4f);    // Center - Purple
+    // Generate vertex data for all geometry, then pack it
+    // One unit disc shared by every disc instance
+    discVertices = discVertexCount(segments);
+    std::vector<float> vertices(discVertices * 3);
+    std::vector<int16_t> unitDisc, lowerRing;
+    writeDisc(vertices.data(), 3, segments, 0.0f, 0.0f, 0.0f, 1.0f);
+    packPositionsSnorm16(vertices.data(), 3, discVertices, 1.0f, unitDisc);
 
     // Lower annulus (true ring with triangle strip)
-    auto lowerRing = generateRingVertices(10.0f, 20.0f, 50.0f, 30.0f, 0.0f);
-
-    // Create VAO/VBO for each geometry (2 for upper left + 5 for bull's eye + 1 for lower = 8 total)
-    unsigned int VAOs[8], VBOs[8];
-    glGenVertexArrays(8, VAOs);
-    glGenBuffers(8, VBOs);
-
-    // Helper lambda to setup VAO/VBO
-    auto setupGeometry = [](unsigned int VAO, unsigned int VBO, const std::vector<float>& vertices) {
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-    };
+    ringVertices = ringVertexCount(segments);
+    vertices.resize(ringVertices * 3);
+    writeRing(vertices.data(), 3, segments, 50.0f, 30.0f, 0.0f, 10.0f, 20.0f);
+    packPositionsSnorm16(vertices.data(), 3, ringVertices, SCENE_EXTENT, lowerRing);
+
+    std::vector<DiscInstance> discs;
 
-    // Setup all geometry
-    setupGeometry(VAOs[0], VBOs[0], upperLeftRed);
-    setupGeometry(VAOs[1], VBOs[1], upperLeftWhite);
-    setupGeometry(VAOs[2], VBOs[2], bullsEyeGreen);
-    setupGeometry(VAOs[3], VBOs[3], bullsEyeRed);
-    setupGeometry(VAOs[4], VBOs[4], bullsEyeBlue);
-    setupGeometry(VAOs[5], VBOs[5], bullsEyeYellow);
-    setupGeometry(VAOs[6], VBOs[6], bullsEyePurple);
-    setupGeometry(VAOs[7], VBOs[7], lowerRing);
+    // Upper left annulus (overwriting technique): white drawn after red at the same depth
+    discs.push_back({ 25.0f, 75.0f, 0.0f, 20.0f, packColor(1.0f, 0.0f, 0.0f) });  // Red
+    discs.push_back({ 25.0f, 75.0f, 0.0f, 10.0f, packColor(1.0f, 1.0f, 1.0f) });  // White
+
+    // Upper right multi-colored bull's eye (depth testing technique)
+    // Concentric discs with shrinking radius and rising z (0.0 to 0.4)
+    int ringCount = g_renderOptions.count > 0 ? g_renderOptions.count : 5;
+    for (int i = 0; i < ringCount; i++) {
+        float radius = 20.0f * (ringCount - i) / ringCount;
+        float z = ringCount > 1 ? 0.4f * i / (ringCount - 1) : 0.0f;
+        const float* color = BULLS_EYE_COLORS[i % 5];
+        discs.push_back({ 75.0f, 75.0f, z, radius, packColor(color[0], color[1], color[2]) });
+    }
+    discCount = (int)discs.size();
+
+    // Disc VAO: unit disc + per-instance center/depth/radius/color
+    glGenVertexArrays(1, &discVAO);
+    glGenBuffers(1, &discVBO);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(discVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, discVBO);
+    glBufferData(GL_ARRAY_BUFFER, unitDisc.size() * sizeof(int16_t), unitDisc.data(), GL_STATIC_DRAW);
+    setVertexAttribute(0, VERTEX_SNORM16x2, VERTEX_SNORM16x2.bytes, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, discs.size() * sizeof(DiscInstance), discs.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(DiscInstance), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    setVertexAttribute(2, VERTEX_UNORM8x4, sizeof(DiscInstance), offsetof(DiscInstance, color));
+    glVertexAttribDivisor(2, 1);
+
+    // Ring VAO
+    glGenVertexArrays(1, &ringVAO);
+    glGenBuffers(1, &ringVBO);
+    glBindVertexArray(ringVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, ringVBO);
+    glBufferData(GL_ARRAY_BUFFER, lowerRing.size() * sizeof(int16_t), lowerRing.data(), GL_STATIC_DRAW);
+    setVertexAttribute(0, VERTEX_SNORM16x2, VERTEX_SNORM16x2.bytes, 0);
+
+    // Instanced disc shader: unit disc scaled by radius and moved to center/depth
+    const char* discVertexShaderSource = "#version 410 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 1) in vec4 aDisc;\n"
+        "layout (location = 2) in vec3 aColor;\n"
+        "uniform mat4 projection;\n"
+        "out vec3 vertexColor;\n"
+        "void main() {\n"
+        "   gl_Position = projection * vec4(aDisc.xy + aPos.xy * aDisc.w, aDisc.z, 1.0);\n"
+        "   vertexColor = aColor;\n"
+        "}\0";
 
     // Create shaders with uniform color
     const char* vertexShaderSource = "#version 410 core\n"
@@ -147,7 +177,10 @@ void runActivity4() {
         "   FragColor = color;\n"
         "}\0";
 
-    unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource,
+                                        softProjectedUniformColorShader);
+    discProgram = createShaderProgram(discVertexShaderSource, DEFAULT_FRAGMENT_SHADER,
+                                      softBullsEyeDiscShader);
 
     // Create orthographic projection matrix (0-100 coordinate space)
     float projectionMatrix[16] = {
@@ -157,15 +190,16 @@ void runActivity4() {
        -1.0f,        -1.0f,          0.0f,  1.0f
     };
 
-    // Set uniforms
-    glUseProgram(shaderProgram);
-    int projLoc = glGetUniformLocation(shaderProgram, "projection");
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projectionMatrix);
+    // The ring's packed positions are fractions of the scene extent
+    float ringMatrix[16];
+    scaleMatrixColumns(projectionMatrix, SCENE_EXTENT, ringMatrix);
 
-    // Store vertex counts
-    int discVertexCount = (int)upperLeftRed.size() / 3;
-    int ringVertexCount = (int)lowerRing.size() / 3;
+    // Set uniforms (they never change, so set once)
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, ringMatrix);
+    glUniform4f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 0.0f, 0.0f, 1.0f);  // Red
+    glUseProgram(discProgram);
+    glUniformMatrix4fv(glGetUniformLocation(discProgram, "projection"), 1, GL_FALSE, projectionMatrix);
 
     printf("\n=== Activity 4: Circular Annuluses ===\n");
     printf("Three techniques for drawing annuluses (ring shapes):\n\n");
@@ -175,9 +209,14 @@ void runActivity4() {
     printf("   - Simple but imprecise (overlapping geometry)\n\n");
     printf("2. UPPER RIGHT (75, 75) - 'Floating' Technique:\n");
     printf("   - Multi-colored bull's eye with depth testing\n");
-    printf("   - 5 concentric discs: Green -> Red -> Blue -> Yellow -> Purple\n");
+    printf("   - %d concentric discs: Green -> Red -> Blue -> Yellow -> Purple\n", ringCount);
     printf("   - Each at different z-depth (0.0 to 0.4)\n");
     printf("   - Demonstrates layered rendering\n\n");
+    printf("   All %d discs are drawn with one instanced call (%d segments each)\n",
+           discCount, segments);
+    printf("   Vertex data: %zu bytes packed, %zu as floats\n\n",
+           (unitDisc.size() + lowerRing.size()) * sizeof(int16_t) + discs.size() * sizeof(DiscInstance),
+           (size_t)(discVertices + ringVertices) * 3 * sizeof(float) + discs.size() * 7 * sizeof(float));
     printf("3. LOWER CENTER (50, 30) - 'The Real Deal' Technique:\n");
     printf("   - True ring using GL_TRIANGLE_STRIP\n");
     printf("   - Inner radius 10, outer radius 20\n");
@@ -185,88 +224,63 @@ void runActivity4() {
     printf("Controls:\n");
     printf("  SPACE - Toggle wireframe for lower annulus\n");
     printf("  ESC   - Close window\n\n");
+    return true;
+}
 
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        // Clear screen and depth buffer
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glUseProgram(shaderProgram);
-
-        // ===== UPPER LEFT: Overwriting technique (no depth test) =====
-        glDisable(GL_DEPTH_TEST);
-
-        // Red disc
-        glUniform4f(colorLoc, 1.0f, 0.0f, 0.0f, 1.0f);  // Red
-        glBindVertexArray(VAOs[0]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        // White disc (overwrites red)
-        glUniform4f(colorLoc, 1.0f, 1.0f, 1.0f, 1.0f);  // White
-        glBindVertexArray(VAOs[1]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        // ===== UPPER RIGHT: Multi-colored bull's eye with depth testing =====
-        glEnable(GL_DEPTH_TEST);
-
-        // Green disc (outermost) at z=0
-        glUniform4f(colorLoc, 0.0f, 1.0f, 0.0f, 1.0f);  // Green
-        glBindVertexArray(VAOs[2]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        // Red disc at z=0.1
-        glUniform4f(colorLoc, 1.0f, 0.0f, 0.0f, 1.0f);  // Red
-        glBindVertexArray(VAOs[3]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        // Blue disc at z=0.2
-        glUniform4f(colorLoc, 0.0f, 0.0f, 1.0f, 1.0f);  // Blue
-        glBindVertexArray(VAOs[4]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        // Yellow disc at z=0.3
-        glUniform4f(colorLoc, 1.0f, 1.0f, 0.0f, 1.0f);  // Yellow
-        glBindVertexArray(VAOs[5]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        // Purple disc (center) at z=0.4
-        glUniform4f(colorLoc, 0.6f, 0.0f, 0.8f, 1.0f);  // Purple/Magenta
-        glBindVertexArray(VAOs[6]);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, discVertexCount);
-
-        glDisable(GL_DEPTH_TEST);
-
-        // ===== LOWER: True ring with triangle strip =====
-        // Set polygon mode based on wireframe toggle
-        if (isWire) {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        } else {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        }
-
-        glUniform4f(colorLoc, 1.0f, 0.0f, 0.0f, 1.0f);  // Red
-        glBindVertexArray(VAOs[7]);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, ringVertexCount);
-
-        // Reset polygon mode
+void render(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+
+    // Clear screen and depth buffer
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // ===== UPPER LEFT + UPPER RIGHT: every disc in one instanced draw =====
+    beginGpuSection("discs");
+    glUseProgram(discProgram);
+    glBindVertexArray(discVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, discVertices, discCount);
+
+    // ===== LOWER: True ring with triangle strip =====
+    beginGpuSection("ring");
+    // Set polygon mode based on wireframe toggle
+    if (isWire) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    } else {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
     }
 
-    // Cleanup
-    glDeleteVertexArrays(8, VAOs);
-    glDeleteBuffers(8, VBOs);
+    glUseProgram(shaderProgram);
+    glBindVertexArray(ringVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, ringVertices);
+
+    // Reset polygon mode
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    endGpuSection();
+}
+
+void shutdown() {
+    glDeleteVertexArrays(1, &discVAO);
+    glDeleteBuffers(1, &discVBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteVertexArrays(1, &ringVAO);
+    glDeleteBuffers(1, &ringVBO);
     glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    glDeleteProgram(discProgram);
 }
+} // namespace activity4
+
+const Activity ACTIVITY4 = {
+    4, "Bull's Eye Target", "Activity 4: Circular Annuluses", 500, 500,
+    activity4::init, NULL, activity4::render, activity4::shutdown, activity4KeyCallback
+};
 
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity4();
-    return 0;
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY4) ? 0 : 1;
 }
 #endif
@@ -1,128 +1,392 @@
 #include "../common/opengl_setup.h"
+#include "../common/geometry.h"
+#include "../common/stream_buffer.h"
+#include "../common/vertex_format.h"
+#include "../common/activity_host.h"
 #include <cmath>
 #include <vector>
 
 /*
  * Activity 6: Bola Merah Kuning Biru (Red Yellow Blue Balls)
- * Purpose: Display three colored spheres/circles
- * TODO: Add 3D sphere rendering, lighting, and animation
+ * Purpose: Display three colored spheres, lit and gently bobbing
+ *
+ * Balls are instanced icospheres (src/common/geometry.h) with Blinn-Phong
+ * shading. One indexed mesh is built per level of detail at start-up; each
+ * frame the CPU culls balls against the view frustum, picks a level from each
+ * ball's on-screen radius and streams the survivors' center, radius and color
+ * (src/common/stream_buffer.h). Each level is then one instanced draw.
+ * Sphere vertices are packed 10:10:10:2 and instance colors RGBA8
+ * (src/common/vertex_format.h), so a streamed ball is 20 bytes.
+ *
+ * --count N replaces the three balls with a field of N balls that the camera
+ * circles through, e.g. ./main --bench 6 --count 100000.
  */
 
 namespace activity6 {
-const float PI = 3.14159265359f;
-
-// Generate vertices for a filled circle
-std::vector<float> generateCircle(float centerX, float centerY, float radius,
-                                   float r, float g, float b, int segments) {
-    std::vector<float> vertices;
-
-    // Center vertex
-    vertices.push_back(centerX);
-    vertices.push_back(centerY);
-    vertices.push_back(0.0f);
-    vertices.push_back(r);
-    vertices.push_back(g);
-    vertices.push_back(b);
-
-    // Generate circle vertices
-    for (int i = 0; i <= segments; i++) {
-        float angle = 2.0f * PI * float(i) / float(segments);
-        float x = centerX + radius * cos(angle);
-        float y = centerY + radius * sin(angle);
-
-        vertices.push_back(x);
-        vertices.push_back(y);
-        vertices.push_back(0.0f);
-        vertices.push_back(r);
-        vertices.push_back(g);
-        vertices.push_back(b);
-    }
+const char* BALL_VERTEX_SHADER = "#version 410 core\n"
+    "layout (location = 0) in vec3 aNormal;\n"        // Unit-sphere vertex, also its normal
+    "layout (location = 1) in vec4 aCenterRadius;\n"
+    "layout (location = 2) in vec3 aColor;\n"
+    "uniform mat4 uViewProjection;\n"
+    "out vec3 vNormal;\n"
+    "out vec3 vWorldPos;\n"
+    "out vec3 vColor;\n"
+    "void main() {\n"
+    "   vWorldPos = aCenterRadius.xyz + aNormal * aCenterRadius.w;\n"
+    "   vNormal = aNormal;\n"
+    "   vColor = aColor;\n"
+    "   gl_Position = uViewProjection * vec4(vWorldPos, 1.0);\n"
+    "}\0";
+
+// Blinn-Phong with one directional light (uLightDir points towards the light)
+const char* BALL_FRAGMENT_SHADER = "#version 410 core\n"
+    "in vec3 vNormal;\n"
+    "in vec3 vWorldPos;\n"
+    "in vec3 vColor;\n"
+    "uniform vec3 uLightDir;\n"
+    "uniform vec3 uCameraPos;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "   vec3 n = normalize(vNormal);\n"
+    "   vec3 h = normalize(uLightDir + normalize(uCameraPos - vWorldPos));\n"
+    "   float diffuse = max(dot(n, uLightDir), 0.0);\n"
+    "   float specular = diffuse > 0.0 ? pow(max(dot(n, h), 0.0), 48.0) : 0.0;\n"
+    "   FragColor = vec4(vColor * (0.15 + 0.85 * diffuse) + vec3(0.5 * specular), 1.0);\n"
+    "}\0";
+
+// Per-instance data, streamed as-is (location 1 = center + radius, 2 = RGBA8 color)
+struct Ball {
+    float x, y, z, radius;
+    PackedColor color;
+};
+
+const int LOD_COUNT = ICOSPHERE_MAX_SUBDIVISIONS + 1;  // Level = subdivision count
+
+// The three balls, left to right
+const float BALL_X[3] = { -0.7f, 0.0f, 0.7f };
+const float BALL_COLORS[3][3] = {
+    { 1.0f, 0.0f, 0.0f },  // Red
+    { 1.0f, 1.0f, 0.0f },  // Yellow
+    { 0.0f, 0.0f, 1.0f }   // Blue
+};
+const float BALL_RADIUS = 0.3f;
+const float BOB_HEIGHT = 0.08f;
+
+const float FIELD_SPACING = 1.8f;  // Average distance between --count balls
+const float FOV_Y = 45.0f * (float)M_PI / 180.0f;
+const float LIGHT_DIR[3] = { 0.39f, 0.69f, 0.61f };  // Unit length, upper right front
 
-    return vertices;
+// ---- Camera math (column-major, as GLSL expects) ----
+
+void multiplyMatrix(const float a[16], const float b[16], float out[16]) {
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            out[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] + a[8 + r] * b[c * 4 + 2] +
+                             a[12 + r] * b[c * 4 + 3];
 }
-} // namespace activity6
 
-void runActivity6() {
-    using namespace activity6;
-    // Initialize OpenGL window
-    GLFWwindow* window = initializeOpenGL("Activity 6: Bola Merah Kuning Biru", 900, 400);
-    if (!window) return;
+void perspectiveMatrix(float fovY, float aspect, float zNear, float zFar, float out[16]) {
+    float f = 1.0f / tanf(fovY * 0.5f);
+    memset(out, 0, 16 * sizeof(float));
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = (zFar + zNear) / (zNear - zFar);
+    out[11] = -1.0f;
+    out[14] = 2.0f * zFar * zNear / (zNear - zFar);
+}
 
-    // Set clear color
-    glClearColor(0.9f, 0.9f, 0.9f, 1.0f);
+// View matrix for an eye looking at target (y up); also returns the unit forward vector
+void lookAtMatrix(const float eye[3], const float target[3], float out[16], float forward[3]) {
+    float f[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+    float fl = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (int i = 0; i < 3; i++) f[i] /= fl;
+    float s[3] = { -f[2], 0.0f, f[0] };  // f x (0, 1, 0)
+    float sl = sqrtf(s[0] * s[0] + s[2] * s[2]);
+    s[0] /= sl;
+    s[2] /= sl;
+    float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+    const float m[16] = {
+        s[0], u[0], -f[0], 0.0f,
+        s[1], u[1], -f[1], 0.0f,
+        s[2], u[2], -f[2], 0.0f,
+        -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]),
+        -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]),
+        f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2], 1.0f
+    };
+    memcpy(out, m, sizeof(m));
+    memcpy(forward, f, sizeof(f));
+}
 
-    // Generate three circles
-    std::vector<float> allVertices;
+// The six frustum planes (a, b, c, d; inside when a*x + b*y + c*z + d >= 0)
+// of a view-projection matrix, normalized so d is a distance
+void frustumPlanes(const float m[16], float planes[6][4]) {
+    for (int p = 0; p < 6; p++) {
+        int row = p / 2;
+        float sign = (p & 1) ? -1.0f : 1.0f;
+        for (int c = 0; c < 4; c++)
+            planes[p][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+        float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        for (int c = 0; c < 4; c++) planes[p][c] /= length;
+    }
+}
 
-    // Red ball (left)
-    auto redBall = generateCircle(-0.6f, 0.0f, 0.3f, 1.0f, 0.0f, 0.0f, 50);
-    allVertices.insert(allVertices.end(), redBall.begin(), redBall.end());
+// CPU version of the ball program for --renderer soft: the same Blinn-Phong
+// terms, evaluated per vertex (the software renderer has no fragment shaders)
+void softBallShader(const float attribs[][4], const float* const uniforms[],
+                    float position[4], float varying[SOFT_VARYINGS]) {
+    const float* n = attribs[0];
+    const float* ball = attribs[1];
+    const float* light = uniforms[1];
+    const float* camera = uniforms[2];
+    float world[4] = { ball[0] + n[0] * ball[3], ball[1] + n[1] * ball[3], ball[2] + n[2] * ball[3], 1.0f };
+    softTransform(uniforms[0], world, position);
 
-    // Yellow ball (center)
-    auto yellowBall = generateCircle(0.0f, 0.0f, 0.3f, 1.0f, 1.0f, 0.0f, 50);
-    allVertices.insert(allVertices.end(), yellowBall.begin(), yellowBall.end());
+    float v[3] = { camera[0] - world[0], camera[1] - world[1], camera[2] - world[2] };
+    float vl = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    float h[3] = { light[0] + v[0] / vl, light[1] + v[1] / vl, light[2] + v[2] / vl };
+    float hl = sqrtf(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+    float diffuse = fmaxf(n[0] * light[0] + n[1] * light[1] + n[2] * light[2], 0.0f);
+    float specular = diffuse > 0.0f ? powf(fmaxf((n[0] * h[0] + n[1] * h[1] + n[2] * h[2]) / hl, 0.0f), 48.0f) : 0.0f;
+    for (int c = 0; c < 3; c++)
+        varying[c] = attribs[2][c] * (0.15f + 0.85f * diffuse) + 0.5f * specular;
+    varying[3] = 1.0f;
+}
 
-    // Blue ball (right)
-    auto blueBall = generateCircle(0.6f, 0.0f, 0.3f, 0.0f, 0.0f, 1.0f, 50);
-    allVertices.insert(allVertices.end(), blueBall.begin(), blueBall.end());
+// Scene, camera and GL objects, created by init()
+static std::vector<Ball> balls;
+static std::vector<Ball> lodBalls[LOD_COUNT];
+static double sceneTime;
+static float fieldHalfSize;  // 0 for the three-ball scene
+static float eye[3], viewProjection[16], forward[3];
+static unsigned int meshVBO, meshEBO, shaderProgram;
+static int viewProjectionLocation, lightDirLocation, cameraPosLocation;
+static unsigned int lodVAOs[LOD_COUNT];
+static int lodFirstIndex[LOD_COUNT];
+static StreamBuffer instanceStream;
+static double cullMs, visibleTotal, lodTotals[LOD_COUNT];
+static int cullFrames;
 
-    // Create and bind VAO
-    unsigned int VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+// N balls in a cube around the origin, red/yellow/blue with some variation
+void makeBallField(int count) {
+    fieldHalfSize = 0.5f * FIELD_SPACING * cbrtf((float)count);
+    balls.resize(count);
+    srand(6);
+    for (int i = 0; i < count; i++) {
+        Ball& ball = balls[i];
+        ball.x = fieldHalfSize * (2.0f * rand() / (float)RAND_MAX - 1.0f);
+        ball.y = fieldHalfSize * (2.0f * rand() / (float)RAND_MAX - 1.0f);
+        ball.z = fieldHalfSize * (2.0f * rand() / (float)RAND_MAX - 1.0f);
+        ball.radius = 0.15f + 0.2f * rand() / (float)RAND_MAX;
+        const float* color = BALL_COLORS[rand() % 3];
+        float shade = 0.75f + 0.25f * rand() / (float)RAND_MAX;
+        ball.color = packColor(color[0] * shade, color[1] * shade, color[2] * shade);
+    }
+}
+
+bool init(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+    glClearColor(0.9f, 0.9f, 0.9f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);  // Back faces are hidden anyway; the software renderer ignores this
+
+    // Scene
+    if (g_renderOptions.count > 0) {
+        makeBallField(g_renderOptions.count);
+    } else {
+        fieldHalfSize = 0.0f;
+        balls.resize(3);
+        for (int i = 0; i < 3; i++) {
+            Ball ball = { BALL_X[i], 0.0f, 0.0f, BALL_RADIUS,
+                          packColor(BALL_COLORS[i][0], BALL_COLORS[i][1], BALL_COLORS[i][2]) };
+            balls[i] = ball;
+        }
+    }
+    for (int l = 0; l < LOD_COUNT; l++) {
+        lodBalls[l].clear();
+        lodBalls[l].reserve(balls.size());
+        lodTotals[l] = 0.0;
+    }
+    sceneTime = 0.0;
+    cullMs = visibleTotal = 0.0;
+    cullFrames = 0;
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, allVertices.size() * sizeof(float),
-                 allVertices.data(), GL_STATIC_DRAW);
+    // One vertex and one index buffer holding every level of detail. The
+    // unit-sphere vertices are packed 10:10:10:2, 4 bytes instead of 12.
+    std::vector<float> levelVertices;
+    std::vector<uint32_t> vertices, levelPacked;
+    std::vector<uint16_t> indices, levelIndices;
+    int firstVertex[LOD_COUNT];
+    for (int l = 0; l < LOD_COUNT; l++) {
+        buildIcosphere(l, levelVertices, levelIndices);
+        packNormalsSnorm10(levelVertices.data(), 3, (int)levelVertices.size() / 3, levelPacked);
+        firstVertex[l] = (int)vertices.size();
+        lodFirstIndex[l] = (int)indices.size();
+        vertices.insert(vertices.end(), levelPacked.begin(), levelPacked.end());
+        indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+    }
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    glGenBuffers(1, &meshVBO);
+    glGenBuffers(1, &meshEBO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(uint32_t), vertices.data(), GL_STATIC_DRAW);
+    createStreamBuffer(instanceStream, balls.size() * sizeof(Ball) + LOD_COUNT * STREAM_BUFFER_ALIGNMENT);
 
-    // Color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // One VAO per level: its mesh vertices, the shared index buffer, and
+    // instance attributes pointed at the stream buffer each frame
+    glGenVertexArrays(LOD_COUNT, lodVAOs);
+    for (int l = 0; l < LOD_COUNT; l++) {
+        glBindVertexArray(lodVAOs[l]);
+        glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+        setVertexAttribute(0, VERTEX_SNORM10x3, VERTEX_SNORM10x3.bytes, firstVertex[l] * VERTEX_SNORM10x3.bytes);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+        if (l == 0)
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+    }
+    glBindVertexArray(0);
 
-    // Create shader program
-    unsigned int shaderProgram = createShaderProgram(DEFAULT_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER);
+    shaderProgram = createShaderProgram(BALL_VERTEX_SHADER, BALL_FRAGMENT_SHADER, softBallShader);
+    viewProjectionLocation = glGetUniformLocation(shaderProgram, "uViewProjection");
+    lightDirLocation = glGetUniformLocation(shaderProgram, "uLightDir");
+    cameraPosLocation = glGetUniformLocation(shaderProgram, "uCameraPos");
 
     printf("Activity 6: Bola Merah Kuning Biru\n");
-    printf("Displaying three colored balls: Red, Yellow, Blue\n");
-    printf("TODO: Add 3D sphere rendering, shading, or animations\n");
+    if (fieldHalfSize > 0.0f)
+        printf("Field of %zu lit balls, camera circling through it\n", balls.size());
+    else
+        printf("Three lit balls: Red, Yellow, Blue\n");
+    printf("Icosphere levels: %d to %d vertices, frustum culled on the CPU\n",
+           icosphereVertexCount(0), icosphereVertexCount(ICOSPHERE_MAX_SUBDIVISIONS));
+    printf("Mesh %zu bytes packed (%zu as floats), %zu bytes per ball instance\n",
+           vertices.size() * sizeof(uint32_t), vertices.size() * 3 * sizeof(float), sizeof(Ball));
     printf("Press ESC to close.\n");
+    return true;
+}
 
-    // Calculate vertices per circle
-    int segments = 50;
-    int verticesPerCircle = segments + 2;
+void update(double deltaSeconds) {
+    sceneTime += deltaSeconds;
+    if (fieldHalfSize > 0.0f) {
+        // Circle inside the field, looking across its center
+        float angle = (float)(sceneTime * 0.15);
+        float orbit = 0.5f * fieldHalfSize;
+        eye[0] = orbit * cosf(angle);
+        eye[1] = 0.2f * fieldHalfSize;
+        eye[2] = orbit * sinf(angle);
+    } else {
+        for (int i = 0; i < 3; i++)
+            balls[i].y = BOB_HEIGHT * sinf((float)(sceneTime * 2.0) + i * 2.0944f);  // Thirds of a cycle apart
+        eye[0] = 0.0f;
+        eye[1] = 0.3f;
+        eye[2] = 2.0f;
+    }
+}
 
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
+// Sort the balls inside the frustum into LOD buckets by on-screen radius
+void cullBalls(int viewportHeight) {
+    float planes[6][4];
+    frustumPlanes(viewProjection, planes);
+    float focalPixels = 0.5f * viewportHeight / tanf(FOV_Y * 0.5f);
 
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
+    // Level l is used while radius * focalPixels / depth <= its limit
+    float depthScale[LOD_COUNT];
+    for (int l = 0; l < LOD_COUNT; l++) {
+        depthScale[l] = focalPixels / icosphereMaxRadiusPixels(l);
+        lodBalls[l].clear();
+    }
+    for (size_t i = 0; i < balls.size(); i++) {
+        const Ball& ball = balls[i];
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++)
+            inside = planes[p][0] * ball.x + planes[p][1] * ball.y + planes[p][2] * ball.z + planes[p][3] >= -ball.radius;
+        if (!inside) continue;
 
-        // Draw three balls
-        for (int i = 0; i < 3; i++) {
-            glDrawArrays(GL_TRIANGLE_FAN, i * verticesPerCircle, verticesPerCircle);
-        }
+        float depth = (ball.x - eye[0]) * forward[0] + (ball.y - eye[1]) * forward[1] + (ball.z - eye[2]) * forward[2];
+        int level = 0;
+        while (level < ICOSPHERE_MAX_SUBDIVISIONS && ball.radius * depthScale[level] > depth) level++;
+        lodBalls[level].push_back(ball);
+    }
+}
+
+void render(GLFWwindow* window) {
+    int width, height;
+    getFramebufferSize(window, width, height);
+    float target[3] = { 0.0f, 0.0f, 0.0f };
+    float view[16], projection[16];
+    lookAtMatrix(eye, target, view, forward);
+    float zFar = fieldHalfSize > 0.0f ? 3.0f * fieldHalfSize : 10.0f;
+    perspectiveMatrix(FOV_Y, (float)width / height, 0.05f, zFar, projection);
+    multiplyMatrix(projection, view, viewProjection);
+
+    double start = wallTimeMs();
+    cullBalls(height);
+    cullMs += wallTimeMs() - start;
+    cullFrames++;
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    // Stream every level's instances, then one instanced draw per level
+    size_t offsets[LOD_COUNT];
+    beginStreamFrame(instanceStream);
+    for (int l = 0; l < LOD_COUNT; l++) {
+        offsets[l] = 0;
+        if (!lodBalls[l].empty())
+            streamWrite(instanceStream, lodBalls[l].data(), lodBalls[l].size() * sizeof(Ball), offsets[l]);
+        visibleTotal += lodBalls[l].size();
+        lodTotals[l] += lodBalls[l].size();
     }
+    commitStreamFrame(instanceStream);
 
-    // Cleanup
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    beginGpuSection("balls");
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, viewProjection);
+    glUniform3f(lightDirLocation, LIGHT_DIR[0], LIGHT_DIR[1], LIGHT_DIR[2]);
+    glUniform3f(cameraPosLocation, eye[0], eye[1], eye[2]);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceStream.vbo);
+    for (int l = 0; l < LOD_COUNT; l++) {
+        if (lodBalls[l].empty()) continue;
+        glBindVertexArray(lodVAOs[l]);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Ball), (void*)offsets[l]);
+        pointVertexAttribute(2, VERTEX_UNORM8x4, sizeof(Ball), offsets[l] + offsetof(Ball, color));
+        glDrawElementsInstanced(GL_TRIANGLES, icosphereIndexCount(l), GL_UNSIGNED_SHORT,
+                                (void*)(lodFirstIndex[l] * sizeof(uint16_t)), (GLsizei)lodBalls[l].size());
+    }
+    endGpuSection();
+}
+
+void shutdown() {
+    if (cullFrames > 0) {
+        printf("Visible balls per frame: %.0f of %zu (by level:", visibleTotal / cullFrames, balls.size());
+        for (int l = 0; l < LOD_COUNT; l++) printf(" %.0f", lodTotals[l] / cullFrames);
+        printf("), culling %.3f ms/frame\n", cullMs / cullFrames);
+    }
+    printStreamBufferStats(instanceStream, "Ball instances");
+    destroyStreamBuffer(instanceStream);
+    glDeleteVertexArrays(LOD_COUNT, lodVAOs);
+    glDeleteBuffers(1, &meshVBO);
+    glDeleteBuffers(1, &meshEBO);
     glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    glDisable(GL_CULL_FACE);
+    std::vector<Ball>().swap(balls);
+    for (int l = 0; l < LOD_COUNT; l++) std::vector<Ball>().swap(lodBalls[l]);
 }
+} // namespace activity6
 
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity6();
-    return 0;
+const Activity ACTIVITY6 = {
+    6, "Bola Merah Kuning Biru", "Activity 6: Bola Merah Kuning Biru", 900, 400,
+    activity6::init, activity6::update, activity6::render, activity6::shutdown, NULL
+};
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY6) ? 0 : 1;
 }
 #endif
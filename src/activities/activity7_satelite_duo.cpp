@@ -1,4 +1,10 @@
 #include "../common/opengl_setup.h"
+#include "../common/orbit_swarm.h"
+#include "../common/geometry.h"
+#include "../common/stream_buffer.h"
+#include "../common/disc_impostor.h"
+#include "../common/vertex_format.h"
+#include "../common/activity_host.h"
 #include <cmath>
 #include <vector>
 
@@ -6,187 +12,348 @@
  * Activity 7: Satelite Duo (Satellite Duo)
  * Purpose: Simulate orbital motion with two satellites
  * Demonstrates animation and circular motion
+ *
+ * The planet and satellites share one mesh that is uploaded once and are
+ * drawn with a single instanced call; each instance supplies its own center,
+ * radius and color. Per frame only the instance centers change; they are
+ * streamed through a triple-buffered, fenced ring (src/common/stream_buffer.h)
+ * instead of re-uploading a buffer in use. Swarm satellites are a second
+ * instanced call.
+ *
+ * Discs and orbit paths are anti-aliased quad impostors
+ * (src/common/disc_impostor.h); the orbits are rings 1.5 pixels wide centered
+ * on the planet. The software renderer draws tessellated fans and line loops
+ * instead, with segment counts from on-screen radius (src/common/geometry.h).
+ * Mesh and orbit vertices are snorm16 x, y and styles carry RGBA8 colors
+ * (src/common/vertex_format.h); the orbit color is one constant attribute
+ * value per draw rather than a per-vertex array.
+ *
+ * Motion comes from the orbit swarm simulation (src/common/orbit_swarm.h),
+ * stepped at a fixed 240 Hz regardless of frame rate. --count N adds N
+ * satellites on random elliptical orbits.
  */
 
 namespace activity7 {
-const float PI = 3.14159265359f;
-
-// Generate vertices for a filled circle
-std::vector<float> generateCircle(float centerX, float centerY, float radius,
-                                   float r, float g, float b, int segments) {
-    std::vector<float> vertices;
-
-    vertices.push_back(centerX);
-    vertices.push_back(centerY);
-    vertices.push_back(0.0f);
-    vertices.push_back(r);
-    vertices.push_back(g);
-    vertices.push_back(b);
-
-    for (int i = 0; i <= segments; i++) {
-        float angle = 2.0f * PI * float(i) / float(segments);
-        float x = centerX + radius * cos(angle);
-        float y = centerY + radius * sin(angle);
-
-        vertices.push_back(x);
-        vertices.push_back(y);
-        vertices.push_back(0.0f);
-        vertices.push_back(r);
-        vertices.push_back(g);
-        vertices.push_back(b);
+// Per-instance disc shader: unit circle scaled by radius and moved to center.
+// Center x and y come from separate buffers so the swarm's SoA arrays upload as-is.
+const char* DISC_VERTEX_SHADER = "#version 410 core\n"
+    "layout (location = 0) in vec3 aUnit;\n"
+    "layout (location = 1) in float aCenterX;\n"
+    "layout (location = 2) in float aCenterY;\n"
+    "layout (location = 3) in float aRadius;\n"
+    "layout (location = 4) in vec3 aColor;\n"
+    "out vec3 vertexColor;\n"
+    "void main() {\n"
+    "   gl_Position = vec4(vec2(aCenterX, aCenterY) + aUnit.xy * aRadius, 0.0, 1.0);\n"
+    "   vertexColor = aColor;\n"
+    "}\0";
+
+// Impostor version: the same instance layout, with a quad corner for the mesh
+const char* DISC_IMPOSTOR_VERTEX_SHADER = "#version 410 core\n"
+    "layout (location = 0) in vec2 aCorner;\n"
+    "layout (location = 1) in float aCenterX;\n"
+    "layout (location = 2) in float aCenterY;\n"
+    "layout (location = 3) in float aRadius;\n"
+    "layout (location = 4) in vec3 aColor;\n"
+    "layout (location = 5) in float aInner;\n"
+    "uniform vec2 uPixelSize;\n"      // One pixel in NDC
+    "out vec2 vLocal;\n"
+    "flat out float vInner;\n"
+    "out vec3 vertexColor;\n"
+    "void main() {\n"
+    "   vec2 extent = vec2(aRadius) + uPixelSize;\n"
+    "   gl_Position = vec4(vec2(aCenterX, aCenterY) + aCorner * extent, 0.0, 1.0);\n"
+    "   vLocal = aCorner * extent / aRadius;\n"
+    "   vInner = aInner;\n"
+    "   vertexColor = aColor;\n"
+    "}\0";
+
+// Static per-instance data (radius, color, inner radius / radius)
+struct DiscStyle {
+    float radius;
+    PackedColor color;
+    float inner;
+};
+
+// Central body strength: GM = w^2 r^3 with the original 1.2 rad/s at r = 0.5
+const float PLANET_GM = 0.18f;
+const double SIM_STEP = 1.0 / 240.0;
+
+const float ORBIT_RADII[2] = { 0.5f, 0.7f };
+const float ORBIT_COLOR[3] = { 0.3f, 0.3f, 0.4f };
+const float ORBIT_WIDTH_PIXELS = 1.5f;
+const int BODY_COUNT = 3;  // Planet + two satellites; the swarm follows
+
+// CPU version of DISC_VERTEX_SHADER for --renderer soft
+void softDiscShader(const float attribs[][4], const float* const uniforms[],
+                    float position[4], float varying[SOFT_VARYINGS]) {
+    (void)uniforms;
+    float radius = attribs[3][0];
+    position[0] = attribs[1][0] + attribs[0][0] * radius;
+    position[1] = attribs[2][0] + attribs[0][1] * radius;
+    position[2] = 0.0f;
+    position[3] = 1.0f;
+    memcpy(varying, attribs[4], 3 * sizeof(float));
+    varying[3] = 1.0f;
+}
+
+// Simulation, instance data sizes and GL objects, created by init()
+static OrbitSwarm swarm;
+static ThreadPool* pool = NULL;
+static FixedTimestep timestep;
+static bool impostors;
+static int swarmCount, bodyVertexCount, swarmFirstVertex, swarmVertexCount, orbitCount;
+static size_t centerBytes;
+static unsigned int orbitVAO, orbitVBO, meshVBO, styleVBO;
+static StreamBuffer centerStream;
+static unsigned int discVAOs[2];
+static unsigned int shaderProgram, discProgram;
+static int pixelSizeLoc;
+
+bool init(GLFWwindow* window) {
+    // Set clear color
+    glClearColor(0.05f, 0.05f, 0.15f, 1.0f);
+
+    // Segment counts from on-screen radius (NDC spans the window)
+    int width, height;
+    getFramebufferSize(window, width, height);
+    int pixelsAcross = width < height ? width : height;
+    int bodySegments = circleSegmentsForRadius(projectedRadiusPixels(0.15f, 2.0f, pixelsAcross));
+    int swarmSegments = circleSegmentsForRadius(projectedRadiusPixels(0.006f, 2.0f, pixelsAcross));
+    int orbitSegments = circleSegmentsForRadius(projectedRadiusPixels(ORBIT_RADII[1], 2.0f, pixelsAcross));
+
+    // Disc mesh: one impostor quad, or unit discs packed into one buffer
+    // (planet/satellites, then swarm)
+    impostors = useDiscImpostors();
+    std::vector<int16_t> mesh;
+    if (impostors) {
+        packPositionsSnorm16(DISC_IMPOSTOR_QUAD, 2, DISC_IMPOSTOR_VERTICES, 1.0f, mesh);
+        bodyVertexCount = swarmVertexCount = DISC_IMPOSTOR_VERTICES;
+        swarmFirstVertex = 0;
+    } else {
+        bodyVertexCount = discVertexCount(bodySegments);
+        swarmVertexCount = discVertexCount(swarmSegments);
+        swarmFirstVertex = bodyVertexCount;
+        std::vector<float> discs((bodyVertexCount + swarmVertexCount) * 3);
+        writeDisc(&discs[0], 3, bodySegments, 0.0f, 0.0f, 0.0f, 1.0f);
+        writeDisc(&discs[bodyVertexCount * 3], 3, swarmSegments, 0.0f, 0.0f, 0.0f, 1.0f);
+        packPositionsSnorm16(discs.data(), 3, bodyVertexCount + swarmVertexCount, 1.0f, mesh);
     }
 
-    return vertices;
-}
+    // Tessellated orbit paths, packed into one static buffer (positions only,
+    // the color is set per draw)
+    orbitCount = circleOutlineVertexCount(orbitSegments);
+    std::vector<int16_t> orbitVertices;
+    if (!impostors) {
+        std::vector<float> orbits(2 * orbitCount * 3);
+        for (int i = 0; i < 2; i++)
+            writeCircleOutline(&orbits[i * orbitCount * 3], 3, orbitSegments, 0.0f, 0.0f, 0.0f, ORBIT_RADII[i]);
+        packPositionsSnorm16(orbits.data(), 3, 2 * orbitCount, 1.0f, orbitVertices);
+    }
 
-// Generate vertices for an orbit path (circle outline)
-std::vector<float> generateOrbitPath(float centerX, float centerY, float radius,
-                                      float r, float g, float b, int segments) {
-    std::vector<float> vertices;
-
-    for (int i = 0; i <= segments; i++) {
-        float angle = 2.0f * PI * float(i) / float(segments);
-        float x = centerX + radius * cos(angle);
-        float y = centerY + radius * sin(angle);
-
-        vertices.push_back(x);
-        vertices.push_back(y);
-        vertices.push_back(0.0f);
-        vertices.push_back(r);
-        vertices.push_back(g);
-        vertices.push_back(b);
+    // Body 0 is the planet, then the two satellites, then the optional swarm
+    swarmCount = g_renderOptions.count;
+    initOrbitSwarm(swarm, PLANET_GM, BODY_COUNT + swarmCount);
+    addStaticBody(swarm, 0.0f, 0.0f);
+    addOrbitingBody(swarm, ORBIT_RADII[0], 0.0f, 0.0f, 0.0f);  // Satellite 1: inner, faster
+    addOrbitingBody(swarm, ORBIT_RADII[1], 0.0f, 0.0f, 0.0f);  // Satellite 2: outer, slower
+    addRandomOrbits(swarm, swarmCount, 0.2f, 0.95f, 0.6f, 7);
+
+    // Instance styles follow the body order
+    std::vector<DiscStyle> discStyles;
+    discStyles.reserve(swarmSize(swarm) + 2);
+    discStyles.push_back({ 0.15f, packColor(1.0f, 0.8f, 0.0f), 0.0f });  // Planet (gold)
+    discStyles.push_back({ 0.05f, packColor(0.0f, 1.0f, 1.0f), 0.0f });  // Satellite 1 (cyan)
+    discStyles.push_back({ 0.05f, packColor(1.0f, 0.0f, 1.0f), 0.0f });  // Satellite 2 (magenta)
+    for (int i = 0; i < swarmCount; i++) {
+        float t = rand() / (float)RAND_MAX;
+        discStyles.push_back({ 0.006f, packColor(t, 1.0f - 0.5f * t, 1.0f), 0.0f });  // Cyan..violet
+    }
+    int instanceCount = (int)discStyles.size();
+    centerBytes = instanceCount * sizeof(float);
+
+    // Impostor orbit rings follow the bodies: ORBIT_WIDTH_PIXELS wide, centered on the path
+    float halfWidth = 0.5f * ORBIT_WIDTH_PIXELS * 2.0f / pixelsAcross;
+    for (int i = 0; i < 2; i++) {
+        float outer = ORBIT_RADII[i] + halfWidth;
+        discStyles.push_back({ outer, packColor(ORBIT_COLOR[0], ORBIT_COLOR[1], ORBIT_COLOR[2]),
+                               (ORBIT_RADII[i] - halfWidth) / outer });
     }
 
-    return vertices;
-}
-} // namespace activity7
+    pool = new ThreadPool();
+    timestep = makeFixedTimestep(SIM_STEP);
 
-void runActivity7() {
-    using namespace activity7;
-    // Initialize OpenGL window
-    GLFWwindow* window = initializeOpenGL("Activity 7: Satelite Duo", 800, 800);
-    if (!window) return;
+    // Disc buffers: mesh + per-instance center/radius/color
+    glGenBuffers(1, &meshVBO);
+    glGenBuffers(1, &styleVBO);
+    createStreamBuffer(centerStream, 2 * centerBytes + STREAM_BUFFER_ALIGNMENT);
 
-    // Set clear color
-    glClearColor(0.05f, 0.05f, 0.15f, 1.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(int16_t), mesh.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, styleVBO);
+    glBufferData(GL_ARRAY_BUFFER, discStyles.size() * sizeof(DiscStyle), discStyles.data(), GL_STATIC_DRAW);
 
-    // Central planet vertices (static)
-    auto planet = generateCircle(0.0f, 0.0f, 0.15f, 1.0f, 0.8f, 0.0f, 30);
-
-    // Orbit paths
-    auto orbit1Path = generateOrbitPath(0.0f, 0.0f, 0.5f, 0.3f, 0.3f, 0.4f, 100);
-    auto orbit2Path = generateOrbitPath(0.0f, 0.0f, 0.7f, 0.3f, 0.3f, 0.4f, 100);
-
-    // Create VAOs and VBOs for static objects
-    unsigned int planetVAO, planetVBO;
-    glGenVertexArrays(1, &planetVAO);
-    glGenBuffers(1, &planetVBO);
-    glBindVertexArray(planetVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, planetVBO);
-    glBufferData(GL_ARRAY_BUFFER, planet.size() * sizeof(float), planet.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // VAO for orbit paths
-    unsigned int orbitVAO, orbitVBO;
-    glGenVertexArrays(1, &orbitVAO);
-    glGenBuffers(1, &orbitVBO);
+    // One VAO per instance group, starting its styles at firstStyle. Centers are
+    // pointed at the stream buffer every frame (pointDiscCenters); centerDivisor
+    // lets several instances share one center.
+    auto setupDiscGroup = [&](unsigned int VAO, int firstStyle, int centerDivisor) {
+        size_t styleOffset = firstStyle * sizeof(DiscStyle);
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+        setVertexAttribute(0, VERTEX_SNORM16x2, VERTEX_SNORM16x2.bytes, 0);
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, centerDivisor);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, centerDivisor);
+
+        glBindBuffer(GL_ARRAY_BUFFER, styleVBO);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(DiscStyle), (void*)styleOffset);
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+        setVertexAttribute(4, VERTEX_UNORM8x4, sizeof(DiscStyle), styleOffset + offsetof(DiscStyle, color));
+        glVertexAttribDivisor(4, 1);
+        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(DiscStyle), (void*)(styleOffset + offsetof(DiscStyle, inner)));
+        glEnableVertexAttribArray(5);
+        glVertexAttribDivisor(5, 1);
+    };
+
+    glGenVertexArrays(2, discVAOs);
+    setupDiscGroup(discVAOs[0], 0, 1);
+    setupDiscGroup(discVAOs[1], BODY_COUNT, 1);
 
-    // VAO for satellites (dynamic)
-    unsigned int satelliteVAO, satelliteVBO;
-    glGenVertexArrays(1, &satelliteVAO);
-    glGenBuffers(1, &satelliteVBO);
+    glGenVertexArrays(1, &orbitVAO);
+    orbitVBO = 0;  // Only the line loops have vertices
+    if (impostors) {
+        // Orbit rings: both instances read the first center, the planet's
+        setupDiscGroup(orbitVAO, instanceCount, 2);
+    } else {
+        // Orbit line loops (static positions; color attribute 1 stays disabled
+        // and takes its value from glVertexAttrib3f at draw time)
+        glGenBuffers(1, &orbitVBO);
+        glBindVertexArray(orbitVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, orbitVBO);
+        glBufferData(GL_ARRAY_BUFFER, orbitVertices.size() * sizeof(int16_t), orbitVertices.data(), GL_STATIC_DRAW);
+        setVertexAttribute(0, VERTEX_SNORM16x2, VERTEX_SNORM16x2.bytes, 0);
+    }
 
-    // Create shader program
-    unsigned int shaderProgram = createShaderProgram(DEFAULT_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER);
+    // Create shader programs; the line program only draws the orbit line loops
+    shaderProgram = 0;
+    if (impostors) {
+        discProgram = createShaderProgram(DISC_IMPOSTOR_VERTEX_SHADER, DISC_IMPOSTOR_FRAGMENT_SHADER, NULL);
+        pixelSizeLoc = glGetUniformLocation(discProgram, "uPixelSize");
+        beginDiscImpostors();
+    } else {
+        shaderProgram = createShaderProgram(DEFAULT_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER, softVertexColorShader);
+        discProgram = createShaderProgram(DISC_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER, softDiscShader);
+    }
 
-    glLineWidth(1.5f);
+    glLineWidth(ORBIT_WIDTH_PIXELS);
 
     printf("Activity 7: Satelite Duo\n");
     printf("Two satellites orbiting a central planet\n");
     printf("Satellite 1 (Cyan): Inner orbit, faster\n");
     printf("Satellite 2 (Magenta): Outer orbit, slower\n");
+    if (swarmCount > 0)
+        printf("Swarm: %d satellites on elliptical orbits (%d threads)\n", swarmCount, pool->size());
+    if (impostors)
+        printf("Discs and orbits: anti-aliased quad impostors (%d vertices each)\n", DISC_IMPOSTOR_VERTICES);
+    else
+        printf("Disc segments: %d (planet/satellites), %d (swarm)\n", bodySegments, swarmSegments);
     printf("Press ESC to close.\n");
+    return true;
+}
 
-    float angle1 = 0.0f;
-    float angle2 = 0.0f;
-    float speed1 = 1.0f;
-    float speed2 = 0.6f;
+// Point a disc group's center attributes at this frame's streamed x and y arrays
+void pointDiscCenters(unsigned int VAO, int firstInstance, size_t xOffset, size_t yOffset) {
+    size_t skip = firstInstance * sizeof(float);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, centerStream.vbo);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(xOffset + skip));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(yOffset + skip));
+}
 
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
+// Advance the simulation in fixed steps for the time this frame covers
+void update(double deltaSeconds) {
+    int steps = consumeTimestep(timestep, deltaSeconds);
+    advanceOrbitSwarm(swarm, steps, (float)SIM_STEP, pool);
+}
 
+void render(GLFWwindow* window) {
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    size_t xOffset = 0, yOffset = 0;
+    beginStreamFrame(centerStream);
+    streamWrite(centerStream, swarm.x.data(), centerBytes, xOffset);
+    streamWrite(centerStream, swarm.y.data(), centerBytes, yOffset);
+    commitStreamFrame(centerStream);
+    pointDiscCenters(discVAOs[0], 0, xOffset, yOffset);
+    if (swarmCount > 0) pointDiscCenters(discVAOs[1], BODY_COUNT, xOffset, yOffset);
+
+    // Draw orbit paths
+    beginGpuSection("orbits");
+    GLenum discMode = GL_TRIANGLE_FAN;
+    if (impostors) {
+        int width, height;
+        getFramebufferSize(window, width, height);
+        discMode = GL_TRIANGLE_STRIP;
+        pointDiscCenters(orbitVAO, 0, xOffset, yOffset);
+        glUseProgram(discProgram);
+        glUniform2f(pixelSizeLoc, 2.0f / width, 2.0f / height);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, DISC_IMPOSTOR_VERTICES, 2);
+    } else {
         glUseProgram(shaderProgram);
-
-        // Draw orbit paths
         glBindVertexArray(orbitVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, orbitVBO);
-
-        // Orbit 1
-        glBufferData(GL_ARRAY_BUFFER, orbit1Path.size() * sizeof(float), orbit1Path.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glDrawArrays(GL_LINE_LOOP, 0, orbit1Path.size() / 6);
-
-        // Orbit 2
-        glBufferData(GL_ARRAY_BUFFER, orbit2Path.size() * sizeof(float), orbit2Path.data(), GL_STATIC_DRAW);
-        glDrawArrays(GL_LINE_LOOP, 0, orbit2Path.size() / 6);
-
-        // Draw central planet
-        glBindVertexArray(planetVAO);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, planet.size() / 6);
-
-        // Calculate satellite positions
-        float sat1X = 0.5f * cos(angle1);
-        float sat1Y = 0.5f * sin(angle1);
-        auto satellite1 = generateCircle(sat1X, sat1Y, 0.05f, 0.0f, 1.0f, 1.0f, 30);
-
-        float sat2X = 0.7f * cos(angle2);
-        float sat2Y = 0.7f * sin(angle2);
-        auto satellite2 = generateCircle(sat2X, sat2Y, 0.05f, 1.0f, 0.0f, 1.0f, 30);
-
-        // Draw satellites
-        glBindVertexArray(satelliteVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, satelliteVBO);
-
-        glBufferData(GL_ARRAY_BUFFER, satellite1.size() * sizeof(float), satellite1.data(), GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, satellite1.size() / 6);
-
-        glBufferData(GL_ARRAY_BUFFER, satellite2.size() * sizeof(float), satellite2.data(), GL_DYNAMIC_DRAW);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, satellite2.size() / 6);
-
-        // Update angles
-        angle1 += speed1 * 0.02f;
-        angle2 += speed2 * 0.02f;
+        glVertexAttrib3f(1, ORBIT_COLOR[0], ORBIT_COLOR[1], ORBIT_COLOR[2]);
+        glDrawArrays(GL_LINE_LOOP, 0, orbitCount);
+        glDrawArrays(GL_LINE_LOOP, orbitCount, orbitCount);
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    // Draw planet and satellites in one instanced call, the swarm in another
+    beginGpuSection("planet+satellites");
+    glUseProgram(discProgram);
+    glBindVertexArray(discVAOs[0]);
+    glDrawArraysInstanced(discMode, 0, bodyVertexCount, BODY_COUNT);
+    if (swarmCount > 0) {
+        beginGpuSection("swarm");
+        glBindVertexArray(discVAOs[1]);
+        glDrawArraysInstanced(discMode, swarmFirstVertex, swarmVertexCount, swarmCount);
     }
+    endGpuSection();
+}
 
-    // Cleanup
-    glDeleteVertexArrays(1, &planetVAO);
-    glDeleteBuffers(1, &planetVBO);
+void shutdown() {
     glDeleteVertexArrays(1, &orbitVAO);
-    glDeleteBuffers(1, &orbitVBO);
-    glDeleteVertexArrays(1, &satelliteVAO);
-    glDeleteBuffers(1, &satelliteVBO);
-    glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (orbitVBO) glDeleteBuffers(1, &orbitVBO);
+    orbitVBO = 0;
+    glDeleteVertexArrays(2, discVAOs);
+    glDeleteBuffers(1, &meshVBO);
+    glDeleteBuffers(1, &styleVBO);
+    printStreamBufferStats(centerStream, "Instance centers");
+    destroyStreamBuffer(centerStream);
+    if (shaderProgram) glDeleteProgram(shaderProgram);
+    shaderProgram = 0;
+    glDeleteProgram(discProgram);
+    glDisable(GL_BLEND);
+    delete pool;
+    pool = NULL;
+    swarm = OrbitSwarm();
 }
+} // namespace activity7
 
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity7();
-    return 0;
+const Activity ACTIVITY7 = {
+    7, "Satelite Duo", "Activity 7: Satelite Duo", 800, 800,
+    activity7::init, activity7::update, activity7::render, activity7::shutdown, NULL
+};
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY7) ? 0 : 1;
 }
 #endif
@@ -1,146 +1,360 @@
 #include "../common/opengl_setup.h"
+#include "../common/undistort.h"
+#include "../common/mapped_image.h"
+#include "../common/activity_host.h"
 #include <cmath>
-#include <vector>
 
 /*
  * Activity 8: Undistorted Cray 2
  * Purpose: Demonstrate distortion correction or grid rendering
- * TODO: Implement barrel/pincushion distortion correction algorithms
+ *
+ * The background photo is corrected for barrel distortion on the CPU with a
+ * precomputed remap table (src/common/undistort.h), tiled across threads.
+ * --input loads a PGM/PPM photo, a Y4M video or a directory of frames, memory
+ * mapped and streamed to the textures through pixel-unpack buffers
+ * (src/common/mapped_image.h); video and directories advance one frame per
+ * rendered frame. Without --input a checkerboard is distorted with the same
+ * lens model first. --lens FILE replaces the built-in lens with one estimated
+ * by ./main --calibrate, rescaled from the calibration image size to the
+ * photo's. Press U to toggle distorted/corrected.
+ *
+ * The reference grid and square have no vertex buffer: the vertex shader
+ * derives each line end from gl_VertexID and the grid size uniform, so
+ * changing the density (+/-, --count N lines per side, up to 10000) costs
+ * one uniform update, not a geometry rebuild.
  */
 
-void runActivity8() {
-    // Initialize OpenGL window
-    GLFWwindow* window = initializeOpenGL("Activity 8: Undistorted Cray 2", 800, 800);
-    if (!window) return;
+namespace activity8 {
+// Lens used for the built-in photo and assumed for --input images without --lens
+const float LENS_K1 = -0.28f;
+const float LENS_K2 = 0.08f;
 
-    // Set clear color
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+const int DEFAULT_GRID_CELLS = 20;
+const int MAX_GRID_CELLS = 9999;  // 10000 lines per side
+
+// Grid lines (shape 0) or the reference square (shape 1), pulled from gl_VertexID.
+// Grid vertices: horizontal lines first, then vertical, two ends per line.
+const char* GRID_VERTEX_SHADER = "#version 410 core\n"
+    "uniform int gridCells;\n"
+    "uniform int shape;\n"
+    "uniform vec3 color;\n"
+    "out vec3 vertexColor;\n"
+    "void main() {\n"
+    "   vec2 p;\n"
+    "   if (shape == 0) {\n"
+    "       int lines = gridCells + 1;\n"
+    "       int line = gl_VertexID / 2;\n"
+    "       float along = float(gl_VertexID & 1) * 2.0 - 1.0;\n"
+    "       float across = -1.0 + 2.0 * float(line % lines) / float(gridCells);\n"
+    "       p = line < lines ? vec2(along, across) : vec2(across, along);\n"
+    "   } else {\n"
+    "       p = vec2(gl_VertexID == 1 || gl_VertexID == 2 ? 0.3 : -0.3, gl_VertexID >= 2 ? 0.3 : -0.3);\n"
+    "   }\n"
+    "   gl_Position = vec4(p, 0.0, 1.0);\n"
+    "   vertexColor = color;\n"
+    "}\0";
+
+// Full-screen textured quad, image rows top to bottom
+const char* IMAGE_VERTEX_SHADER = "#version 410 core\n"
+    "layout (location = 0) in vec2 aPos;\n"
+    "out vec2 texCoord;\n"
+    "void main() {\n"
+    "   gl_Position = vec4(aPos, 0.0, 1.0);\n"
+    "   texCoord = vec2(aPos.x * 0.5 + 0.5, 0.5 - aPos.y * 0.5);\n"
+    "}\0";
+
+const char* IMAGE_FRAGMENT_SHADER = "#version 410 core\n"
+    "in vec2 texCoord;\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D image;\n"
+    "void main() {\n"
+    "   FragColor = vec4(texture(image, texCoord).rgb * 0.6, 1.0);\n"
+    "}\0";
+
+// CPU version of IMAGE_VERTEX_SHADER for --renderer soft: varyings are (u, v, brightness)
+void softImageShader(const float attribs[][4], const float* const uniforms[],
+                     float position[4], float varying[SOFT_VARYINGS]) {
+    (void)uniforms;
+    position[0] = attribs[0][0];
+    position[1] = attribs[0][1];
+    position[2] = 0.0f;
+    position[3] = 1.0f;
+    varying[0] = attribs[0][0] * 0.5f + 0.5f;
+    varying[1] = 0.5f - attribs[0][1] * 0.5f;
+    varying[2] = 0.6f;
+    varying[3] = 1.0f;
+}
+
+// CPU version of GRID_VERTEX_SHADER for --renderer soft
+void softGridShader(const float attribs[][4], const float* const uniforms[],
+                    float position[4], float varying[SOFT_VARYINGS]) {
+    int vertexId = (int)attribs[SOFT_VERTEX_ID][0];
+    int cells = (int)uniforms[0][0];
+    float x, y;
+    if (uniforms[1][0] == 0.0f) {
+        int lines = cells + 1;
+        int line = vertexId / 2;
+        float along = (float)(vertexId & 1) * 2.0f - 1.0f;
+        float across = -1.0f + 2.0f * (float)(line % lines) / (float)cells;
+        x = line < lines ? along : across;
+        y = line < lines ? across : along;
+    } else {
+        x = vertexId == 1 || vertexId == 2 ? 0.3f : -0.3f;
+        y = vertexId >= 2 ? 0.3f : -0.3f;
+    }
+    position[0] = x;
+    position[1] = y;
+    position[2] = 0.0f;
+    position[3] = 1.0f;
+    memcpy(varying, uniforms[2], 3 * sizeof(float));
+    varying[3] = 1.0f;
+}
 
-    // Generate a grid of vertices
-    const int gridSize = 20;
-    std::vector<float> vertices;
-
-    // Create horizontal lines
-    for (int i = 0; i <= gridSize; i++) {
-        float y = -1.0f + (2.0f * i / gridSize);
-
-        // Line start
-        vertices.push_back(-1.0f);
-        vertices.push_back(y);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.8f);
-        vertices.push_back(1.0f);
-
-        // Line end
-        vertices.push_back(1.0f);
-        vertices.push_back(y);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.8f);
-        vertices.push_back(1.0f);
+static bool showCorrected = true;
+static int gridCells = DEFAULT_GRID_CELLS;
+
+// Keyboard callback: U toggles the distorted and corrected photo, +/- the grid density
+void activity8KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    (void)scancode;  // Unused parameter
+    (void)mods;      // Unused parameter
+    if (action == GLFW_PRESS) {
+        if (key == GLFW_KEY_U) {
+            showCorrected = !showCorrected;
+            printf("Showing %s photo\n", showCorrected ? "corrected" : "distorted");
+        } else if (key == GLFW_KEY_EQUAL || key == GLFW_KEY_MINUS) {
+            gridCells = key == GLFW_KEY_EQUAL ? gridCells * 2 : gridCells / 2;
+            gridCells = gridCells < 1 ? 1 : (gridCells > MAX_GRID_CELLS ? MAX_GRID_CELLS : gridCells);
+            printf("Grid: %d x %d lines\n", gridCells + 1, gridCells + 1);
+        } else if (key == GLFW_KEY_ESCAPE) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
     }
+}
+
+// GL objects created by init(); the grid VAO has no attributes
+static StreamedTexture distortedTexture, correctedTexture;
+static unsigned int gridVAO, imageVAO, imageVBO, gridProgram, imageProgram;
+static int gridCellsLocation, shapeLocation, colorLocation;
 
-    // Create vertical lines
-    for (int i = 0; i <= gridSize; i++) {
-        float x = -1.0f + (2.0f * i / gridSize);
-
-        // Line start
-        vertices.push_back(x);
-        vertices.push_back(-1.0f);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.8f);
-        vertices.push_back(1.0f);
-
-        // Line end
-        vertices.push_back(x);
-        vertices.push_back(1.0f);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.0f);
-        vertices.push_back(0.8f);
-        vertices.push_back(1.0f);
+// Photo correction state, kept for streamed --input frames
+static ThreadPool* remapPool;
+static ImageSequence* photos;  // NULL for the built-in checkerboard
+static bool haveCalibratedLens;
+static LensModel calibratedLens;
+static int calibratedWidth, calibratedHeight;  // Image size the --lens file was calibrated at
+static bool streamStopped;  // A streamed frame could not be corrected
+static bool firstFrame;     // The frame init uploaded has not been drawn yet
+static LensModel photoLens;  // Lens of the current remap table
+static RemapTable undistortTable;
+static double tableBuildMs, remapMs;
+
+// Lens for a width x height photo: the built-in one, or the --lens calibration
+// rescaled to the photo (false, with a message, if the aspect ratio differs)
+bool lensForPhoto(int width, int height, LensModel& lens) {
+    if (!haveCalibratedLens) {
+        lens = makeLensModel(width, height, LENS_K1, LENS_K2);
+        return true;
     }
+    if (scaleLensModel(calibratedLens, calibratedWidth, calibratedHeight, width, height, lens))
+        return true;
+    fprintf(stderr, "Lens %s was calibrated on %dx%d images and does not fit a %dx%d photo (aspect ratio differs)\n",
+            g_renderOptions.lens, calibratedWidth, calibratedHeight, width, height);
+    return false;
+}
 
-    // Create reference shapes to visualize distortion
-    // Square in the center
-    float square[] = {
-        -0.3f, -0.3f, 0.0f,  1.0f, 0.5f, 0.0f,
-         0.3f, -0.3f, 0.0f,  1.0f, 0.5f, 0.0f,
-         0.3f,  0.3f, 0.0f,  1.0f, 0.5f, 0.0f,
-        -0.3f,  0.3f, 0.0f,  1.0f, 0.5f, 0.0f
-    };
-
-    for (int i = 0; i < 24; i++) {
-        vertices.push_back(square[i]);
+// Correct one distorted frame (rows top to bottom) and upload both versions.
+// The remap table is rebuilt only when the frame size changes; false if the
+// lens does not fit the new size.
+bool correctPhoto(const unsigned char* pixels, int width, int height, int channels) {
+    if (width != undistortTable.srcWidth || height != undistortTable.srcHeight ||
+        channels != undistortTable.channels) {
+        if (!lensForPhoto(width, height, photoLens)) return false;
+        double start = wallTimeMs();
+        buildRemapTable(photoLens, REMAP_UNDISTORT, width, height, channels, undistortTable, remapPool);
+        tableBuildMs = wallTimeMs() - start;
     }
+    uploadStreamedTexture(distortedTexture, pixels, width, height, channels);
 
-    // Create and bind VAO
-    unsigned int VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    // The corrected frame is remapped straight into the texture's mapped upload buffer
+    unsigned char* corrected = mapStreamedTexture(correctedTexture, undistortTable.width, undistortTable.height,
+                                                  channels);
+    double start = wallTimeMs();
+    remapPixels(undistortTable, pixels, corrected, remapPool);
+    remapMs = wallTimeMs() - start;
+    unmapStreamedTexture(correctedTexture);
+    return true;
+}
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-                 vertices.data(), GL_STATIC_DRAW);
+bool init(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+    showCorrected = true;
+    gridCells = DEFAULT_GRID_CELLS;
+    if (g_renderOptions.count > 1)
+        gridCells = g_renderOptions.count - 1 < MAX_GRID_CELLS ? g_renderOptions.count - 1 : MAX_GRID_CELLS;
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // Nothing created yet: shutdown after a failed init has nothing to delete
+    gridVAO = imageVAO = imageVBO = gridProgram = imageProgram = 0;
+    distortedTexture = correctedTexture = StreamedTexture();
+    remapPool = NULL;
+    photos = NULL;
 
-    // Color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // --lens and --input are checked before anything else is allocated
+    haveCalibratedLens = g_renderOptions.lens != NULL;
+    if (haveCalibratedLens && !readLensModel(g_renderOptions.lens, calibratedLens, calibratedWidth, calibratedHeight))
+        return false;
+    streamStopped = false;
+    firstFrame = true;
+    const unsigned char* pixels;
+    int width, height, channels;
+    LensModel firstLens;
+    if (g_renderOptions.input) {
+        photos = new ImageSequence();
+        if (!photos->open(g_renderOptions.input) || !photos->next(pixels, width, height, channels) ||
+            !lensForPhoto(width, height, firstLens)) {
+            delete photos;
+            photos = NULL;
+            return false;
+        }
+    } else {
+        // The checkerboard is 800 pixels wide, in the calibration's aspect ratio
+        width = 800;
+        height = haveCalibratedLens ? (int)lrint(800.0 * calibratedHeight / calibratedWidth) : 800;
+        channels = 3;
+    }
 
-    // Create shader program
-    unsigned int shaderProgram = createShaderProgram(DEFAULT_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER);
+    remapPool = new ThreadPool();
+    undistortTable = RemapTable();
+    createStreamedTexture(distortedTexture);
+    createStreamedTexture(correctedTexture);
+
+    // Distorted photo: --input frames or a checkerboard seen through the lens
+    Image distorted;
+    if (!photos) {
+        Image checkerboard;
+        RemapTable distortTable;
+        makeCheckerboard(checkerboard, width, height, channels, 50);
+        lensForPhoto(width, height, firstLens);
+        buildRemapTable(firstLens, REMAP_DISTORT, width, height, channels, distortTable, remapPool);
+        remapImage(distortTable, checkerboard, distorted, remapPool);
+        pixels = distorted.pixels.data();
+    }
+    correctPhoto(pixels, width, height, channels);
+
+    // Set clear color
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    // Grid lines are generated in the vertex shader, but GL still draws from a bound VAO
+    glGenVertexArrays(1, &gridVAO);
+
+    // Full-screen quad for the photo (triangle strip)
+    float quad[] = { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+    glGenVertexArrays(1, &imageVAO);
+    glGenBuffers(1, &imageVBO);
+    glBindVertexArray(imageVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, imageVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Create shader programs
+    gridProgram = createShaderProgram(GRID_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER, softGridShader);
+    gridCellsLocation = glGetUniformLocation(gridProgram, "gridCells");
+    shapeLocation = glGetUniformLocation(gridProgram, "shape");
+    colorLocation = glGetUniformLocation(gridProgram, "color");
+    imageProgram = createShaderProgram(IMAGE_VERTEX_SHADER, IMAGE_FRAGMENT_SHADER,
+                                       softImageShader, SOFT_FRAGMENT_TEXTURE);
 
     glLineWidth(1.0f);
 
     printf("Activity 8: Undistorted Cray 2\n");
-    printf("Displaying an undistorted grid for reference\n");
-    printf("TODO: Add distortion effects and correction algorithms\n");
-    printf("      - Barrel distortion\n");
-    printf("      - Pincushion distortion\n");
-    printf("      - Camera lens distortion correction\n");
-    printf("Press ESC to close.\n");
-
-    // Calculate line count
-    int horizontalLines = (gridSize + 1) * 2;
-    int verticalLines = (gridSize + 1) * 2;
-    int totalLineVertices = horizontalLines + verticalLines;
-
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-
-        // Draw grid lines
-        glDrawArrays(GL_LINES, 0, totalLineVertices);
-
-        // Draw reference square
-        glLineWidth(2.0f);
-        glDrawArrays(GL_LINE_LOOP, totalLineVertices, 4);
-        glLineWidth(1.0f);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    printf("Displaying an undistorted %d x %d line grid for reference (vertex-pulled, no vertex buffer)\n",
+           gridCells + 1, gridCells + 1);
+    printf("Photo: %s (%dx%d, %d channel(s)%s), lens k1 = %.2f, k2 = %.2f%s\n",
+           g_renderOptions.input ? g_renderOptions.input : "built-in checkerboard",
+           width, height, channels, photos && !photos->isStill() ? ", streamed" : "",
+           photoLens.k1, photoLens.k2, haveCalibratedLens ? " (calibrated)" : "");
+    printf("Remap table built in %.2f ms, image corrected in %.2f ms (%d threads)\n",
+           tableBuildMs, remapMs, remapPool->size());
+    printf("Press U to toggle distorted/corrected photo, +/- to change the grid density, ESC to close.\n");
+    return true;
+}
+
+void render(GLFWwindow* window) {
+    (void)window;  // Unused parameter
+
+    // Video or frame directory: correct and upload the next frame (the first
+    // frame draws what init uploaded). The remap runs on the CPU; the section's
+    // GPU time is the two texture uploads.
+    const unsigned char* pixels;
+    int width, height, channels;
+    bool advance = !firstFrame;
+    firstFrame = false;
+    if (advance && photos && !photos->isStill() && !streamStopped && photos->next(pixels, width, height, channels)) {
+        beginGpuSection("remap+upload");
+        if (!correctPhoto(pixels, width, height, channels)) {
+            printf("Stopped at a frame the lens does not fit; showing the last corrected frame\n");
+            streamStopped = true;
+        }
     }
 
-    // Cleanup
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    beginGpuSection("clear");
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Draw the photo behind the reference grid
+    beginGpuSection("photo");
+    glUseProgram(imageProgram);
+    glBindTexture(GL_TEXTURE_2D, showCorrected ? correctedTexture.texture : distortedTexture.texture);
+    glBindVertexArray(imageVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    beginGpuSection("grid");
+    glUseProgram(gridProgram);
+    glBindVertexArray(gridVAO);
+
+    // Draw grid lines: two vertices per line, (cells + 1) lines each way
+    glUniform1i(gridCellsLocation, gridCells);
+    glUniform1i(shapeLocation, 0);
+    glUniform3f(colorLocation, 0.0f, 0.8f, 1.0f);
+    glDrawArrays(GL_LINES, 0, 4 * (gridCells + 1));
+
+    // Draw reference square
+    glUniform1i(shapeLocation, 1);
+    glUniform3f(colorLocation, 1.0f, 0.5f, 0.0f);
+    glLineWidth(2.0f);
+    glDrawArrays(GL_LINE_LOOP, 0, 4);
+    glLineWidth(1.0f);
+    endGpuSection();
 }
 
-#ifndef MAIN_DISPATCHER
-int main() {
-    runActivity8();
-    return 0;
+void shutdown() {
+    glDeleteVertexArrays(1, &gridVAO);
+    glDeleteVertexArrays(1, &imageVAO);
+    glDeleteBuffers(1, &imageVBO);
+    if (photos && !photos->isStill())
+        printf("Streamed %d frames, %.1f MB uploaded\n", distortedTexture.uploads,
+               (distortedTexture.bytesUploaded + correctedTexture.bytesUploaded) / 1.0e6);
+    deleteStreamedTexture(distortedTexture);
+    deleteStreamedTexture(correctedTexture);
+    delete photos;
+    photos = NULL;
+    delete remapPool;
+    remapPool = NULL;
+    glDeleteProgram(gridProgram);
+    glDeleteProgram(imageProgram);
+}
+} // namespace activity8
+
+const Activity ACTIVITY8 = {
+    8, "Undistorted Cray 2", "Activity 8: Undistorted Cray 2", 800, 800,
+    activity8::init, NULL, activity8::render, activity8::shutdown, activity8::activity8KeyCallback
+};
+
+#if !defined(MAIN_DISPATCHER) && !defined(SEPARATE_ACTIVITIES)
+int main(int argc, char* argv[]) {
+    if (!parseRenderOptions(argc, argv, 1)) {
+        printRenderOptionsUsage();
+        return 1;
+    }
+    return runActivity(ACTIVITY8) ? 0 : 1;
 }
 #endif
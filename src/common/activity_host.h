@@ -0,0 +1,118 @@
+#ifndef ACTIVITY_HOST_H
+#define ACTIVITY_HOST_H
+
+#include <stdio.h>
+#include "opengl_setup.h"
+#include "frame_stats.h"
+
+/*
+ * Activity runtime
+ * Each activity is a set of hooks (init/update/render/shutdown) plus its
+ * window title and size; the host owns the window, the GL context and the
+ * render loop. Frame pacing (frameDeltaSeconds) and presenting, frame output
+ * and measurement (presentFrame) happen here, once, for every activity.
+ *
+ * Several activities can run back to back on one host: the window, the GL
+ * (or software) context and the shader cache are created once, and between
+ * activities the host only resizes the window and render target and restores
+ * the GL defaults (reuseOpenGL). ESC or the --frames limit moves on to the
+ * next activity. With --gl-stats, after each activity the host prints how
+ * many program, binding and capability changes reached GL and how many the
+ * state cache (gl_state.h) dropped as redundant, and a table of draws, state
+ * changes and upload bytes for setup and per frame (gl_stats.h).
+ */
+
+struct Activity {
+    int number;
+    const char* name;                     // Launcher heading, e.g. "Bull's Eye Target"
+    const char* title;                    // Window title
+    int width;
+    int height;
+    // Create GL objects and state; false skips the run. The host calls
+    // shutdown after a failed init too, so shutdown must cope with a partial
+    // init (objects that were never created are 0 or NULL, not left over from
+    // an earlier run in the same context).
+    bool (*init)(GLFWwindow* window);
+    void (*update)(double deltaSeconds);  // Advance animation (NULL for static scenes)
+    void (*render)(GLFWwindow* window);   // Draw one frame; the host presents it
+    void (*shutdown)();                   // Delete everything init created
+    GLFWkeyfun keyCallback;               // NULL: the common ESC-to-close callback
+};
+
+struct ActivityHost {
+    GLFWwindow* window;
+    double contextMs;     // Window and context creation
+    double initMs;        // Sum of the activities' init hooks
+    int activitiesRun;
+    char frameTag[32];
+};
+
+// Run one activity to completion on the host's window, creating the window
+// and context on first use. Returns false if the activity could not start.
+inline bool runHostedActivity(ActivityHost& host, const Activity& activity) {
+    snprintf(host.frameTag, sizeof(host.frameTag), "activity%d", activity.number);
+    g_renderOptions.frameTag = host.frameTag;
+
+    if (!host.window) {
+        double start = wallTimeMs();
+        host.window = initializeOpenGL(activity.title, activity.width, activity.height);
+        if (!host.window) return false;
+        host.contextMs = wallTimeMs() - start;
+    } else if (!reuseOpenGL(host.window, activity.title, activity.width, activity.height)) {
+        return false;
+    }
+    glfwSetKeyCallback(host.window, activity.keyCallback ? activity.keyCallback : keyCallback);
+    resetGLStateStats();
+    if (g_renderOptions.glStats) beginGLStats(g_renderOptions.glStats, host.frameTag);
+
+    double start = wallTimeMs();
+    bool ready = activity.init(host.window);
+    host.initMs += wallTimeMs() - start;
+    if (g_glStats.enabled) endGLStatsSetup();
+    if (ready) {
+        host.activitiesRun++;
+        while (!glfwWindowShouldClose(host.window)) {
+            if (activity.update) activity.update(frameDeltaSeconds());
+            activity.render(host.window);
+            presentFrame(host.window);
+        }
+    }
+
+    // Also after a failed init: the next activity reuses the context
+    activity.shutdown();
+    if (g_renderOptions.glStats) printGLStateStats();
+    finishGLStats();
+    return ready;
+}
+
+// Destroy the window and context; sequences report what sharing them saved
+inline void closeActivityHost(ActivityHost& host) {
+    if (host.window) shutdownOpenGL(host.window);
+    host.window = NULL;
+    g_renderOptions.frameTag = "frame";
+
+    if (host.activitiesRun > 1)
+        printf("\n%d activities in one context: context created once in %.1f ms, %.1f ms in activity init\n",
+               host.activitiesRun, host.contextMs, host.initMs);
+}
+
+// Run a single activity in its own window (standalone executables)
+inline bool runActivity(const Activity& activity) {
+    ActivityHost host = { NULL, 0.0, 0.0, 0, "" };
+    bool ran = runHostedActivity(host, activity);
+    closeActivityHost(host);
+    return ran;
+}
+
+// One per source in src/activities. Declaring them here gives the const
+// definitions external linkage, so main.cpp finds them whether the sources are
+// #included (the default unity build) or linked as separate objects.
+extern const Activity ACTIVITY1;
+extern const Activity ACTIVITY2;
+extern const Activity ACTIVITY3;
+extern const Activity ACTIVITY4;
+extern const Activity ACTIVITY6;
+extern const Activity ACTIVITY7;
+extern const Activity ACTIVITY8;
+
+#endif // ACTIVITY_HOST_H
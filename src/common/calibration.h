@@ -0,0 +1,884 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "image_io.h"
+#include "simd.h"
+#include "image_compare.h"
+#include "thread_pool.h"
+#include "frame_stats.h"
+#include "undistort.h"
+
+/*
+ * Camera calibration from checkerboard images (./main --calibrate)
+ *
+ * Corners: each image is smoothed and the inner corners of the board found
+ * as saddle points of the intensity (negative Hessian determinant). The
+ * candidates are put in grid order by growing the grid from the one nearest
+ * the image center, predicting each neighbor from the local row/column step,
+ * then refined to sub-pixel accuracy: at the true corner every nearby
+ * gradient is perpendicular to the offset from the corner, which gives a
+ * 2x2 linear system. Images are processed in parallel on the thread pool.
+ *
+ * Solver: fx, fy, cx, cy, k1, k2, k3, p1, p2 (undistort.h's LensModel) and
+ * one pose per image are fitted with Levenberg-Marquardt, starting from a
+ * focal length and poses read off each image's board homography. The normal
+ * equations have one 9x9 block for the lens, one 6x6 block per pose and
+ * lens-pose coupling blocks only, so the pose blocks are eliminated (Schur
+ * complement) and only a 9x9 system is solved per step. Each image's blocks
+ * are assembled on the pool, with residuals and Jacobian rows computed for
+ * 4 corners at a time (simd.h).
+ */
+
+const int CALIB_LENS_PARAMS = 9;   // fx, fy, cx, cy, k1, k2, k3, p1, p2
+const int CALIB_POSE_PARAMS = 6;   // Rotation increment (3), translation (3)
+const int CALIB_PARAMS = CALIB_LENS_PARAMS + CALIB_POSE_PARAMS;
+const int CALIB_MAX_ITERATIONS = 100;
+
+// One checkerboard image: ordered corners and its pose once solved
+struct CalibrationView {
+    bool found;
+    std::vector<float> cornerX, cornerY;  // Row by row, cols per row
+    double R[9];                          // Board to camera rotation, row-major
+    double t[3];
+};
+
+struct CalibrationResult {
+    LensModel lens;
+    double rms;        // Reprojection error, pixels
+    int iterations;
+    int viewsUsed;
+};
+
+// ---- Small dense linear algebra ----
+
+// Solve A X = B in place (A n x n, B n x m, both row-major) by Gaussian
+// elimination with partial pivoting. Returns false for a singular A.
+inline bool solveLinear(double* A, double* B, int n, int m) {
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++)
+            if (fabs(A[r * n + col]) > fabs(A[pivot * n + col])) pivot = r;
+        if (fabs(A[pivot * n + col]) < 1e-300) return false;
+        if (pivot != col) {
+            for (int c = 0; c < n; c++) std::swap(A[col * n + c], A[pivot * n + c]);
+            for (int c = 0; c < m; c++) std::swap(B[col * m + c], B[pivot * m + c]);
+        }
+        for (int r = col + 1; r < n; r++) {
+            double factor = A[r * n + col] / A[col * n + col];
+            if (factor == 0.0) continue;
+            for (int c = col; c < n; c++) A[r * n + c] -= factor * A[col * n + c];
+            for (int c = 0; c < m; c++) B[r * m + c] -= factor * B[col * m + c];
+        }
+    }
+    for (int col = n - 1; col >= 0; col--) {
+        for (int c = 0; c < m; c++) {
+            double sum = B[col * m + c];
+            for (int k = col + 1; k < n; k++) sum -= A[col * n + k] * B[k * m + c];
+            B[col * m + c] = sum / A[col * n + col];
+        }
+    }
+    return true;
+}
+
+// Rotation matrix (row-major) for the rotation vector w (Rodrigues)
+inline void rotationFromVector(const double w[3], double R[9]) {
+    double angle = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    if (angle < 1e-12) {
+        double I[9] = { 1, -w[2], w[1], w[2], 1, -w[0], -w[1], w[0], 1 };
+        memcpy(R, I, sizeof(I));
+        return;
+    }
+    double x = w[0] / angle, y = w[1] / angle, z = w[2] / angle;
+    double c = cos(angle), s = sin(angle), C = 1.0 - c;
+    double M[9] = { c + x * x * C,     x * y * C - z * s, x * z * C + y * s,
+                    y * x * C + z * s, c + y * y * C,     y * z * C - x * s,
+                    z * x * C - y * s, z * y * C + x * s, c + z * z * C };
+    memcpy(R, M, sizeof(M));
+}
+
+inline void multiplyMatrix3(const double A[9], const double B[9], double out[9]) {
+    double M[9];
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+            M[r * 3 + c] = A[r * 3] * B[c] + A[r * 3 + 1] * B[3 + c] + A[r * 3 + 2] * B[6 + c];
+    memcpy(out, M, sizeof(M));
+}
+
+// ---- Corner detection ----
+
+// Gray float copy of an 8-bit image, smoothed twice with a 5-tap binomial filter
+inline void smoothGray(const Image& image, std::vector<float>& out) {
+    int w = image.width, h = image.height;
+    std::vector<float> a((size_t)w * h), b((size_t)w * h);
+    for (size_t i = 0; i < a.size(); i++) {
+        const unsigned char* p = &image.pixels[i * image.channels];
+        a[i] = image.channels == 3 ? 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2] : p[0];
+    }
+    static const float taps[5] = { 1.0f / 16, 4.0f / 16, 6.0f / 16, 4.0f / 16, 1.0f / 16 };
+    for (int pass = 0; pass < 2; pass++) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                float sum = 0.0f;
+                for (int k = -2; k <= 2; k++) {
+                    int sx = x + k < 0 ? 0 : (x + k >= w ? w - 1 : x + k);
+                    sum += taps[k + 2] * a[(size_t)y * w + sx];
+                }
+                b[(size_t)y * w + x] = sum;
+            }
+        }
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                float sum = 0.0f;
+                for (int k = -2; k <= 2; k++) {
+                    int sy = y + k < 0 ? 0 : (y + k >= h ? h - 1 : y + k);
+                    sum += taps[k + 2] * b[(size_t)sy * w + x];
+                }
+                a[(size_t)y * w + x] = sum;
+            }
+        }
+    }
+    out.swap(a);
+}
+
+struct CornerCandidate {
+    float x, y;
+    float response;
+};
+
+// Saddle points: local maxima of -det(Hessian). The board's outer corners
+// (one dark square against the background) respond too, but several times
+// weaker than inner corners, so the threshold is half the median response of
+// the strongest 'expected' peaks.
+inline void findSaddlePoints(const std::vector<float>& gray, int w, int h, int expected,
+                             std::vector<CornerCandidate>& out) {
+    const int border = 4, radius = 3;
+    std::vector<float> response((size_t)w * h, 0.0f);
+    float strongest = 0.0f;
+    for (int y = border; y < h - border; y++) {
+        for (int x = border; x < w - border; x++) {
+            const float* p = &gray[(size_t)y * w + x];
+            float ixx = p[1] - 2.0f * p[0] + p[-1];
+            float iyy = p[w] - 2.0f * p[0] + p[-w];
+            float ixy = 0.25f * (p[w + 1] - p[w - 1] - p[-w + 1] + p[-w - 1]);
+            float saddle = ixy * ixy - ixx * iyy;
+            response[(size_t)y * w + x] = saddle;
+            strongest = saddle > strongest ? saddle : strongest;
+        }
+    }
+
+    out.clear();
+    float threshold = 0.02f * strongest;
+    for (int y = border; y < h - border; y++) {
+        for (int x = border; x < w - border; x++) {
+            float r = response[(size_t)y * w + x];
+            if (r <= threshold) continue;
+            bool peak = true;
+            for (int dy = -radius; dy <= radius && peak; dy++)
+                for (int dx = -radius; dx <= radius && peak; dx++)
+                    if ((dx || dy) && response[(size_t)(y + dy) * w + x + dx] >= r &&
+                        (response[(size_t)(y + dy) * w + x + dx] > r || dy < 0 || (dy == 0 && dx < 0)))
+                        peak = false;
+            if (peak) {
+                CornerCandidate c = { (float)x, (float)y, r };
+                out.push_back(c);
+            }
+        }
+    }
+    std::sort(out.begin(), out.end(),
+              [](const CornerCandidate& a, const CornerCandidate& b) { return a.response > b.response; });
+    if ((int)out.size() < expected) return;
+    float cutoff = 0.5f * out[expected / 2].response;
+    size_t keep = expected;
+    while (keep < out.size() && out[keep].response >= cutoff) keep++;
+    out.resize(keep);
+}
+
+// Put candidates in cols x rows grid order by growing the grid outward from
+// the candidate nearest the centroid. Fails unless exactly the board is found.
+inline bool orderBoardCorners(const std::vector<CornerCandidate>& candidates, int cols, int rows,
+                              std::vector<float>& cornerX, std::vector<float>& cornerY) {
+    int n = (int)candidates.size();
+    if (n < cols * rows) return false;
+
+    float mx = 0.0f, my = 0.0f;
+    for (int i = 0; i < n; i++) { mx += candidates[i].x; my += candidates[i].y; }
+    mx /= n; my /= n;
+
+    // Seed and its two grid directions from the nearest neighbors
+    int seed = 0;
+    for (int i = 1; i < n; i++) {
+        float di = (candidates[i].x - mx) * (candidates[i].x - mx) + (candidates[i].y - my) * (candidates[i].y - my);
+        float ds = (candidates[seed].x - mx) * (candidates[seed].x - mx) + (candidates[seed].y - my) * (candidates[seed].y - my);
+        if (di < ds) seed = i;
+    }
+    std::vector<int> near;
+    for (int i = 0; i < n; i++) if (i != seed) near.push_back(i);
+    auto distance2 = [&](int a, int b) {
+        float dx = candidates[a].x - candidates[b].x, dy = candidates[a].y - candidates[b].y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(near.begin(), near.end(), [&](int a, int b) { return distance2(a, seed) < distance2(b, seed); });
+    float axis[2][2] = { { candidates[near[0]].x - candidates[seed].x, candidates[near[0]].y - candidates[seed].y },
+                         { 0.0f, 0.0f } };
+    float length0 = sqrtf(axis[0][0] * axis[0][0] + axis[0][1] * axis[0][1]);
+    bool haveSecond = false;
+    for (size_t k = 1; k < near.size() && k < 8 && !haveSecond; k++) {
+        float dx = candidates[near[k]].x - candidates[seed].x, dy = candidates[near[k]].y - candidates[seed].y;
+        float cosine = (dx * axis[0][0] + dy * axis[0][1]) / (sqrtf(dx * dx + dy * dy) * length0);
+        if (fabsf(cosine) < 0.5f) {
+            axis[1][0] = dx;
+            axis[1][1] = dy;
+            haveSecond = true;
+        }
+    }
+    if (!haveSecond) return false;
+
+    // Grid cells indexed from -span..span in both directions
+    const int span = cols + rows;
+    const int side = 2 * span + 1;
+    std::vector<int> grid((size_t)side * side, -1);
+    std::vector<char> used(n, 0);
+    auto cell = [&](int i, int j) -> int& { return grid[(size_t)(j + span) * side + (i + span)]; };
+
+    std::vector<int> queue;
+    cell(0, 0) = seed;
+    used[seed] = 1;
+    queue.push_back(0);
+    queue.push_back(0);
+    int assigned = 1;
+    int minI = 0, maxI = 0, minJ = 0, maxJ = 0;
+    static const int steps[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    for (size_t q = 0; q < queue.size(); q += 2) {
+        int i = queue[q], j = queue[q + 1];
+        const CornerCandidate& here = candidates[cell(i, j)];
+        for (int s = 0; s < 4; s++) {
+            int ni = i + steps[s][0], nj = j + steps[s][1];
+            if (ni < -span || ni > span || nj < -span || nj > span || cell(ni, nj) >= 0) continue;
+
+            // Step from the opposite neighbor if known, otherwise the seed's axis
+            int bi = i - steps[s][0], bj = j - steps[s][1];
+            float sx, sy;
+            if (bi >= -span && bi <= span && bj >= -span && bj <= span && cell(bi, bj) >= 0) {
+                sx = here.x - candidates[cell(bi, bj)].x;
+                sy = here.y - candidates[cell(bi, bj)].y;
+            } else {
+                int a = steps[s][0] ? 0 : 1;
+                int sign = steps[s][0] + steps[s][1];
+                sx = sign * axis[a][0];
+                sy = sign * axis[a][1];
+            }
+            float px = here.x + sx, py = here.y + sy;
+            float limit = 0.3f * 0.3f * (sx * sx + sy * sy);
+            int best = -1;
+            float bestDistance = limit;
+            for (int c = 0; c < n; c++) {
+                if (used[c]) continue;
+                float dx = candidates[c].x - px, dy = candidates[c].y - py;
+                float d = dx * dx + dy * dy;
+                if (d < bestDistance) { bestDistance = d; best = c; }
+            }
+            if (best < 0) continue;
+            cell(ni, nj) = best;
+            used[best] = 1;
+            assigned++;
+            minI = ni < minI ? ni : minI; maxI = ni > maxI ? ni : maxI;
+            minJ = nj < minJ ? nj : minJ; maxJ = nj > maxJ ? nj : maxJ;
+            queue.push_back(ni);
+            queue.push_back(nj);
+        }
+    }
+
+    int extentI = maxI - minI + 1, extentJ = maxJ - minJ + 1;
+    if (assigned != cols * rows || extentI * extentJ != assigned) return false;
+    bool transposed;
+    if (extentI == cols && extentJ == rows) transposed = false;
+    else if (extentI == rows && extentJ == cols) transposed = true;
+    else return false;
+
+    // Board plane labelling is free: any rotation or mirror of the grid is
+    // absorbed by the pose, since the corners all lie at Z = 0
+    cornerX.resize(cols * rows);
+    cornerY.resize(cols * rows);
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int index = transposed ? cell(minI + r, minJ + c) : cell(minI + c, minJ + r);
+            if (index < 0) return false;
+            cornerX[r * cols + c] = candidates[index].x;
+            cornerY[r * cols + c] = candidates[index].y;
+        }
+    }
+    return true;
+}
+
+// Move a corner to where nearby gradients are perpendicular to the offset:
+// minimize sum of (g . (q - p))^2 over pixels p in the window
+inline void refineCorner(const std::vector<float>& gray, int w, int h, int radius, float& qx, float& qy) {
+    for (int iteration = 0; iteration < 20; iteration++) {
+        int cx = (int)floorf(qx + 0.5f), cy = (int)floorf(qy + 0.5f);
+        if (cx - radius < 1 || cy - radius < 1 || cx + radius >= w - 1 || cy + radius >= h - 1) return;
+        double a = 0, b = 0, c = 0, bx = 0, by = 0;
+        double sigma2 = 0.5 * radius * radius;
+        for (int dy = -radius; dy <= radius; dy++) {
+            for (int dx = -radius; dx <= radius; dx++) {
+                int x = cx + dx, y = cy + dy;
+                const float* p = &gray[(size_t)y * w + x];
+                double gx = 0.5 * (p[1] - p[-1]);
+                double gy = 0.5 * (p[w] - p[-w]);
+                double weight = exp(-(dx * dx + dy * dy) / sigma2);
+                double gxx = weight * gx * gx, gxy = weight * gx * gy, gyy = weight * gy * gy;
+                a += gxx; b += gxy; c += gyy;
+                bx += gxx * x + gxy * y;
+                by += gxy * x + gyy * y;
+            }
+        }
+        double det = a * c - b * b;
+        if (fabs(det) < 1e-12) return;
+        float nx = (float)((c * bx - b * by) / det);
+        float ny = (float)((a * by - b * bx) / det);
+        float shift = (nx - qx) * (nx - qx) + (ny - qy) * (ny - qy);
+        if (shift > (float)(radius * radius)) return;  // Diverging, keep the last estimate
+        qx = nx;
+        qy = ny;
+        if (shift < 1e-4f) return;
+    }
+}
+
+// Find and order the cols x rows inner corners of a checkerboard
+inline bool findBoardCorners(const Image& image, int cols, int rows,
+                             std::vector<float>& cornerX, std::vector<float>& cornerY) {
+    std::vector<float> gray;
+    smoothGray(image, gray);
+    std::vector<CornerCandidate> candidates;
+    findSaddlePoints(gray, image.width, image.height, cols * rows, candidates);
+    if (!orderBoardCorners(candidates, cols, rows, cornerX, cornerY)) return false;
+
+    // Refinement window: a third of the shortest corner spacing, at least 2 pixels
+    float spacing = 1e30f;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int i = r * cols + c;
+            if (c + 1 < cols) {
+                float dx = cornerX[i + 1] - cornerX[i], dy = cornerY[i + 1] - cornerY[i];
+                spacing = std::min(spacing, dx * dx + dy * dy);
+            }
+            if (r + 1 < rows) {
+                float dx = cornerX[i + cols] - cornerX[i], dy = cornerY[i + cols] - cornerY[i];
+                spacing = std::min(spacing, dx * dx + dy * dy);
+            }
+        }
+    }
+    int radius = (int)(sqrtf(spacing) / 3.0f);
+    radius = radius < 2 ? 2 : (radius > 8 ? 8 : radius);
+    for (size_t i = 0; i < cornerX.size(); i++)
+        refineCorner(gray, image.width, image.height, radius, cornerX[i], cornerY[i]);
+    return true;
+}
+
+// Corner detection for every image, one image per pool task
+inline int detectCalibrationCorners(const std::vector<Image>& images, int cols, int rows,
+                                    std::vector<CalibrationView>& views, ThreadPool* pool) {
+    views.assign(images.size(), CalibrationView());
+    auto detect = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            views[i].found = findBoardCorners(images[i], cols, rows, views[i].cornerX, views[i].cornerY);
+    };
+    if (pool)
+        pool->parallelFor(images.size(), 1, detect);
+    else
+        detect(0, images.size());
+
+    int found = 0;
+    for (size_t i = 0; i < views.size(); i++) found += views[i].found;
+    return found;
+}
+
+// ---- Initial estimate ----
+
+// Homography H (row-major, H[8] = 1) with (u, v, 1) ~ H (X, Y, 1), from
+// normalized direct linear transform over all correspondences
+inline bool fitHomography(const std::vector<double>& X, const std::vector<double>& Y,
+                          const std::vector<double>& u, const std::vector<double>& v, double H[9]) {
+    size_t n = X.size();
+    // Normalize both point sets: centroid at 0, mean distance sqrt(2)
+    double T[2][3];
+    const std::vector<double>* sets[2][2] = { { &X, &Y }, { &u, &v } };
+    for (int s = 0; s < 2; s++) {
+        double mx = 0, my = 0, d = 0;
+        for (size_t i = 0; i < n; i++) { mx += (*sets[s][0])[i]; my += (*sets[s][1])[i]; }
+        mx /= n; my /= n;
+        for (size_t i = 0; i < n; i++)
+            d += sqrt(((*sets[s][0])[i] - mx) * ((*sets[s][0])[i] - mx) + ((*sets[s][1])[i] - my) * ((*sets[s][1])[i] - my));
+        double scale = d > 0 ? sqrt(2.0) * n / d : 1.0;
+        T[s][0] = scale; T[s][1] = -scale * mx; T[s][2] = -scale * my;
+    }
+
+    // Normal equations of the 2n x 8 system with h33 = 1
+    double A[64] = { 0 }, b[8] = { 0 };
+    for (size_t i = 0; i < n; i++) {
+        double x = T[0][0] * X[i] + T[0][1], y = T[0][0] * Y[i] + T[0][2];
+        double uu = T[1][0] * u[i] + T[1][1], vv = T[1][0] * v[i] + T[1][2];
+        double rows[2][8] = { { x, y, 1, 0, 0, 0, -uu * x, -uu * y },
+                              { 0, 0, 0, x, y, 1, -vv * x, -vv * y } };
+        double rhs[2] = { uu, vv };
+        for (int r = 0; r < 2; r++)
+            for (int j = 0; j < 8; j++) {
+                b[j] += rows[r][j] * rhs[r];
+                for (int k = 0; k < 8; k++) A[j * 8 + k] += rows[r][j] * rows[r][k];
+            }
+    }
+    if (!solveLinear(A, b, 8, 1)) return false;
+    double Hn[9] = { b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], 1.0 };
+
+    // Undo the normalization: H = Tu^-1 Hn TX
+    double TX[9] = { T[0][0], 0, T[0][1], 0, T[0][0], T[0][2], 0, 0, 1 };
+    double TuInv[9] = { 1 / T[1][0], 0, -T[1][1] / T[1][0], 0, 1 / T[1][0], -T[1][2] / T[1][0], 0, 0, 1 };
+    multiplyMatrix3(Hn, TX, H);
+    multiplyMatrix3(TuInv, H, H);
+    for (int i = 0; i < 9; i++) H[i] /= H[8];
+    return true;
+}
+
+// Board pose from a homography and the camera (undistorted pinhole): the
+// first two columns of K^-1 H are the rotation's first two columns, scaled
+inline void poseFromHomography(const double H[9], double fx, double fy, double cx, double cy,
+                               double R[9], double t[3]) {
+    double B[9];
+    for (int c = 0; c < 3; c++) {
+        B[6 + c] = H[6 + c];
+        B[c] = (H[c] - cx * H[6 + c]) / fx;
+        B[3 + c] = (H[3 + c] - cy * H[6 + c]) / fy;
+    }
+    double norm = sqrt(B[0] * B[0] + B[3] * B[3] + B[6] * B[6]);
+    double scale = 1.0 / norm;
+    if (B[8] * scale < 0) scale = -scale;  // Board in front of the camera
+    double r1[3] = { B[0] * scale, B[3] * scale, B[6] * scale };
+    double r2[3] = { B[1] * scale, B[4] * scale, B[7] * scale };
+    t[0] = B[2] * scale; t[1] = B[5] * scale; t[2] = B[8] * scale;
+
+    // Nearest rotation by Gram-Schmidt
+    double n1 = sqrt(r1[0] * r1[0] + r1[1] * r1[1] + r1[2] * r1[2]);
+    for (int k = 0; k < 3; k++) r1[k] /= n1;
+    double d = r1[0] * r2[0] + r1[1] * r2[1] + r1[2] * r2[2];
+    for (int k = 0; k < 3; k++) r2[k] -= d * r1[k];
+    double n2 = sqrt(r2[0] * r2[0] + r2[1] * r2[1] + r2[2] * r2[2]);
+    for (int k = 0; k < 3; k++) r2[k] /= n2;
+    double r3[3] = { r1[1] * r2[2] - r1[2] * r2[1], r1[2] * r2[0] - r1[0] * r2[2], r1[0] * r2[1] - r1[1] * r2[0] };
+    for (int k = 0; k < 3; k++) {
+        R[k * 3] = r1[k];
+        R[k * 3 + 1] = r2[k];
+        R[k * 3 + 2] = r3[k];
+    }
+}
+
+// ---- Levenberg-Marquardt ----
+
+// Project a board point (X, Y, 0) with lens parameters p[CALIB_LENS_PARAMS]
+inline void projectBoardPoint(const double p[], const double R[9], const double t[3], double X, double Y,
+                              double& u, double& v) {
+    double xc = R[0] * X + R[1] * Y + t[0];
+    double yc = R[3] * X + R[4] * Y + t[1];
+    double zc = R[6] * X + R[7] * Y + t[2];
+    double x = xc / zc, y = yc / zc;
+    double r2 = x * x + y * y;
+    double radial = 1.0 + r2 * (p[4] + r2 * (p[5] + r2 * p[6]));
+    double xd = x * radial + 2.0 * p[7] * x * y + p[8] * (r2 + 2.0 * x * x);
+    double yd = y * radial + p[7] * (r2 + 2.0 * y * y) + 2.0 * p[8] * x * y;
+    u = p[0] * xd + p[2];
+    v = p[1] * yd + p[3];
+}
+
+// Sum of squared reprojection errors over the views in use
+inline double reprojectionCost(const std::vector<CalibrationView>& views, const std::vector<int>& used,
+                               const double lens[], const std::vector<double>& poses,
+                               int cols, int rows, double square) {
+    double cost = 0.0;
+    for (size_t k = 0; k < used.size(); k++) {
+        const CalibrationView& view = views[used[k]];
+        const double* R = &poses[k * 12];
+        for (int i = 0; i < cols * rows; i++) {
+            double u, v;
+            projectBoardPoint(lens, R, R + 9, (i % cols) * square, (i / cols) * square, u, v);
+            double du = u - view.cornerX[i], dv = v - view.cornerY[i];
+            cost += du * du + dv * dv;
+        }
+    }
+    return cost;
+}
+
+// Normal-equation blocks of one view: J^T J (15 x 15, lens then pose) and J^T r
+struct CalibrationBlocks {
+    double JtJ[CALIB_PARAMS * CALIB_PARAMS];
+    double Jtr[CALIB_PARAMS];
+};
+
+// Accumulate one view's blocks, 4 corners per SIMD iteration. Residual rows
+// for u and v share the chain rule through the camera-space point.
+inline void assembleViewBlocks(const CalibrationView& view, const double lensParams[], const double pose[12],
+                               int cols, int rows, float square, CalibrationBlocks& out) {
+    const int n = cols * rows;
+    f32x4 JtJ[CALIB_PARAMS * (CALIB_PARAMS + 1) / 2];
+    f32x4 Jtr[CALIB_PARAMS];
+    const f32x4 zero = f32x4_set1(0.0f);
+    for (int i = 0; i < CALIB_PARAMS * (CALIB_PARAMS + 1) / 2; i++) JtJ[i] = zero;
+    for (int i = 0; i < CALIB_PARAMS; i++) Jtr[i] = zero;
+
+    f32x4 fx = f32x4_set1((float)lensParams[0]), fy = f32x4_set1((float)lensParams[1]);
+    f32x4 cx = f32x4_set1((float)lensParams[2]), cy = f32x4_set1((float)lensParams[3]);
+    f32x4 k1 = f32x4_set1((float)lensParams[4]), k2 = f32x4_set1((float)lensParams[5]);
+    f32x4 k3 = f32x4_set1((float)lensParams[6]);
+    f32x4 p1 = f32x4_set1((float)lensParams[7]), p2 = f32x4_set1((float)lensParams[8]);
+    f32x4 R[9], t[3];
+    for (int i = 0; i < 9; i++) R[i] = f32x4_set1((float)pose[i]);
+    for (int i = 0; i < 3; i++) t[i] = f32x4_set1((float)pose[9 + i]);
+    const f32x4 one = f32x4_set1(1.0f), two = f32x4_set1(2.0f), three = f32x4_set1(3.0f), six = f32x4_set1(6.0f);
+
+    for (int base = 0; base < n; base += SIMD_WIDTH) {
+        float bx[4], by[4], ou[4], ov[4], valid[4];
+        for (int l = 0; l < 4; l++) {
+            int i = base + l < n ? base + l : n - 1;
+            bx[l] = (i % cols) * square;
+            by[l] = (i / cols) * square;
+            ou[l] = view.cornerX[i];
+            ov[l] = view.cornerY[i];
+            valid[l] = base + l < n ? 1.0f : 0.0f;
+        }
+        f32x4 X = f32x4_load(bx), Y = f32x4_load(by), mask = f32x4_load(valid);
+
+        // Board point rotated (P) and in camera space (P + t)
+        f32x4 Px = f32x4_add(f32x4_mul(R[0], X), f32x4_mul(R[1], Y));
+        f32x4 Py = f32x4_add(f32x4_mul(R[3], X), f32x4_mul(R[4], Y));
+        f32x4 Pz = f32x4_add(f32x4_mul(R[6], X), f32x4_mul(R[7], Y));
+        f32x4 iz = f32x4_div(one, f32x4_add(Pz, t[2]));
+        f32x4 x = f32x4_mul(f32x4_add(Px, t[0]), iz);
+        f32x4 y = f32x4_mul(f32x4_add(Py, t[1]), iz);
+
+        f32x4 xx = f32x4_mul(x, x), yy = f32x4_mul(y, y), xy = f32x4_mul(x, y);
+        f32x4 r2 = f32x4_add(xx, yy), r4 = f32x4_mul(r2, r2), r6 = f32x4_mul(r4, r2);
+        f32x4 radial = f32x4_add(one, f32x4_mul(r2, f32x4_add(k1, f32x4_mul(r2, f32x4_add(k2, f32x4_mul(r2, k3))))));
+        f32x4 dRadial = f32x4_add(k1, f32x4_mul(r2, f32x4_add(f32x4_mul(two, k2), f32x4_mul(three, f32x4_mul(k3, r2)))));
+        f32x4 tanX1 = f32x4_mul(two, xy), tanX2 = f32x4_add(r2, f32x4_mul(two, xx));
+        f32x4 tanY1 = f32x4_add(r2, f32x4_mul(two, yy));
+        f32x4 xd = f32x4_add(f32x4_mul(x, radial), f32x4_add(f32x4_mul(p1, tanX1), f32x4_mul(p2, tanX2)));
+        f32x4 yd = f32x4_add(f32x4_mul(y, radial), f32x4_add(f32x4_mul(p1, tanY1), f32x4_mul(p2, tanX1)));
+
+        f32x4 ru = f32x4_mul(f32x4_sub(f32x4_add(f32x4_mul(fx, xd), cx), f32x4_load(ou)), mask);
+        f32x4 rv = f32x4_mul(f32x4_sub(f32x4_add(f32x4_mul(fy, yd), cy), f32x4_load(ov)), mask);
+
+        // d(xd, yd) / d(x, y)
+        f32x4 twoDR = f32x4_mul(two, dRadial);
+        f32x4 cross = f32x4_add(f32x4_mul(twoDR, xy), f32x4_add(f32x4_mul(f32x4_mul(two, p1), x), f32x4_mul(f32x4_mul(two, p2), y)));
+        f32x4 dxdx = f32x4_add(f32x4_add(radial, f32x4_mul(twoDR, xx)), f32x4_add(f32x4_mul(f32x4_mul(two, p1), y), f32x4_mul(f32x4_mul(six, p2), x)));
+        f32x4 dydy = f32x4_add(f32x4_add(radial, f32x4_mul(twoDR, yy)), f32x4_add(f32x4_mul(f32x4_mul(six, p1), y), f32x4_mul(f32x4_mul(two, p2), x)));
+        f32x4 fxm = f32x4_mul(fx, mask), fym = f32x4_mul(fy, mask);
+        f32x4 dudx = f32x4_mul(fxm, dxdx), dudy = f32x4_mul(fxm, cross);
+        f32x4 dvdx = f32x4_mul(fym, cross), dvdy = f32x4_mul(fym, dydy);
+
+        // d(u, v) / d(camera-space point)
+        f32x4 a0 = f32x4_mul(dudx, iz), a1 = f32x4_mul(dudy, iz);
+        f32x4 a2 = f32x4_sub(zero, f32x4_add(f32x4_mul(a0, x), f32x4_mul(a1, y)));
+        f32x4 b0 = f32x4_mul(dvdx, iz), b1 = f32x4_mul(dvdy, iz);
+        f32x4 b2 = f32x4_sub(zero, f32x4_add(f32x4_mul(b0, x), f32x4_mul(b1, y)));
+
+        // Jacobian rows; rotation increments w move the point by w x P
+        f32x4 Ju[CALIB_PARAMS] = {
+            f32x4_mul(xd, mask), zero, mask, zero,
+            f32x4_mul(fxm, f32x4_mul(x, r2)), f32x4_mul(fxm, f32x4_mul(x, r4)), f32x4_mul(fxm, f32x4_mul(x, r6)),
+            f32x4_mul(fxm, tanX1), f32x4_mul(fxm, tanX2),
+            f32x4_sub(f32x4_mul(a2, Py), f32x4_mul(a1, Pz)),
+            f32x4_sub(f32x4_mul(a0, Pz), f32x4_mul(a2, Px)),
+            f32x4_sub(f32x4_mul(a1, Px), f32x4_mul(a0, Py)),
+            a0, a1, a2
+        };
+        f32x4 Jv[CALIB_PARAMS] = {
+            zero, f32x4_mul(yd, mask), zero, mask,
+            f32x4_mul(fym, f32x4_mul(y, r2)), f32x4_mul(fym, f32x4_mul(y, r4)), f32x4_mul(fym, f32x4_mul(y, r6)),
+            f32x4_mul(fym, tanY1), f32x4_mul(fym, tanX1),
+            f32x4_sub(f32x4_mul(b2, Py), f32x4_mul(b1, Pz)),
+            f32x4_sub(f32x4_mul(b0, Pz), f32x4_mul(b2, Px)),
+            f32x4_sub(f32x4_mul(b1, Px), f32x4_mul(b0, Py)),
+            b0, b1, b2
+        };
+
+        int k = 0;
+        for (int r = 0; r < CALIB_PARAMS; r++) {
+            Jtr[r] = f32x4_add(Jtr[r], f32x4_add(f32x4_mul(Ju[r], ru), f32x4_mul(Jv[r], rv)));
+            for (int c = r; c < CALIB_PARAMS; c++, k++)
+                JtJ[k] = f32x4_add(JtJ[k], f32x4_add(f32x4_mul(Ju[r], Ju[c]), f32x4_mul(Jv[r], Jv[c])));
+        }
+    }
+
+    int k = 0;
+    for (int r = 0; r < CALIB_PARAMS; r++) {
+        out.Jtr[r] = f32x4_sum(Jtr[r]);
+        for (int c = r; c < CALIB_PARAMS; c++, k++)
+            out.JtJ[r * CALIB_PARAMS + c] = out.JtJ[c * CALIB_PARAMS + r] = f32x4_sum(JtJ[k]);
+    }
+}
+
+// Fit the lens and the board poses to the detected corners. 'square' is the
+// board square size (any unit; translations come out in it).
+inline bool calibrateLens(const std::vector<CalibrationView>& views, int cols, int rows, double square,
+                          int width, int height, CalibrationResult& result, ThreadPool* pool) {
+    std::vector<int> used;
+    for (size_t i = 0; i < views.size(); i++)
+        if (views[i].found) used.push_back((int)i);
+    result.viewsUsed = (int)used.size();
+    if (used.size() < 3) {
+        fprintf(stderr, "Calibration needs the board in at least 3 images, found it in %zu\n", used.size());
+        return false;
+    }
+    const int n = cols * rows;
+    const size_t viewCount = used.size();
+
+    // Homographies; focal length from their orthogonality constraints with
+    // the principal point at the image center and square pixels
+    double lens[CALIB_LENS_PARAMS] = { 0, 0, 0.5 * (width - 1), 0.5 * (height - 1), 0, 0, 0, 0, 0 };
+    std::vector<double> homographies(viewCount * 9);
+    std::vector<double> X(n), Y(n), u(n), v(n);
+    for (int i = 0; i < n; i++) { X[i] = (i % cols) * square; Y[i] = (i / cols) * square; }
+    double sumAA = 0, sumAB = 0;
+    for (size_t k = 0; k < viewCount; k++) {
+        const CalibrationView& view = views[used[k]];
+        for (int i = 0; i < n; i++) { u[i] = view.cornerX[i] - lens[2]; v[i] = view.cornerY[i] - lens[3]; }
+        double* H = &homographies[k * 9];
+        if (!fitHomography(X, Y, u, v, H)) {
+            fprintf(stderr, "Calibration: degenerate board view %d\n", used[k]);
+            return false;
+        }
+        // h1' W h2 = 0 and h1' W h1 = h2' W h2 with W = diag(1/f^2, 1/f^2, 1)
+        double equations[2][2] = {
+            { H[0] * H[1] + H[3] * H[4], H[6] * H[7] },
+            { H[0] * H[0] + H[3] * H[3] - H[1] * H[1] - H[4] * H[4], H[6] * H[6] - H[7] * H[7] }
+        };
+        for (int e = 0; e < 2; e++) {
+            sumAA += equations[e][0] * equations[e][0];
+            sumAB += equations[e][0] * equations[e][1];
+        }
+    }
+    double inverseF2 = sumAA > 0 ? -sumAB / sumAA : 0.0;
+    double f = inverseF2 > 0 ? 1.0 / sqrt(inverseF2) : 0.5 * (width > height ? width : height);
+    lens[0] = lens[1] = f;
+
+    // Poses: rotation (9) and translation (3) per view
+    std::vector<double> poses(viewCount * 12);
+    for (size_t k = 0; k < viewCount; k++)
+        poseFromHomography(&homographies[k * 9], f, f, 0.0, 0.0, &poses[k * 12], &poses[k * 12 + 9]);
+
+    std::vector<CalibrationBlocks> blocks(viewCount);
+    std::vector<double> poseSteps(viewCount * CALIB_POSE_PARAMS);
+    std::vector<double> candidatePoses(poses.size());
+    std::vector<double> VinvW(viewCount * CALIB_POSE_PARAMS * (CALIB_LENS_PARAMS + 1));
+    double cost = reprojectionCost(views, used, lens, poses, cols, rows, square);
+    double lambda = 1e-3;
+    int iteration = 0;
+    bool converged = false;
+
+    for (; iteration < CALIB_MAX_ITERATIONS && !converged; iteration++) {
+        auto assemble = [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++)
+                assembleViewBlocks(views[used[k]], lens, &poses[k * 12], cols, rows, (float)square, blocks[k]);
+        };
+        if (pool) pool->parallelFor(viewCount, 8, assemble);
+        else assemble(0, viewCount);
+
+        bool improved = false;
+        while (!improved && lambda < 1e12) {
+            // Reduced system S da = -ga, S = U - sum W V^-1 W' (damped diagonals)
+            double S[CALIB_LENS_PARAMS * CALIB_LENS_PARAMS] = { 0 };
+            double rhs[CALIB_LENS_PARAMS] = { 0 };
+            bool singular = false;
+            for (size_t k = 0; k < viewCount && !singular; k++) {
+                const CalibrationBlocks& b = blocks[k];
+                const int L = CALIB_LENS_PARAMS, P = CALIB_POSE_PARAMS, N = CALIB_PARAMS;
+                for (int r = 0; r < L; r++) {
+                    rhs[r] -= b.Jtr[r];
+                    for (int c = 0; c < L; c++)
+                        S[r * L + c] += b.JtJ[r * N + c] * (r == c ? 1.0 + lambda : 1.0);
+                }
+                // V^-1 [W' | gb] for this view, 6 x (9 + 1)
+                double V[P * P];
+                double* M = &VinvW[k * P * (L + 1)];
+                for (int r = 0; r < P; r++) {
+                    for (int c = 0; c < P; c++)
+                        V[r * P + c] = b.JtJ[(L + r) * N + L + c] * (r == c ? 1.0 + lambda : 1.0);
+                    for (int c = 0; c < L; c++) M[r * (L + 1) + c] = b.JtJ[(L + r) * N + c];
+                    M[r * (L + 1) + L] = b.Jtr[L + r];
+                }
+                if (!solveLinear(V, M, P, L + 1)) { singular = true; break; }
+                for (int r = 0; r < L; r++) {
+                    for (int j = 0; j < P; j++) {
+                        double w = b.JtJ[r * N + L + j];
+                        for (int c = 0; c < L; c++) S[r * L + c] -= w * M[j * (L + 1) + c];
+                        rhs[r] += w * M[j * (L + 1) + L];
+                    }
+                }
+            }
+            if (singular || !solveLinear(S, rhs, CALIB_LENS_PARAMS, 1)) {
+                lambda *= 10.0;
+                continue;
+            }
+
+            // Back-substitute the pose steps: db = -V^-1 (gb + W' da)
+            double candidateLens[CALIB_LENS_PARAMS];
+            for (int i = 0; i < CALIB_LENS_PARAMS; i++) candidateLens[i] = lens[i] + rhs[i];
+            for (size_t k = 0; k < viewCount; k++) {
+                const double* M = &VinvW[k * CALIB_POSE_PARAMS * (CALIB_LENS_PARAMS + 1)];
+                double step[CALIB_POSE_PARAMS];
+                for (int r = 0; r < CALIB_POSE_PARAMS; r++) {
+                    double sum = M[r * (CALIB_LENS_PARAMS + 1) + CALIB_LENS_PARAMS];
+                    for (int c = 0; c < CALIB_LENS_PARAMS; c++) sum += M[r * (CALIB_LENS_PARAMS + 1) + c] * rhs[c];
+                    step[r] = -sum;
+                }
+                double dR[9];
+                rotationFromVector(step, dR);
+                multiplyMatrix3(dR, &poses[k * 12], &candidatePoses[k * 12]);
+                for (int i = 0; i < 3; i++) candidatePoses[k * 12 + 9 + i] = poses[k * 12 + 9 + i] + step[3 + i];
+            }
+
+            double candidateCost = reprojectionCost(views, used, candidateLens, candidatePoses, cols, rows, square);
+            if (candidateCost < cost) {
+                double change = (cost - candidateCost) / cost;
+                memcpy(lens, candidateLens, sizeof(lens));
+                poses.swap(candidatePoses);
+                candidatePoses.resize(poses.size());
+                cost = candidateCost;
+                lambda = lambda * 0.1 > 1e-12 ? lambda * 0.1 : 1e-12;
+                improved = true;
+                converged = change < 1e-10;
+            } else {
+                lambda *= 10.0;
+            }
+        }
+        if (!improved) break;
+    }
+
+    LensModel model = { (float)lens[0], (float)lens[1], (float)lens[2], (float)lens[3],
+                        (float)lens[4], (float)lens[5], (float)lens[6], (float)lens[7], (float)lens[8] };
+    result.lens = model;
+    result.rms = sqrt(cost / (viewCount * n));
+    result.iterations = iteration;
+    return true;
+}
+
+inline void printLensModel(const LensModel& lens) {
+    printf("  fx = %.3f  fy = %.3f  cx = %.3f  cy = %.3f\n", lens.fx, lens.fy, lens.cx, lens.cy);
+    printf("  k1 = %.6f  k2 = %.6f  k3 = %.6f\n", lens.k1, lens.k2, lens.k3);
+    printf("  p1 = %.6f  p2 = %.6f\n", lens.p1, lens.p2);
+}
+
+// ---- Synthetic views (benchmark) ----
+
+// Render a checkerboard with cols x rows inner corners (one board unit per
+// square) as seen by 'lens' from pose (R, t). 'rays' holds the undistorted
+// normalized ray of every 2x2 subsample, shared by all views of one lens.
+inline void renderBoardView(const std::vector<float>& rays, int width, int height, int cols, int rows,
+                            const double R[9], const double t[3], Image& image) {
+    allocateImage(image, width, height, 1);
+    // (X, Y, 1) ~ [r1 r2 t]^-1 (x, y, 1)
+    double H[9] = { R[0], R[1], t[0], R[3], R[4], t[1], R[6], R[7], t[2] };
+    double I[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    solveLinear(H, I, 3, 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int sum = 0;
+            for (int s = 0; s < 4; s++) {
+                const float* ray = &rays[(((size_t)y * width + x) * 4 + s) * 2];
+                double w = I[6] * ray[0] + I[7] * ray[1] + I[8];
+                double bx = (I[0] * ray[0] + I[1] * ray[1] + I[2]) / w;
+                double by = (I[3] * ray[0] + I[4] * ray[1] + I[5]) / w;
+                bool onBoard = w > 0 && bx > -1.0 && bx < cols && by > -1.0 && by < rows;
+                bool dark = onBoard && (((int)floor(bx) + (int)floor(by)) & 1) == 0;
+                sum += dark ? 30 : 220;
+            }
+            image.pixels[(size_t)y * width + x] = (unsigned char)(sum / 4);
+        }
+    }
+}
+
+// ./main --bench-cpu calibrate: calibrate from synthetic views of a known lens
+inline void runCalibrationBenchmark(int viewCount) {
+    const int width = 640, height = 480, cols = 9, rows = 6;
+    LensModel truth = makeLensModel(width, height, -0.28f, 0.08f, 0.0f, 0.001f, -0.0005f);
+    ThreadPool pool;
+
+    // Undistorted ray per 2x2 subsample, then random board poses with every corner in view
+    std::vector<float> rays((size_t)width * height * 8);
+    pool.parallelFor(height, 8, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++)
+            for (int x = 0; x < width; x++)
+                for (int s = 0; s < 4; s++) {
+                    float* ray = &rays[((y * width + x) * 4 + s) * 2];
+                    float px = x - 0.25f + 0.5f * (s & 1), py = y - 0.25f + 0.5f * (s >> 1);
+                    undistortNormalized(truth, (px - truth.cx) / truth.fx, (py - truth.cy) / truth.fy, ray[0], ray[1]);
+                }
+    });
+
+    std::vector<Image> images(viewCount);
+    std::vector<double> poses(viewCount * 12);
+    srand(7);
+    for (int k = 0; k < viewCount; k++) {
+        double* R = &poses[k * 12];
+        double* t = R + 9;
+        bool inView = false;
+        while (!inView) {
+            double w[3];
+            for (int a = 0; a < 3; a++) w[a] = (a < 2 ? 0.6 : 0.35) * (rand() / (double)RAND_MAX - 0.5);
+            rotationFromVector(w, R);
+            double center[3] = { 0.5 * (cols - 1), 0.5 * (rows - 1), 0.0 };
+            double place[3] = { 2.0 * (rand() / (double)RAND_MAX - 0.5), 1.5 * (rand() / (double)RAND_MAX - 0.5),
+                                11.0 + 5.0 * (rand() / (double)RAND_MAX) };
+            for (int a = 0; a < 3; a++)
+                t[a] = place[a] - (R[a * 3] * center[0] + R[a * 3 + 1] * center[1]);
+            double params[CALIB_LENS_PARAMS] = { truth.fx, truth.fy, truth.cx, truth.cy,
+                                                 truth.k1, truth.k2, truth.k3, truth.p1, truth.p2 };
+            inView = true;
+            for (int i = -1; i <= cols && inView; i++)
+                for (int j = -1; j <= rows && inView; j++) {
+                    double u, v;
+                    projectBoardPoint(params, R, t, i, j, u, v);
+                    inView = u > 8 && v > 8 && u < width - 8 && v < height - 8;
+                }
+        }
+    }
+    double start = wallTimeMs();
+    pool.parallelFor(viewCount, 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+            renderBoardView(rays, width, height, cols, rows, &poses[k * 12], &poses[k * 12 + 9], images[k]);
+    });
+    double renderMs = wallTimeMs() - start;
+
+    printf("Calibration benchmark: %d synthetic %dx%d views of a %dx%d-corner board (rendered in %.0f ms)\n\n",
+           viewCount, width, height, cols, rows, renderMs);
+
+    std::vector<CalibrationView> views;
+    start = wallTimeMs();
+    int found = detectCalibrationCorners(images, cols, rows, views, &pool);
+    double detectMs = wallTimeMs() - start;
+
+    CalibrationResult result;
+    start = wallTimeMs();
+    bool ok = calibrateLens(views, cols, rows, 1.0, width, height, result, &pool);
+    double solveMs = wallTimeMs() - start;
+
+    printf("Corners: board found in %d of %d views in %.1f ms (%.2f ms per view, %d threads)\n",
+           found, viewCount, detectMs, detectMs / viewCount, pool.size());
+    if (!ok) return;
+    printf("Solver:  %d Levenberg-Marquardt iterations in %.1f ms, RMS reprojection error %.4f px\n\n",
+           result.iterations, solveMs, result.rms);
+    printf("Parameter        True    Estimated\n");
+    printf("---------  ----------  -----------\n");
+    const char* names[CALIB_LENS_PARAMS] = { "fx", "fy", "cx", "cy", "k1", "k2", "k3", "p1", "p2" };
+    const float* trueValues = &truth.fx;
+    const float* estimates = &result.lens.fx;
+    for (int i = 0; i < CALIB_LENS_PARAMS; i++)
+        printf("%9s  %10.5f  %11.5f\n", names[i], trueValues[i], estimates[i]);
+    printf("\n");
+}
+
+#endif // CALIBRATION_H
@@ -0,0 +1,358 @@
+#ifndef CLIPPER_H
+#define CLIPPER_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "opengl_setup.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "frame_stats.h"
+
+/*
+ * CPU triangle clipper (Sutherland-Hodgman)
+ * Clips batches of triangles (x, y, z per vertex) against a convex window in the
+ * xy plane: the ortho view volume or any user-defined convex polygon.
+ *
+ * Outcodes are computed 4 triangles at a time with SIMD. Triangles entirely
+ * inside are copied, triangles entirely outside one edge are dropped, and only
+ * the rest go through Sutherland-Hodgman. The result is a compacted triangle
+ * list with the same vertex layout, ready for glBufferData.
+ */
+
+const int CLIP_MAX_PLANES = 8;
+const int CLIP_MAX_POLY = 3 + CLIP_MAX_PLANES;
+
+// Convex clip window as half-planes: a*x + b*y + c >= 0 is inside
+struct ClipWindow {
+    int planeCount;
+    float a[CLIP_MAX_PLANES];
+    float b[CLIP_MAX_PLANES];
+    float c[CLIP_MAX_PLANES];
+};
+
+// Axis-aligned window, e.g. the glOrtho(0, 100, 0, 100) view volume
+inline ClipWindow makeRectClipWindow(float xMin, float yMin, float xMax, float yMax) {
+    ClipWindow window;
+    window.planeCount = 4;
+    window.a[0] =  1.0f; window.b[0] =  0.0f; window.c[0] = -xMin;  // Left
+    window.a[1] = -1.0f; window.b[1] =  0.0f; window.c[1] =  xMax;  // Right
+    window.a[2] =  0.0f; window.b[2] =  1.0f; window.c[2] = -yMin;  // Bottom
+    window.a[3] =  0.0f; window.b[3] = -1.0f; window.c[3] =  yMax;  // Top
+    return window;
+}
+
+// Convex polygon window from counter-clockwise (x, y) points.
+// Returns false if there are too many points or the polygon is not convex/CCW.
+inline bool makeConvexClipWindow(const float* points, int pointCount, ClipWindow& window) {
+    if (pointCount < 3 || pointCount > CLIP_MAX_PLANES) return false;
+
+    window.planeCount = pointCount;
+    for (int i = 0; i < pointCount; i++) {
+        float x0 = points[i * 2], y0 = points[i * 2 + 1];
+        int j = (i + 1) % pointCount;
+        float x1 = points[j * 2], y1 = points[j * 2 + 1];
+        // Inward unit normal of a CCW edge is the edge direction rotated left
+        float length = sqrtf((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+        if (length == 0.0f) return false;
+        window.a[i] = -(y1 - y0) / length;
+        window.b[i] = (x1 - x0) / length;
+        window.c[i] = -(window.a[i] * x0 + window.b[i] * y0);
+    }
+
+    // Every vertex must be inside every edge (allowing for rounding)
+    for (int i = 0; i < pointCount; i++) {
+        for (int k = 0; k < pointCount; k++) {
+            float d = window.a[k] * points[i * 2] + window.b[k] * points[i * 2 + 1] + window.c[k];
+            if (d < -1.0e-4f * (1.0f + fabsf(window.c[k]))) return false;
+        }
+    }
+    return true;
+}
+
+struct ClipStats {
+    size_t accepted;   // Trivially inside
+    size_t rejected;   // Trivially outside
+    size_t clipped;    // Went through Sutherland-Hodgman
+};
+
+// Clip one polygon against the planes flagged in 'planeMask'; returns the new vertex count
+inline int clipPolygon(const ClipWindow& window, unsigned int planeMask, float* poly, int count) {
+    float scratch[CLIP_MAX_POLY * 3];
+    float* src = poly;
+    float* dst = scratch;
+
+    for (int p = 0; p < window.planeCount && count > 0; p++) {
+        if (!(planeMask & (1u << p))) continue;
+
+        float a = window.a[p], b = window.b[p], c = window.c[p];
+        int outCount = 0;
+        const float* prev = src + (count - 1) * 3;
+        float dPrev = a * prev[0] + b * prev[1] + c;
+
+        for (int i = 0; i < count; i++) {
+            const float* cur = src + i * 3;
+            float dCur = a * cur[0] + b * cur[1] + c;
+
+            if ((dCur >= 0.0f) != (dPrev >= 0.0f)) {
+                // Edge crosses the plane: emit the intersection
+                float t = dPrev / (dPrev - dCur);
+                float* out = dst + outCount * 3;
+                out[0] = prev[0] + t * (cur[0] - prev[0]);
+                out[1] = prev[1] + t * (cur[1] - prev[1]);
+                out[2] = prev[2] + t * (cur[2] - prev[2]);
+                outCount++;
+            }
+            if (dCur >= 0.0f) {
+                memcpy(dst + outCount * 3, cur, 3 * sizeof(float));
+                outCount++;
+            }
+
+            prev = cur;
+            dPrev = dCur;
+        }
+
+        count = outCount;
+        float* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != poly) memcpy(poly, src, count * 3 * sizeof(float));
+    return count;
+}
+
+// Outcodes for 4 triangles starting at 'tri'. Bit p of code[v][i] is set when
+// vertex v of triangle i is outside plane p.
+inline void triangleOutcodes4(const ClipWindow& window, const float* tri, unsigned int code[3][4]) {
+    for (int v = 0; v < 3; v++) {
+        const float* p0 = tri + v * 3;
+        f32x4 x = f32x4_set(p0[0], p0[9], p0[18], p0[27]);
+        f32x4 y = f32x4_set(p0[1], p0[10], p0[19], p0[28]);
+        code[v][0] = code[v][1] = code[v][2] = code[v][3] = 0;
+
+        for (int p = 0; p < window.planeCount; p++) {
+            f32x4 d = f32x4_add(f32x4_add(f32x4_mul(f32x4_set1(window.a[p]), x),
+                                          f32x4_mul(f32x4_set1(window.b[p]), y)),
+                                f32x4_set1(window.c[p]));
+            int outside = f32x4_movemask(f32x4_cmplt(d, f32x4_set1(0.0f)));
+            for (int i = 0; i < 4; i++)
+                code[v][i] |= ((outside >> i) & 1u) << p;
+        }
+    }
+}
+
+inline unsigned int triangleOutcode(const ClipWindow& window, const float* p) {
+    unsigned int code = 0;
+    for (int k = 0; k < window.planeCount; k++) {
+        if (window.a[k] * p[0] + window.b[k] * p[1] + window.c[k] < 0.0f)
+            code |= 1u << k;
+    }
+    return code;
+}
+
+// Classify one triangle by its vertex outcodes and append what survives to 'out'
+inline void emitClippedTriangle(const ClipWindow& window, const float* tri,
+                                unsigned int c0, unsigned int c1, unsigned int c2,
+                                std::vector<float>& out, ClipStats& stats) {
+    if ((c0 | c1 | c2) == 0) {
+        out.insert(out.end(), tri, tri + 9);
+        stats.accepted++;
+        return;
+    }
+    if ((c0 & c1 & c2) != 0) {
+        stats.rejected++;
+        return;
+    }
+
+    stats.clipped++;
+    float poly[CLIP_MAX_POLY * 3];
+    memcpy(poly, tri, 9 * sizeof(float));
+    int count = clipPolygon(window, c0 | c1 | c2, poly, 3);
+
+    // Fan-triangulate the convex result
+    for (int i = 1; i + 1 < count; i++) {
+        out.insert(out.end(), poly, poly + 3);
+        out.insert(out.end(), poly + i * 3, poly + i * 3 + 6);
+    }
+}
+
+// Clip triangles [first, first + count) of 'vertices' and append the result to 'out'
+inline void clipTriangleRange(const ClipWindow& window, const float* vertices, size_t first, size_t count,
+                              std::vector<float>& out, ClipStats& stats) {
+    const float* tri = vertices + first * 9;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4, tri += 36) {
+        unsigned int code[3][4];
+        triangleOutcodes4(window, tri, code);
+        for (int t = 0; t < 4; t++)
+            emitClippedTriangle(window, tri + t * 9, code[0][t], code[1][t], code[2][t], out, stats);
+    }
+
+    for (; i < count; i++, tri += 9) {
+        emitClippedTriangle(window, tri, triangleOutcode(window, tri), triangleOutcode(window, tri + 3),
+                            triangleOutcode(window, tri + 6), out, stats);
+    }
+}
+
+// Clip a triangle list (9 floats per triangle). 'out' is replaced with the compacted result.
+inline ClipStats clipTriangles(const ClipWindow& window, const float* vertices, size_t triangleCount,
+                               std::vector<float>& out) {
+    ClipStats stats = { 0, 0, 0 };
+    out.clear();
+    clipTriangleRange(window, vertices, 0, triangleCount, out, stats);
+    return stats;
+}
+
+// Triangles per parallel chunk
+const size_t CLIP_CHUNK = 1 << 16;
+
+// Reusable per-chunk output for clipTrianglesParallel
+struct ClipScratch {
+    std::vector<std::vector<float> > chunkOut;
+    std::vector<ClipStats> chunkStats;
+};
+
+// Clip on all pool threads; chunks are clipped independently then concatenated in order
+inline ClipStats clipTrianglesParallel(const ClipWindow& window, const float* vertices, size_t triangleCount,
+                                       std::vector<float>& out, ThreadPool& pool, ClipScratch& scratch) {
+    size_t chunks = (triangleCount + CLIP_CHUNK - 1) / CLIP_CHUNK;
+    scratch.chunkOut.resize(chunks);
+    scratch.chunkStats.assign(chunks, ClipStats());
+
+    pool.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            size_t first = c * CLIP_CHUNK;
+            size_t count = first + CLIP_CHUNK < triangleCount ? CLIP_CHUNK : triangleCount - first;
+            ClipStats stats = { 0, 0, 0 };
+            scratch.chunkOut[c].clear();
+            clipTriangleRange(window, vertices, first, count, scratch.chunkOut[c], stats);
+            scratch.chunkStats[c] = stats;
+        }
+    });
+
+    // Compact chunk outputs into one buffer
+    ClipStats total = { 0, 0, 0 };
+    size_t floats = 0;
+    for (size_t c = 0; c < chunks; c++) floats += scratch.chunkOut[c].size();
+    out.resize(floats);
+
+    size_t offset = 0;
+    for (size_t c = 0; c < chunks; c++) {
+        const std::vector<float>& part = scratch.chunkOut[c];
+        if (!part.empty()) memcpy(out.data() + offset, part.data(), part.size() * sizeof(float));
+        offset += part.size();
+        total.accepted += scratch.chunkStats[c].accepted;
+        total.rejected += scratch.chunkStats[c].rejected;
+        total.clipped += scratch.chunkStats[c].clipped;
+    }
+    return total;
+}
+
+// CPU version of the benchmark's vertex shader (--renderer soft): 0-100 square to NDC, black
+inline void softClipBenchShader(const float attribs[][4], const float* const uniforms[],
+                                float position[4], float varying[SOFT_VARYINGS]) {
+    (void)uniforms;
+    position[0] = attribs[0][0] * 0.02f - 1.0f;
+    position[1] = attribs[0][1] * 0.02f - 1.0f;
+    position[2] = 0.0f;
+    position[3] = 1.0f;
+    varying[0] = varying[1] = varying[2] = 0.0f;
+    varying[3] = 1.0f;
+}
+
+// Time uploading and drawing a triangle list on the GPU (glFinish included)
+inline double timeGpuTriangles(const std::vector<float>& vertices, unsigned int vbo) {
+    double start = wallTimeMs();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 3));
+    glFinish();
+    return wallTimeMs() - start;
+}
+
+// ./main --bench-cpu clip: clip random triangles against the 0-100 view volume.
+// When a GL context can be created, compares against sending everything to the GPU.
+inline void runClipBenchmark(size_t triangleCount) {
+    printf("Clip benchmark: %zu random triangles against the 0-100 view volume\n\n", triangleCount);
+
+    // Triangles around the window: about half cross or miss it
+    std::vector<float> input(triangleCount * 9);
+    srand(42);
+    for (size_t t = 0; t < triangleCount; t++) {
+        float cx = -60.0f + 220.0f * (rand() / (float)RAND_MAX);
+        float cy = -60.0f + 220.0f * (rand() / (float)RAND_MAX);
+        for (int v = 0; v < 3; v++) {
+            input[t * 9 + v * 3 + 0] = cx + 10.0f * (rand() / (float)RAND_MAX - 0.5f);
+            input[t * 9 + v * 3 + 1] = cy + 10.0f * (rand() / (float)RAND_MAX - 0.5f);
+            input[t * 9 + v * 3 + 2] = 0.0f;
+        }
+    }
+
+    ClipWindow window = makeRectClipWindow(0.0f, 0.0f, 100.0f, 100.0f);
+    std::vector<float> output;
+    output.reserve(input.size());
+
+    double start = wallTimeMs();
+    ClipStats stats = clipTriangles(window, input.data(), triangleCount, output);
+    double singleMs = wallTimeMs() - start;
+
+    ThreadPool pool;
+    ClipScratch scratch;
+    clipTrianglesParallel(window, input.data(), triangleCount, output, pool, scratch);  // Warm-up
+    start = wallTimeMs();
+    clipTrianglesParallel(window, input.data(), triangleCount, output, pool, scratch);
+    double parallelMs = wallTimeMs() - start;
+
+    printf("Accepted %zu, rejected %zu, clipped %zu -> %zu output triangles\n\n",
+           stats.accepted, stats.rejected, stats.clipped, output.size() / 9);
+    printf("Path                          Time ms      Triangles/s\n");
+    printf("--------------------------  ---------  ---------------\n");
+    printf("CPU clip, 1 thread          %9.2f  %15.3e\n", singleMs, triangleCount / (singleMs / 1000.0));
+    printf("CPU clip, %2d threads        %9.2f  %15.3e\n", pool.size(), parallelMs,
+           triangleCount / (parallelMs / 1000.0));
+
+    // GPU comparison needs a context; skip it quietly where none is available
+    GLFWwindow* glWindow = initializeOpenGL("Clip benchmark", 500, 500);
+    if (!glWindow) {
+        printf("(No OpenGL context: GPU comparison skipped)\n\n");
+        return;
+    }
+
+    const char* vertexSource = "#version 410 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "void main() { gl_Position = vec4(aPos.xy * 0.02 - 1.0, 0.0, 1.0); }\0";
+    const char* fragmentSource = "#version 410 core\n"
+        "out vec4 FragColor;\n"
+        "void main() { FragColor = vec4(0.0, 0.0, 0.0, 1.0); }\0";
+    unsigned int program = createShaderProgram(vertexSource, fragmentSource, softClipBenchShader);
+
+    unsigned int vao, vbo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glUseProgram(program);
+
+    timeGpuTriangles(output, vbo);  // Warm-up
+    double gpuOnlyMs = timeGpuTriangles(input, vbo);
+    double clippedDrawMs = timeGpuTriangles(output, vbo);
+    double cpuPlusGpuMs = parallelMs + clippedDrawMs;
+
+    printf("GPU only (upload + draw)    %9.2f  %15.3e\n", gpuOnlyMs, triangleCount / (gpuOnlyMs / 1000.0));
+    printf("CPU clip + GPU draw         %9.2f  %15.3e\n", cpuPlusGpuMs,
+           triangleCount / (cpuPlusGpuMs / 1000.0));
+    printf("\n");
+
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteProgram(program);
+    shutdownOpenGL(glWindow);
+}
+
+#endif // CLIPPER_H
@@ -0,0 +1,60 @@
+#ifndef DISC_IMPOSTOR_H
+#define DISC_IMPOSTOR_H
+
+#include "opengl_setup.h"
+
+/*
+ * Anti-aliased discs and rings drawn as one quad each
+ *
+ * Instead of a tessellated circle (writeDisc + GL_TRIANGLE_FAN), every disc
+ * is the 4-vertex quad below scaled to its radius. The fragment shader gets
+ * the signed distance to the rim from the interpolated local position and
+ * turns it into coverage over one pixel, so edges are smooth at any size and
+ * there is no segment count to pick.
+ *
+ * The activity's vertex shader takes the corner at location 0 and provides:
+ *   vLocal       position in units of the outer radius (1 on the rim)
+ *   vInner       inner radius / outer radius, 0 for a solid disc (flat)
+ *   vertexColor  fill color
+ * It should grow the quad by a pixel past the radius so the edge fringe fits.
+ * Output is premultiplied by coverage: draw after beginDiscImpostors().
+ *
+ * The software renderer has no fragment shaders or blending, so
+ * useDiscImpostors() is false there and callers keep their tessellated path.
+ */
+
+const int DISC_IMPOSTOR_VERTICES = 4;  // GL_TRIANGLE_STRIP
+const float DISC_IMPOSTOR_QUAD[DISC_IMPOSTOR_VERTICES * 2] = {
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+    -1.0f,  1.0f,
+     1.0f,  1.0f
+};
+
+// Coverage of the outer edge (and the inner one for rings) from the distance
+// to it in pixels; the gradient of r gives the size of a pixel in local units
+const char* const DISC_IMPOSTOR_FRAGMENT_SHADER = "#version 410 core\n"
+    "in vec2 vLocal;\n"
+    "flat in float vInner;\n"
+    "in vec3 vertexColor;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "   float r = length(vLocal);\n"
+    "   float pixel = max(length(vec2(dFdx(r), dFdy(r))), 1e-6);\n"
+    "   float coverage = clamp((1.0 - r) / pixel + 0.5, 0.0, 1.0);\n"
+    "   if (vInner > 0.0) coverage *= clamp((r - vInner) / pixel + 0.5, 0.0, 1.0);\n"
+    "   if (coverage <= 0.0) discard;\n"
+    "   FragColor = vec4(vertexColor * coverage, coverage);\n"
+    "}\0";
+
+inline bool useDiscImpostors() {
+    return !g_softGL.active;
+}
+
+// Premultiplied alpha blending for the coverage output
+inline void beginDiscImpostors() {
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+#endif // DISC_IMPOSTOR_H
@@ -0,0 +1,308 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+// Included by opengl_setup.h, after the GL headers
+#include <stdio.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frame_stats.h"
+
+/*
+ * Frame capture to a video file without stalling the render loop (--capture)
+ *
+ * Each frame is read back with glReadPixels into one of CAPTURE_PBO_COUNT
+ * pixel-pack buffers, which returns at once; a fence marks when the copy is
+ * done. The buffer is mapped only when the ring comes back around to it, two
+ * frames later, so the copy has long finished. The mapped pixels are handed to
+ * a background encoder thread that converts and writes them, keeping file I/O
+ * off the render thread. At most CAPTURE_QUEUE_FRAMES frames wait for the
+ * encoder; beyond that the render loop waits for it (counted).
+ *
+ * FILE.y4m is YUV4MPEG2 (4:4:4, BT.601, 60 fps), anything else a stream of
+ * binary PPMs (ffmpeg -f image2pipe -c:v ppm). Activities after the first in
+ * one run get their own file: FILE_activityN.y4m. Window resizes cannot
+ * change a stream's size, so frames of another size are skipped.
+ *
+ * The software renderer's frame is already in memory, so it is copied
+ * straight to the encoder.
+ */
+
+const int CAPTURE_PBO_COUNT = 3;
+const int CAPTURE_QUEUE_FRAMES = 8;
+
+struct CaptureSlot {
+    unsigned int pbo;
+    GLsync fence;  // Non-zero while the slot holds a frame in flight
+};
+
+struct FrameCapture {
+    std::string path;
+    bool y4m;
+    FILE* file;
+    int width;
+    int height;
+    int streams;  // Files opened in this run
+    CaptureSlot slots[CAPTURE_PBO_COUNT];
+    int nextSlot;
+
+    // Shared with the encoder thread
+    std::thread encoder;
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::condition_variable frameTaken;
+    std::deque<std::vector<unsigned char> > queue;   // RGBA, rows bottom to top
+    std::vector<std::vector<unsigned char> > spare;  // Recycled frame buffers
+    bool stopping;
+    bool writeFailed;
+
+    int written;
+    int skipped;
+    int readbackWaits;  // Fences not yet signaled when their slot was needed
+    int encoderWaits;   // Frames that found the encoder queue full
+    double encodeMs;
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern FrameCapture g_frameCapture;  // Defined in main.o
+#else
+FrameCapture g_frameCapture;
+#endif
+
+// RGBA (rows bottom to top) to a Y4M frame: Y, U and V planes, top to bottom,
+// BT.601 studio range
+inline void encodeY4MFrame(const unsigned char* rgba, int width, int height, unsigned char* out) {
+    size_t planeBytes = (size_t)width * height;
+    unsigned char* yPlane = out;
+    unsigned char* uPlane = out + planeBytes;
+    unsigned char* vPlane = out + 2 * planeBytes;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* src = rgba + (size_t)(height - 1 - y) * width * 4;
+        size_t row = (size_t)y * width;
+        for (int x = 0; x < width; x++, src += 4) {
+            int r = src[0], g = src[1], b = src[2];
+            yPlane[row + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            uPlane[row + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[row + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+// RGBA (rows bottom to top) to PPM pixel data: RGB, top to bottom
+inline void encodePPMFrame(const unsigned char* rgba, int width, int height, unsigned char* out) {
+    for (int y = 0; y < height; y++) {
+        const unsigned char* src = rgba + (size_t)(height - 1 - y) * width * 4;
+        for (int x = 0; x < width; x++, src += 4, out += 3) {
+            out[0] = src[0];
+            out[1] = src[1];
+            out[2] = src[2];
+        }
+    }
+}
+
+// Encoder thread: convert and write queued frames until stopped and drained
+inline void runCaptureEncoder(FrameCapture* capture) {
+    FrameCapture& c = *capture;
+    size_t pixels = (size_t)c.width * c.height;
+    std::vector<unsigned char> encoded(pixels * 3);
+    char header[64];
+    int headerBytes = c.y4m ? snprintf(header, sizeof(header), "FRAME\n")
+                            : snprintf(header, sizeof(header), "P6\n%d %d\n255\n", c.width, c.height);
+
+    for (;;) {
+        std::vector<unsigned char> frame;
+        {
+            std::unique_lock<std::mutex> lock(c.mutex);
+            c.frameReady.wait(lock, [&] { return c.stopping || !c.queue.empty(); });
+            if (c.queue.empty()) return;
+            frame.swap(c.queue.front());
+            c.queue.pop_front();
+        }
+        c.frameTaken.notify_one();
+
+        double start = wallTimeMs();
+        if (c.y4m)
+            encodeY4MFrame(frame.data(), c.width, c.height, encoded.data());
+        else
+            encodePPMFrame(frame.data(), c.width, c.height, encoded.data());
+        bool ok = fwrite(header, 1, headerBytes, c.file) == (size_t)headerBytes &&
+                  fwrite(encoded.data(), 1, encoded.size(), c.file) == encoded.size();
+
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.encodeMs += wallTimeMs() - start;
+        if (ok) c.written++;
+        else c.writeFailed = true;
+        c.spare.push_back(std::vector<unsigned char>());
+        c.spare.back().swap(frame);
+    }
+}
+
+// Start a capture for the next activity; its file is opened at the first frame
+inline void beginFrameCapture(const char* path, const char* frameTag) {
+    FrameCapture& c = g_frameCapture;
+    c.path = path;
+    if (c.streams > 0) {
+        // Later activities: FILE_activityN.ext
+        size_t dot = c.path.find_last_of('.');
+        size_t slash = c.path.find_last_of('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = c.path.size();
+        c.path.insert(dot, std::string("_") + frameTag);
+    }
+    size_t length = c.path.size();
+    c.y4m = length >= 4 && c.path.compare(length - 4, 4, ".y4m") == 0;
+    c.file = NULL;
+    c.width = c.height = 0;
+    c.nextSlot = 0;
+    for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+        c.slots[i].pbo = 0;
+        c.slots[i].fence = 0;
+    }
+    c.stopping = false;
+    c.writeFailed = false;
+    c.written = c.skipped = 0;
+    c.readbackWaits = c.encoderWaits = 0;
+    c.encodeMs = 0.0;
+}
+
+// Open the file and start the encoder at the first frame's size
+inline bool openFrameCapture(FrameCapture& c, int width, int height) {
+    c.file = fopen(c.path.c_str(), "wb");
+    if (!c.file) {
+        fprintf(stderr, "Failed to open '%s' for writing, capture disabled\n", c.path.c_str());
+        return false;
+    }
+    c.streams++;
+    c.width = width;
+    c.height = height;
+    if (c.y4m) fprintf(c.file, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 C444\n", width, height);
+
+    if (!g_softGL.active) {
+        size_t frameBytes = (size_t)width * height * 4;
+        for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+            glGenBuffers(1, &c.slots[i].pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, c.slots[i].pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    c.encoder = std::thread(runCaptureEncoder, &c);
+    return true;
+}
+
+// A buffer for one RGBA frame, recycled from the encoder when possible.
+// Waits while CAPTURE_QUEUE_FRAMES frames are already queued.
+inline std::vector<unsigned char> takeCaptureBuffer(FrameCapture& c) {
+    std::vector<unsigned char> frame;
+    std::unique_lock<std::mutex> lock(c.mutex);
+    if ((int)c.queue.size() >= CAPTURE_QUEUE_FRAMES) {
+        c.encoderWaits++;
+        c.frameTaken.wait(lock, [&] { return (int)c.queue.size() < CAPTURE_QUEUE_FRAMES; });
+    }
+    if (!c.spare.empty()) {
+        frame.swap(c.spare.back());
+        c.spare.pop_back();
+    }
+    frame.resize((size_t)c.width * c.height * 4);
+    return frame;
+}
+
+inline void queueCaptureFrame(FrameCapture& c, std::vector<unsigned char>& frame) {
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.queue.push_back(std::vector<unsigned char>());
+        c.queue.back().swap(frame);
+    }
+    c.frameReady.notify_one();
+}
+
+// Map a slot's finished readback and pass it to the encoder
+inline void collectCaptureSlot(FrameCapture& c, CaptureSlot& slot) {
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        c.readbackWaits++;
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);  // 1 s
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    std::vector<unsigned char> frame = takeCaptureBuffer(c);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.size(), GL_MAP_READ_BIT);
+    if (pixels) {
+        memcpy(frame.data(), pixels, frame.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        queueCaptureFrame(c, frame);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// Start reading back the frame that was just rendered
+inline void captureFrame(int width, int height) {
+    FrameCapture& c = g_frameCapture;
+    if (c.path.empty()) return;
+    if (!c.file && !openFrameCapture(c, width, height)) {
+        c.path.clear();
+        return;
+    }
+    if (width != c.width || height != c.height) {
+        c.skipped++;
+        return;
+    }
+
+    if (g_softGL.active) {
+        std::vector<unsigned char> frame = takeCaptureBuffer(c);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, frame.data());
+        queueCaptureFrame(c, frame);
+        return;
+    }
+
+    // The slot's previous frame was read back CAPTURE_PBO_COUNT - 1 frames ago
+    CaptureSlot& slot = c.slots[c.nextSlot];
+    if (slot.fence) collectCaptureSlot(c, slot);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    c.nextSlot = (c.nextSlot + 1) % CAPTURE_PBO_COUNT;
+}
+
+// Collect the frames still in flight, let the encoder drain, close the file
+inline void finishFrameCapture() {
+    FrameCapture& c = g_frameCapture;
+    if (c.file) {
+        if (!g_softGL.active) {
+            for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+                CaptureSlot& slot = c.slots[(c.nextSlot + i) % CAPTURE_PBO_COUNT];
+                if (slot.fence) collectCaptureSlot(c, slot);
+                glDeleteBuffers(1, &slot.pbo);
+                slot.pbo = 0;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(c.mutex);
+            c.stopping = true;
+        }
+        c.frameReady.notify_one();
+        c.encoder.join();
+        fclose(c.file);
+        c.file = NULL;
+
+        printf("Capture: %d frames to %s (%s %dx%d), encoder %.2f ms/frame, %d readback waits, %d encoder waits\n",
+               c.written, c.path.c_str(), c.y4m ? "Y4M" : "PPM stream", c.width, c.height,
+               c.written > 0 ? c.encodeMs / c.written : 0.0, c.readbackWaits, c.encoderWaits);
+        if (c.skipped > 0)
+            fprintf(stderr, "Capture: skipped %d frames after the size changed\n", c.skipped);
+        if (c.writeFailed)
+            fprintf(stderr, "Capture: failed writing '%s'\n", c.path.c_str());
+    }
+    c.path.clear();
+    c.queue.clear();
+    c.spare.clear();
+}
+
+#endif // FRAME_CAPTURE_H
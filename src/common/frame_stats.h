@@ -0,0 +1,137 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+/*
+ * Frame timing for benchmark runs
+ * Records wall-clock and process CPU time between consecutive presented frames
+ * and reduces them to min/p50/p99/max, CPU time per frame and FPS.
+ */
+
+// Process CPU time in milliseconds (all threads)
+inline double cpuTimeMs() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+}
+
+// Monotonic wall-clock time in milliseconds
+inline double wallTimeMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct FrameStats {
+    bool enabled;
+    double lastWallMs;
+    double lastCpuMs;
+    std::vector<double> wallMs;  // Per-frame wall-clock time
+    std::vector<double> cpuMs;   // Per-frame process CPU time
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern FrameStats g_frameStats;  // Defined in main.o
+#else
+FrameStats g_frameStats = { false, 0.0, 0.0, std::vector<double>(), std::vector<double>() };
+#endif
+
+// Start a new measurement; the first frame interval begins now
+inline void beginFrameStats(int expectedFrames) {
+    g_frameStats.wallMs.clear();
+    g_frameStats.cpuMs.clear();
+    g_frameStats.wallMs.reserve(expectedFrames);
+    g_frameStats.cpuMs.reserve(expectedFrames);
+    g_frameStats.lastWallMs = wallTimeMs();
+    g_frameStats.lastCpuMs = cpuTimeMs();
+}
+
+// Close the current frame interval
+inline void recordFrameStats() {
+    double wall = wallTimeMs();
+    double cpu = cpuTimeMs();
+    g_frameStats.wallMs.push_back(wall - g_frameStats.lastWallMs);
+    g_frameStats.cpuMs.push_back(cpu - g_frameStats.lastCpuMs);
+    g_frameStats.lastWallMs = wall;
+    g_frameStats.lastCpuMs = cpu;
+}
+
+struct BenchResult {
+    int activity;
+    int frames;      // Frames measured (the warm-up frame is excluded)
+    double minMs;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+    double meanMs;
+    double cpuMs;    // Mean CPU time per frame
+    double fps;
+};
+
+// Nearest-rank percentile of sorted data
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// Reduce the recorded frames to a result. The first frame carries setup work
+// (buffer uploads, shader compilation) and is dropped when there is more than one.
+inline BenchResult summarizeFrameStats(int activity) {
+    std::vector<double> wall = g_frameStats.wallMs;
+    std::vector<double> cpu = g_frameStats.cpuMs;
+    if (wall.size() > 1) {
+        wall.erase(wall.begin());
+        cpu.erase(cpu.begin());
+    }
+
+    BenchResult result = { activity, (int)wall.size(), 0, 0, 0, 0, 0, 0, 0 };
+    if (wall.empty()) return result;
+
+    double wallTotal = 0.0, cpuTotal = 0.0;
+    for (size_t i = 0; i < wall.size(); i++) {
+        wallTotal += wall[i];
+        cpuTotal += cpu[i];
+    }
+
+    std::sort(wall.begin(), wall.end());
+    result.minMs = wall.front();
+    result.p50Ms = percentile(wall, 50.0);
+    result.p99Ms = percentile(wall, 99.0);
+    result.maxMs = wall.back();
+    result.meanMs = wallTotal / wall.size();
+    result.cpuMs = cpuTotal / cpu.size();
+    result.fps = wallTotal > 0.0 ? wall.size() * 1000.0 / wallTotal : 0.0;
+    return result;
+}
+
+inline void printBenchTable(const std::vector<BenchResult>& results) {
+    printf("\n");
+    printf("Activity  Frames    min ms    p50 ms    p99 ms    max ms  CPU ms/frame        FPS\n");
+    printf("--------  ------  --------  --------  --------  --------  ------------  ---------\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        printf("%8d  %6d  %8.3f  %8.3f  %8.3f  %8.3f  %12.3f  %9.1f\n",
+               r.activity, r.frames, r.minMs, r.p50Ms, r.p99Ms, r.maxMs, r.cpuMs, r.fps);
+    }
+    printf("\n");
+}
+
+inline void writeBenchJson(FILE* out, const std::vector<BenchResult>& results) {
+    fprintf(out, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\"activity\": %d, \"frames\": %d, "
+                     "\"wall_ms\": {\"min\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"mean\": %.4f}, "
+                     "\"cpu_ms_per_frame\": %.4f, \"fps\": %.2f}%s\n",
+                r.activity, r.frames, r.minMs, r.p50Ms, r.p99Ms, r.maxMs, r.meanMs,
+                r.cpuMs, r.fps, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+#endif // FRAME_STATS_H
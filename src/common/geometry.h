@@ -0,0 +1,224 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <math.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+/*
+ * Circle, disc and ring vertices written into caller-provided storage.
+ *
+ * Every writer takes a stride in floats and fills (x, y, z) at the start of
+ * each vertex, so positions can be interleaved with colors or other
+ * attributes. Nothing is allocated; size the storage with the *VertexCount
+ * helpers. Angles come from one shared cos/sin table instead of per-vertex
+ * trig calls, which is why segment counts must divide CIRCLE_TABLE_SIZE.
+ *
+ * Icospheres are the exception: they are built once per level of detail
+ * into vectors (positions plus 16-bit triangle indices).
+ */
+
+// 1200 = 2^4 * 3 * 5^2: divisible by 8, 10, 12, 15, 16, 20, 24, 25, 30, 40, 48, 50, 60, ...
+const int CIRCLE_TABLE_SIZE = 1200;
+const int CIRCLE_MIN_SEGMENTS = 8;
+const int CIRCLE_MAX_SEGMENTS = 400;
+
+// cos/sin of 2*pi*i/CIRCLE_TABLE_SIZE; entry CIRCLE_TABLE_SIZE repeats entry 0
+struct CircleTable {
+    float cosTable[CIRCLE_TABLE_SIZE + 1];
+    float sinTable[CIRCLE_TABLE_SIZE + 1];
+
+    CircleTable() {
+        for (int i = 0; i < CIRCLE_TABLE_SIZE; i++) {
+            double angle = 2.0 * M_PI * i / CIRCLE_TABLE_SIZE;
+            cosTable[i] = (float)cos(angle);
+            sinTable[i] = (float)sin(angle);
+        }
+        cosTable[CIRCLE_TABLE_SIZE] = cosTable[0];
+        sinTable[CIRCLE_TABLE_SIZE] = sinTable[0];
+    }
+};
+
+// Built on first use (thread-safe static initialization)
+inline const CircleTable& circleTable() {
+    static const CircleTable table;
+    return table;
+}
+
+// Smallest table-compatible segment count >= segments, within the LOD limits
+inline int snapCircleSegments(int segments) {
+    if (segments < CIRCLE_MIN_SEGMENTS) segments = CIRCLE_MIN_SEGMENTS;
+    if (segments > CIRCLE_MAX_SEGMENTS) segments = CIRCLE_MAX_SEGMENTS;
+    while (CIRCLE_TABLE_SIZE % segments != 0) segments++;
+    return segments;
+}
+
+// Radius in pixels of a circle of the given world radius, when unitsAcross
+// world units span pixelsAcross pixels (e.g. 2 NDC units over the window width)
+inline float projectedRadiusPixels(float radius, float unitsAcross, int pixelsAcross) {
+    return radius * pixelsAcross / unitsAcross;
+}
+
+// LOD: fewest segments whose chords stay within maxErrorPixels of the true
+// circle (sagitta r * (1 - cos(pi / n)) <= maxError)
+inline int circleSegmentsForRadius(float radiusPixels, float maxErrorPixels = 0.25f) {
+    if (radiusPixels <= maxErrorPixels)
+        return snapCircleSegments(CIRCLE_MIN_SEGMENTS);
+    double halfAngle = acos(1.0 - maxErrorPixels / radiusPixels);
+    return snapCircleSegments((int)ceil(M_PI / halfAngle));
+}
+
+// Vertex counts for each primitive
+inline int discVertexCount(int segments) { return segments + 2; }           // GL_TRIANGLE_FAN, closed
+inline int ringVertexCount(int segments) { return 2 * (segments + 1); }     // GL_TRIANGLE_STRIP, closed
+inline int circleOutlineVertexCount(int segments) { return segments; }      // GL_LINE_LOOP
+
+// Filled disc as a triangle fan: center, then segments + 1 rim vertices
+inline int writeDisc(float* out, int stride, int segments,
+                     float centerX, float centerY, float centerZ, float radius) {
+    const CircleTable& table = circleTable();
+    int step = CIRCLE_TABLE_SIZE / segments;
+
+    out[0] = centerX;
+    out[1] = centerY;
+    out[2] = centerZ;
+    out += stride;
+
+    for (int i = 0; i <= segments; i++, out += stride) {
+        out[0] = centerX + table.cosTable[i * step] * radius;
+        out[1] = centerY + table.sinTable[i * step] * radius;
+        out[2] = centerZ;
+    }
+    return discVertexCount(segments);
+}
+
+// Ring as a triangle strip: alternating inner and outer vertices
+inline int writeRing(float* out, int stride, int segments, float centerX, float centerY, float centerZ,
+                     float innerRadius, float outerRadius) {
+    const CircleTable& table = circleTable();
+    int step = CIRCLE_TABLE_SIZE / segments;
+
+    for (int i = 0; i <= segments; i++) {
+        float c = table.cosTable[i * step];
+        float s = table.sinTable[i * step];
+
+        out[0] = centerX + c * innerRadius;
+        out[1] = centerY + s * innerRadius;
+        out[2] = centerZ;
+        out += stride;
+
+        out[0] = centerX + c * outerRadius;
+        out[1] = centerY + s * outerRadius;
+        out[2] = centerZ;
+        out += stride;
+    }
+    return ringVertexCount(segments);
+}
+
+// Circle outline for GL_LINE_LOOP (no repeated closing vertex)
+inline int writeCircleOutline(float* out, int stride, int segments,
+                              float centerX, float centerY, float centerZ, float radius) {
+    const CircleTable& table = circleTable();
+    int step = CIRCLE_TABLE_SIZE / segments;
+
+    for (int i = 0; i < segments; i++, out += stride) {
+        out[0] = centerX + table.cosTable[i * step] * radius;
+        out[1] = centerY + table.sinTable[i * step] * radius;
+        out[2] = centerZ;
+    }
+    return circleOutlineVertexCount(segments);
+}
+
+// Fill a per-vertex attribute (e.g. an RGB color at offset 3) for count vertices
+inline void fillVertexAttribute(float* out, int stride, int count, int offset, const float* values, int size) {
+    for (int i = 0; i < count; i++, out += stride) {
+        for (int c = 0; c < size; c++)
+            out[offset + c] = values[c];
+    }
+}
+
+// ---- Icospheres ----
+
+const int ICOSPHERE_MAX_SUBDIVISIONS = 4;  // 2562 vertices; indices stay 16-bit
+
+// Angle between an icosahedron face's center and its corners; each
+// subdivision roughly halves it
+const double ICOSAHEDRON_FACE_ANGLE = 0.65236;
+
+inline int icosphereVertexCount(int subdivisions) { return 10 * (1 << (2 * subdivisions)) + 2; }
+inline int icosphereIndexCount(int subdivisions) { return 60 * (1 << (2 * subdivisions)); }
+
+// Largest on-screen radius at which a level's faces stay within maxErrorPixels
+// of the true sphere (r * (1 - cos(face angle)) <= maxError)
+inline float icosphereMaxRadiusPixels(int subdivisions, float maxErrorPixels = 0.5f) {
+    return (float)(maxErrorPixels / (1.0 - cos(ICOSAHEDRON_FACE_ANGLE / (1 << subdivisions))));
+}
+
+// LOD: fewest subdivisions that are accurate enough, up to ICOSPHERE_MAX_SUBDIVISIONS.
+// Per-object loops should compare against cached icosphereMaxRadiusPixels() values instead.
+inline int icosphereSubdivisionsForRadius(float radiusPixels, float maxErrorPixels = 0.5f) {
+    int subdivisions = 0;
+    while (subdivisions < ICOSPHERE_MAX_SUBDIVISIONS &&
+           radiusPixels > icosphereMaxRadiusPixels(subdivisions, maxErrorPixels))
+        subdivisions++;
+    return subdivisions;
+}
+
+// Unit icosphere: an icosahedron whose triangles are split in four
+// 'subdivisions' times, new vertices pushed out onto the sphere. Positions
+// (x, y, z per vertex) are also the normals; triangles are counter-clockwise
+// seen from outside.
+inline void buildIcosphere(int subdivisions, std::vector<float>& vertices, std::vector<uint16_t>& indices) {
+    const float t = (float)((1.0 + sqrt(5.0)) / 2.0);
+    const float corners[12][3] = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+    const uint16_t faces[60] = {
+        0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+        1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+        3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+        4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+    };
+
+    vertices.clear();
+    vertices.reserve(icosphereVertexCount(subdivisions) * 3);
+    auto addVertex = [&](float x, float y, float z) {
+        float length = sqrtf(x * x + y * y + z * z);
+        vertices.push_back(x / length);
+        vertices.push_back(y / length);
+        vertices.push_back(z / length);
+        return (uint16_t)(vertices.size() / 3 - 1);
+    };
+    for (int i = 0; i < 12; i++)
+        addVertex(corners[i][0], corners[i][1], corners[i][2]);
+    indices.assign(faces, faces + 60);
+
+    for (int level = 0; level < subdivisions; level++) {
+        std::map<uint32_t, uint16_t> midpoints;  // Edge (lower index << 16 | higher) -> new vertex
+        auto midpoint = [&](uint16_t a, uint16_t b) {
+            uint32_t key = a < b ? ((uint32_t)a << 16) | b : ((uint32_t)b << 16) | a;
+            std::map<uint32_t, uint16_t>::iterator found = midpoints.find(key);
+            if (found != midpoints.end()) return found->second;
+            const float* p = &vertices[a * 3];
+            const float* q = &vertices[b * 3];
+            uint16_t index = addVertex(p[0] + q[0], p[1] + q[1], p[2] + q[2]);
+            midpoints[key] = index;
+            return index;
+        };
+
+        std::vector<uint16_t> split;
+        split.reserve(indices.size() * 4);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            uint16_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            uint16_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            const uint16_t children[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+            split.insert(split.end(), children, children + 12);
+        }
+        indices.swap(split);
+    }
+}
+
+#endif // GEOMETRY_H
@@ -0,0 +1,224 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+// Included by opengl_setup.h, after soft_gl.h
+#include <stdio.h>
+
+/*
+ * GL state cache
+ *
+ * A thin layer on top of the soft_gl.h wrappers (the same #define
+ * redirection, see the end of this file) that drops calls which would not
+ * change anything: using the program that is already in use, binding the
+ * vertex array or buffer that is already bound, enabling a capability that
+ * is already on, setting the polygon mode it already has. Render loops keep
+ * setting what they need every frame; only real changes reach the driver
+ * (or the software renderer).
+ *
+ * The cache only knows what went through it, so every new context starts
+ * with all state unknown (resetGLStateCache) and the first call of each kind
+ * is issued. Deleting a bound vertex array or buffer unbinds it, as in GL.
+ * A deleted program stays in use until the next glUseProgram, so the
+ * program is forgotten instead. GL_ELEMENT_ARRAY_BUFFER is vertex array
+ * state: binding a vertex array forgets it. Buffer targets and capabilities
+ * outside the tables below pass straight through.
+ *
+ * Issued and skipped calls are counted per kind; with --gl-stats the host
+ * prints them after each activity (printGLStateStats).
+ */
+
+enum GLStateKind {
+    GL_STATE_PROGRAM,
+    GL_STATE_VERTEX_ARRAY,
+    GL_STATE_BUFFER,
+    GL_STATE_CAPABILITY,
+    GL_STATE_POLYGON_MODE,
+    GL_STATE_KINDS
+};
+
+const char* const GL_STATE_KIND_NAMES[GL_STATE_KINDS] = {
+    "program", "vertex array", "buffer", "capability", "polygon mode"
+};
+
+const GLenum GL_STATE_BUFFER_TARGETS[] = {
+    GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER
+};
+const int GL_STATE_BUFFER_TARGET_COUNT = sizeof(GL_STATE_BUFFER_TARGETS) / sizeof(GL_STATE_BUFFER_TARGETS[0]);
+const int GL_STATE_ELEMENT_BUFFER = 1;  // Index of GL_ELEMENT_ARRAY_BUFFER above
+
+const GLenum GL_STATE_CAPABILITIES[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST };
+const int GL_STATE_CAPABILITY_COUNT = sizeof(GL_STATE_CAPABILITIES) / sizeof(GL_STATE_CAPABILITIES[0]);
+
+const GLuint GL_STATE_UNKNOWN = 0xFFFFFFFFu;  // Binding or mode not known to the cache
+
+struct GLStateCache {
+    GLuint program;
+    GLuint vertexArray;
+    GLuint buffers[GL_STATE_BUFFER_TARGET_COUNT];
+    GLuint capabilities[GL_STATE_CAPABILITY_COUNT];  // GL_TRUE, GL_FALSE or unknown
+    GLuint polygonMode;                              // GL_FRONT_AND_BACK mode or unknown
+    unsigned long long issued[GL_STATE_KINDS];
+    unsigned long long skipped[GL_STATE_KINDS];
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern GLStateCache g_glState;  // Defined in main.o
+#else
+GLStateCache g_glState;
+#endif
+
+// Forget all state (new or destroyed context); counters are kept
+inline void resetGLStateCache() {
+    GLStateCache& s = g_glState;
+    s.program = s.vertexArray = s.polygonMode = GL_STATE_UNKNOWN;
+    for (int i = 0; i < GL_STATE_BUFFER_TARGET_COUNT; i++) s.buffers[i] = GL_STATE_UNKNOWN;
+    for (int i = 0; i < GL_STATE_CAPABILITY_COUNT; i++) s.capabilities[i] = GL_STATE_UNKNOWN;
+}
+
+inline void resetGLStateStats() {
+    for (int k = 0; k < GL_STATE_KINDS; k++)
+        g_glState.issued[k] = g_glState.skipped[k] = 0;
+}
+
+// Record a call; true if it has to be issued (value differs from the cached one)
+inline bool changeGLState(GLStateKind kind, GLuint& cached, GLuint value) {
+    if (cached == value) {
+        g_glState.skipped[kind]++;
+        return false;
+    }
+    cached = value;
+    g_glState.issued[kind]++;
+    return true;
+}
+
+inline int glStateBufferSlot(GLenum target) {
+    for (int i = 0; i < GL_STATE_BUFFER_TARGET_COUNT; i++)
+        if (GL_STATE_BUFFER_TARGETS[i] == target) return i;
+    return -1;
+}
+
+inline int glStateCapabilitySlot(GLenum cap) {
+    for (int i = 0; i < GL_STATE_CAPABILITY_COUNT; i++)
+        if (GL_STATE_CAPABILITIES[i] == cap) return i;
+    return -1;
+}
+
+// "GL state: 12 issued, 3480 skipped (program 4/596, vertex array 4/596, ...)"
+// with issued/skipped per kind, kinds that saw no calls left out
+inline void printGLStateStats() {
+    const GLStateCache& s = g_glState;
+    unsigned long long issued = 0, skipped = 0;
+    for (int k = 0; k < GL_STATE_KINDS; k++) {
+        issued += s.issued[k];
+        skipped += s.skipped[k];
+    }
+    if (issued + skipped == 0) return;
+    printf("GL state: %llu issued, %llu skipped (", issued, skipped);
+    const char* separator = "";
+    for (int k = 0; k < GL_STATE_KINDS; k++) {
+        if (s.issued[k] + s.skipped[k] == 0) continue;
+        printf("%s%s %llu/%llu", separator, GL_STATE_KIND_NAMES[k], s.issued[k], s.skipped[k]);
+        separator = ", ";
+    }
+    printf(" issued/skipped)\n");
+}
+
+// ---- Cached entry points ----
+
+inline void cachedUseProgram(GLuint program) {
+    if (changeGLState(GL_STATE_PROGRAM, g_glState.program, program))
+        softUseProgram(program);
+}
+
+inline void cachedBindVertexArray(GLuint array) {
+    if (changeGLState(GL_STATE_VERTEX_ARRAY, g_glState.vertexArray, array)) {
+        softBindVertexArray(array);
+        g_glState.buffers[GL_STATE_ELEMENT_BUFFER] = GL_STATE_UNKNOWN;
+    }
+}
+
+inline void cachedBindBuffer(GLenum target, GLuint buffer) {
+    int slot = glStateBufferSlot(target);
+    if (slot < 0) {
+        g_glState.issued[GL_STATE_BUFFER]++;
+        softBindBuffer(target, buffer);
+    } else if (changeGLState(GL_STATE_BUFFER, g_glState.buffers[slot], buffer)) {
+        softBindBuffer(target, buffer);
+    }
+}
+
+inline void cachedEnable(GLenum cap) {
+    int slot = glStateCapabilitySlot(cap);
+    if (slot < 0) {
+        g_glState.issued[GL_STATE_CAPABILITY]++;
+        softEnable(cap);
+    } else if (changeGLState(GL_STATE_CAPABILITY, g_glState.capabilities[slot], GL_TRUE)) {
+        softEnable(cap);
+    }
+}
+
+inline void cachedDisable(GLenum cap) {
+    int slot = glStateCapabilitySlot(cap);
+    if (slot < 0) {
+        g_glState.issued[GL_STATE_CAPABILITY]++;
+        softDisable(cap);
+    } else if (changeGLState(GL_STATE_CAPABILITY, g_glState.capabilities[slot], GL_FALSE)) {
+        softDisable(cap);
+    }
+}
+
+// Core profile only accepts GL_FRONT_AND_BACK
+inline void cachedPolygonMode(GLenum face, GLenum mode) {
+    if (face != GL_FRONT_AND_BACK) {
+        g_glState.issued[GL_STATE_POLYGON_MODE]++;
+        g_glState.polygonMode = GL_STATE_UNKNOWN;
+        softPolygonMode(face, mode);
+    } else if (changeGLState(GL_STATE_POLYGON_MODE, g_glState.polygonMode, mode)) {
+        softPolygonMode(face, mode);
+    }
+}
+
+inline void cachedDeleteProgram(GLuint program) {
+    if (program && g_glState.program == program) g_glState.program = GL_STATE_UNKNOWN;
+    softDeleteProgram(program);
+}
+
+inline void cachedDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (arrays[i] && g_glState.vertexArray == arrays[i]) {
+            g_glState.vertexArray = 0;
+            g_glState.buffers[GL_STATE_ELEMENT_BUFFER] = GL_STATE_UNKNOWN;
+        }
+    }
+    softDeleteVertexArrays(n, arrays);
+}
+
+inline void cachedDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        for (int slot = 0; slot < GL_STATE_BUFFER_TARGET_COUNT; slot++)
+            if (buffers[i] && g_glState.buffers[slot] == buffers[i]) g_glState.buffers[slot] = 0;
+    }
+    softDeleteBuffers(n, buffers);
+}
+
+// Route the calls through the cache (soft_gl.h redirected them to its wrappers)
+#undef glUseProgram
+#undef glBindVertexArray
+#undef glBindBuffer
+#undef glEnable
+#undef glDisable
+#undef glPolygonMode
+#undef glDeleteProgram
+#undef glDeleteVertexArrays
+#undef glDeleteBuffers
+#define glUseProgram cachedUseProgram
+#define glBindVertexArray cachedBindVertexArray
+#define glBindBuffer cachedBindBuffer
+#define glEnable cachedEnable
+#define glDisable cachedDisable
+#define glPolygonMode cachedPolygonMode
+#define glDeleteProgram cachedDeleteProgram
+#define glDeleteVertexArrays cachedDeleteVertexArrays
+#define glDeleteBuffers cachedDeleteBuffers
+
+#endif // GL_STATE_H
@@ -0,0 +1,342 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+// Included by opengl_setup.h, after gl_state.h
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Per-frame GL call and upload statistics (--gl-stats FILE)
+ *
+ * Another layer of the #define redirection (soft_gl.h, gl_state.h): draws,
+ * uniform and attribute calls, glBufferData/glBufferSubData and texture
+ * uploads are counted on their way down. Program, binding, capability and
+ * polygon-mode changes are taken from the state cache's own counters, so
+ * "state changes" are the calls that reached GL and "redundant" the ones
+ * gl_state.h dropped. With the option off each wrapper costs one predictable
+ * branch on g_glStats.enabled.
+ *
+ * The host splits the counts into the activity's setup (init) and its frames
+ * (presentFrame). Every frame is a row of FILE as CSV, setup is frame -1; on
+ * exit each activity prints setup, per-frame average and worst frame.
+ * Texture uploads are split by source: client memory, or a pixel unpack
+ * buffer. Which one is bound comes from the state cache. Writes into mapped
+ * buffers (stream_buffer.h, mapped_image.h's upload buffers) bypass these
+ * calls; the stream buffer reports its own bytes.
+ */
+
+enum GLStatsCounter {
+    GL_STATS_DRAWS,
+    GL_STATS_INSTANCES,
+    GL_STATS_VERTICES,
+    GL_STATS_STATE_CHANGES,
+    GL_STATS_REDUNDANT,
+    GL_STATS_UNIFORMS,
+    GL_STATS_BUFFER_DATA_BYTES,
+    GL_STATS_BUFFER_SUB_DATA_BYTES,
+    GL_STATS_TEXTURE_BYTES,
+    GL_STATS_TEXTURE_PBO_BYTES,
+    GL_STATS_COUNTERS
+};
+
+// CSV column and summary row names
+const char* const GL_STATS_COLUMNS[GL_STATS_COUNTERS] = {
+    "draws", "instances", "vertices", "state_changes", "redundant_state", "uniforms",
+    "buffer_data_bytes", "buffer_subdata_bytes", "texture_bytes", "texture_pbo_bytes"
+};
+const char* const GL_STATS_LABELS[GL_STATS_COUNTERS] = {
+    "Draw calls", "Instances", "Vertices", "State changes", "Redundant (skipped)", "Uniform calls",
+    "glBufferData", "glBufferSubData", "Texture uploads", "Texture from PBO"
+};
+const int GL_STATS_FIRST_BYTES = GL_STATS_BUFFER_DATA_BYTES;  // Counters from here on are bytes
+
+struct GLStats {
+    bool enabled;
+    FILE* csv;
+    const char* activity;
+    int frames;
+    unsigned long long current[GL_STATS_COUNTERS];  // Since the last setup/frame boundary
+    unsigned long long setup[GL_STATS_COUNTERS];
+    unsigned long long total[GL_STATS_COUNTERS];    // Sum over frames
+    unsigned long long peak[GL_STATS_COUNTERS];     // Worst frame, per counter
+    unsigned long long stateIssued;                 // State cache totals at the last boundary
+    unsigned long long stateSkipped;
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern GLStats g_glStats;  // Defined in main.o
+#else
+GLStats g_glStats;
+#endif
+
+inline void glStateTotals(unsigned long long& issued, unsigned long long& skipped) {
+    issued = skipped = 0;
+    for (int k = 0; k < GL_STATE_KINDS; k++) {
+        issued += g_glState.issued[k];
+        skipped += g_glState.skipped[k];
+    }
+}
+
+// Start counting for one activity; the CSV file is opened on first use
+inline void beginGLStats(const char* csvPath, const char* activity) {
+    GLStats& s = g_glStats;
+    if (!s.csv) {
+        s.csv = fopen(csvPath, "w");
+        if (!s.csv) {
+            fprintf(stderr, "Cannot write GL statistics to %s\n", csvPath);
+            return;
+        }
+        fprintf(s.csv, "activity,frame");
+        for (int c = 0; c < GL_STATS_COUNTERS; c++) fprintf(s.csv, ",%s", GL_STATS_COLUMNS[c]);
+        fprintf(s.csv, "\n");
+    }
+    s.enabled = true;
+    s.activity = activity;
+    s.frames = 0;
+    memset(s.current, 0, sizeof(s.current));
+    memset(s.setup, 0, sizeof(s.setup));
+    memset(s.total, 0, sizeof(s.total));
+    memset(s.peak, 0, sizeof(s.peak));
+    glStateTotals(s.stateIssued, s.stateSkipped);
+}
+
+// Close the interval since the last boundary into 'counts' and write its CSV row
+inline void takeGLStatsInterval(int frame, unsigned long long counts[GL_STATS_COUNTERS]) {
+    GLStats& s = g_glStats;
+    unsigned long long issued, skipped;
+    glStateTotals(issued, skipped);
+    s.current[GL_STATS_STATE_CHANGES] += issued - s.stateIssued;
+    s.current[GL_STATS_REDUNDANT] += skipped - s.stateSkipped;
+    s.stateIssued = issued;
+    s.stateSkipped = skipped;
+
+    fprintf(s.csv, "%s,%d", s.activity, frame);
+    for (int c = 0; c < GL_STATS_COUNTERS; c++) {
+        counts[c] = s.current[c];
+        fprintf(s.csv, ",%llu", counts[c]);
+    }
+    fprintf(s.csv, "\n");
+    memset(s.current, 0, sizeof(s.current));
+}
+
+// After the activity's init hook
+inline void endGLStatsSetup() {
+    takeGLStatsInterval(-1, g_glStats.setup);
+}
+
+// After each frame's draws (presentFrame)
+inline void endGLStatsFrame(int frameIndex) {
+    GLStats& s = g_glStats;
+    unsigned long long frame[GL_STATS_COUNTERS];
+    takeGLStatsInterval(frameIndex, frame);
+    for (int c = 0; c < GL_STATS_COUNTERS; c++) {
+        s.total[c] += frame[c];
+        if (frame[c] > s.peak[c]) s.peak[c] = frame[c];
+    }
+    s.frames++;
+}
+
+// Counts as numbers (one decimal for averages), byte counters as B/KB/MB
+inline void formatGLStatsValue(int counter, double value, bool average, char* out, size_t size) {
+    if (counter < GL_STATS_FIRST_BYTES) snprintf(out, size, average ? "%.1f" : "%.0f", value);
+    else if (value < 1024.0) snprintf(out, size, "%.0f B", value);
+    else if (value < 1024.0 * 1024.0) snprintf(out, size, "%.1f KB", value / 1024.0);
+    else snprintf(out, size, "%.1f MB", value / (1024.0 * 1024.0));
+}
+
+// Print the activity's summary; calls after the last frame (shutdown) are dropped
+inline void finishGLStats() {
+    GLStats& s = g_glStats;
+    if (!s.enabled) return;
+    s.enabled = false;
+    fflush(s.csv);
+
+    printf("\nGL calls (%s, %d frames)   Setup    Per frame    Worst frame\n", s.activity, s.frames);
+    for (int c = 0; c < GL_STATS_COUNTERS; c++) {
+        char setup[32], average[32], peak[32];
+        formatGLStatsValue(c, (double)s.setup[c], false, setup, sizeof(setup));
+        formatGLStatsValue(c, s.frames ? (double)s.total[c] / s.frames : 0.0, true, average, sizeof(average));
+        formatGLStatsValue(c, (double)s.peak[c], false, peak, sizeof(peak));
+        printf("  %-22s %12s %12s %14s\n", GL_STATS_LABELS[c], setup, average, peak);
+    }
+}
+
+inline void closeGLStats(const char* csvPath) {
+    if (!g_glStats.csv) return;
+    fclose(g_glStats.csv);
+    g_glStats.csv = NULL;
+    printf("GL statistics written to %s\n", csvPath);
+}
+
+// Bytes per pixel of a client-memory texture upload
+inline size_t glStatsPixelBytes(GLenum format, GLenum type) {
+    int components = 4;
+    switch (format) {
+    case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+    case GL_RG: components = 2; break;
+    case GL_RGB: case GL_BGR: components = 3; break;
+    }
+    switch (type) {
+    case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: return components * 4;
+    case GL_HALF_FLOAT: case GL_SHORT: case GL_UNSIGNED_SHORT: return components * 2;
+    default: return components;
+    }
+}
+
+// ---- Counted entry points ----
+
+inline void countGLStats(GLStatsCounter counter, unsigned long long amount = 1) {
+    g_glStats.current[counter] += amount;
+}
+
+inline void countGLDraw(GLsizei vertices, GLsizei instances) {
+    countGLStats(GL_STATS_DRAWS);
+    countGLStats(GL_STATS_INSTANCES, (unsigned long long)instances);
+    countGLStats(GL_STATS_VERTICES, (unsigned long long)vertices * instances);
+}
+
+inline void statsDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    if (g_glStats.enabled) countGLDraw(count, 1);
+    softDrawArrays(mode, first, count);
+}
+
+inline void statsDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+    if (g_glStats.enabled) countGLDraw(count, instanceCount);
+    softDrawArraysInstanced(mode, first, count, instanceCount);
+}
+
+inline void statsDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    if (g_glStats.enabled) countGLDraw(count, 1);
+    softDrawElements(mode, count, type, indices);
+}
+
+inline void statsDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                       GLsizei instanceCount) {
+    if (g_glStats.enabled) countGLDraw(count, instanceCount);
+    softDrawElementsInstanced(mode, count, type, indices, instanceCount);
+}
+
+inline void statsBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    if (g_glStats.enabled && data) countGLStats(GL_STATS_BUFFER_DATA_BYTES, (unsigned long long)size);
+    softBufferData(target, size, data, usage);
+}
+
+inline void statsBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_BUFFER_SUB_DATA_BYTES, (unsigned long long)size);
+    softBufferSubData(target, offset, size, data);
+}
+
+// A texture upload of 'bytes': 'pixels' is client memory, or an offset into
+// the bound pixel unpack buffer. The cache's unknown binding only occurs
+// before the first bind in a context, where GL's default is 0.
+inline void countGLTextureUpload(unsigned long long bytes, const void* pixels) {
+    GLuint unpack = g_glState.buffers[glStateBufferSlot(GL_PIXEL_UNPACK_BUFFER)];
+    if (unpack != 0 && unpack != GL_STATE_UNKNOWN) countGLStats(GL_STATS_TEXTURE_PBO_BYTES, bytes);
+    else if (pixels) countGLStats(GL_STATS_TEXTURE_BYTES, bytes);
+}
+
+inline void statsTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                            GLint border, GLenum format, GLenum type, const void* pixels) {
+    if (g_glStats.enabled)
+        countGLTextureUpload((unsigned long long)width * height * glStatsPixelBytes(format, type), pixels);
+    softTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+inline void statsTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                               GLenum format, GLenum type, const void* pixels) {
+    if (g_glStats.enabled)
+        countGLTextureUpload((unsigned long long)width * height * glStatsPixelBytes(format, type), pixels);
+    softTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+// State the cache does not track: attribute arrays and texture bindings
+inline void statsVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                     GLsizei stride, const void* pointer) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_STATE_CHANGES);
+    softVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+inline void statsEnableVertexAttribArray(GLuint index) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_STATE_CHANGES);
+    softEnableVertexAttribArray(index);
+}
+
+inline void statsVertexAttribDivisor(GLuint index, GLuint divisor) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_STATE_CHANGES);
+    softVertexAttribDivisor(index, divisor);
+}
+
+inline void statsBindTexture(GLenum target, GLuint texture) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_STATE_CHANGES);
+    softBindTexture(target, texture);
+}
+
+inline void statsUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_UNIFORMS);
+    softUniformMatrix4fv(location, count, transpose, value);
+}
+
+inline void statsUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_UNIFORMS);
+    softUniform4f(location, x, y, z, w);
+}
+
+inline void statsUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_UNIFORMS);
+    softUniform3f(location, x, y, z);
+}
+
+inline void statsUniform2f(GLint location, GLfloat x, GLfloat y) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_UNIFORMS);
+    softUniform2f(location, x, y);
+}
+
+inline void statsUniform1f(GLint location, GLfloat x) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_UNIFORMS);
+    softUniform1f(location, x);
+}
+
+inline void statsUniform1i(GLint location, GLint x) {
+    if (g_glStats.enabled) countGLStats(GL_STATS_UNIFORMS);
+    softUniform1i(location, x);
+}
+
+// Route the calls through the counters (soft_gl.h redirected them to its wrappers)
+#undef glDrawArrays
+#undef glDrawArraysInstanced
+#undef glDrawElements
+#undef glDrawElementsInstanced
+#undef glBufferData
+#undef glBufferSubData
+#undef glTexImage2D
+#undef glTexSubImage2D
+#undef glVertexAttribPointer
+#undef glEnableVertexAttribArray
+#undef glVertexAttribDivisor
+#undef glBindTexture
+#undef glUniformMatrix4fv
+#undef glUniform4f
+#undef glUniform3f
+#undef glUniform2f
+#undef glUniform1f
+#undef glUniform1i
+#define glDrawArrays statsDrawArrays
+#define glDrawArraysInstanced statsDrawArraysInstanced
+#define glDrawElements statsDrawElements
+#define glDrawElementsInstanced statsDrawElementsInstanced
+#define glBufferData statsBufferData
+#define glBufferSubData statsBufferSubData
+#define glTexImage2D statsTexImage2D
+#define glTexSubImage2D statsTexSubImage2D
+#define glVertexAttribPointer statsVertexAttribPointer
+#define glEnableVertexAttribArray statsEnableVertexAttribArray
+#define glVertexAttribDivisor statsVertexAttribDivisor
+#define glBindTexture statsBindTexture
+#define glUniformMatrix4fv statsUniformMatrix4fv
+#define glUniform4f statsUniform4f
+#define glUniform3f statsUniform3f
+#define glUniform2f statsUniform2f
+#define glUniform1f statsUniform1f
+#define glUniform1i statsUniform1i
+
+#endif // GL_STATS_H
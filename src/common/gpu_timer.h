@@ -0,0 +1,221 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+// Included by opengl_setup.h, after the GL headers
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "frame_stats.h"
+
+/*
+ * GPU time per named render-loop section (GL_TIME_ELAPSED queries)
+ *
+ * beginGpuSection("name") starts timing the GL commands that follow; the
+ * next beginGpuSection() or endGpuSection() stops it (sections do not nest).
+ * Results are read only after GL_QUERY_RESULT_AVAILABLE reports them, a few
+ * frames later, so timing never stalls the pipeline: frames in flight keep
+ * their queries and new frames take queries from a free list.
+ *
+ * Finished frames are kept as Chrome trace events (--gpu-trace FILE; open it
+ * in chrome://tracing or ui.perfetto.dev). A rolling per-section average is
+ * printed to stderr every GPU_TIMER_REPORT_FRAMES frames. Trace timestamps
+ * are CPU submit times, pushed back so a frame's sections never overlap.
+ */
+
+const int GPU_TIMER_REPORT_FRAMES = 120;
+
+struct GpuSection {
+    const char* name;
+    unsigned int query;
+    double submitUs;  // CPU time the section was issued, since the trace origin
+};
+
+struct GpuTimerFrame {
+    int index;
+    std::vector<GpuSection> sections;
+};
+
+// Sum over the current report window
+struct GpuSectionTotal {
+    std::string name;
+    double totalMs;
+    int count;
+};
+
+struct GpuTimer {
+    bool enabled;
+    bool sectionOpen;
+    int track;        // Trace thread id: one per activity run
+    double originMs;  // wallTimeMs() at the first activity that was timed
+    GpuTimerFrame current;
+    std::vector<GpuTimerFrame> pending;  // Submitted frames waiting for results
+    std::vector<unsigned int> freeQueries;
+    std::vector<std::string> traceEvents;
+    std::vector<GpuSectionTotal> totals;
+    int totalFrames;
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern GpuTimer g_gpuTimer;  // Defined in main.o
+#else
+GpuTimer g_gpuTimer;
+#endif
+
+// Start timing an activity; its sections form one trace track
+inline void beginGpuTimer(const char* trackName) {
+    GpuTimer& timer = g_gpuTimer;
+    if (timer.track == 0) timer.originMs = wallTimeMs();
+    timer.enabled = true;
+    timer.sectionOpen = false;
+    timer.track++;
+    timer.current.sections.clear();
+    timer.pending.clear();
+    timer.totals.clear();
+    timer.totalFrames = 0;
+
+    char event[256];
+    snprintf(event, sizeof(event),
+             "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s GPU\"}}",
+             timer.track, trackName);
+    timer.traceEvents.push_back(event);
+}
+
+inline void endGpuSection() {
+    if (!g_gpuTimer.enabled || !g_gpuTimer.sectionOpen) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    g_gpuTimer.sectionOpen = false;
+}
+
+// name must stay valid until the frame's results are read (string literals)
+inline void beginGpuSection(const char* name) {
+    GpuTimer& timer = g_gpuTimer;
+    if (!timer.enabled) return;
+    endGpuSection();
+
+    GpuSection section;
+    section.name = name;
+    if (timer.freeQueries.empty()) {
+        glGenQueries(1, &section.query);
+    } else {
+        section.query = timer.freeQueries.back();
+        timer.freeQueries.pop_back();
+    }
+    section.submitUs = (wallTimeMs() - timer.originMs) * 1000.0;
+    glBeginQuery(GL_TIME_ELAPSED, section.query);
+    timer.current.sections.push_back(section);
+    timer.sectionOpen = true;
+}
+
+inline void printGpuSectionAverages() {
+    GpuTimer& timer = g_gpuTimer;
+    fprintf(stderr, "GPU ms/frame (last %d frames):", timer.totalFrames);
+    for (size_t i = 0; i < timer.totals.size(); i++)
+        fprintf(stderr, "  %s %.3f", timer.totals[i].name.c_str(), timer.totals[i].totalMs / timer.totalFrames);
+    fprintf(stderr, "\n");
+}
+
+// Turn a frame's query results into trace events and running totals.
+// Frame 0 carries setup work (and llvmpipe times its first query from
+// start-up), so like frame_stats.h it is dropped.
+inline void recordGpuTimerFrame(const GpuTimerFrame& frame) {
+    GpuTimer& timer = g_gpuTimer;
+    if (frame.index == 0) {
+        for (size_t i = 0; i < frame.sections.size(); i++)
+            timer.freeQueries.push_back(frame.sections[i].query);
+        return;
+    }
+
+    double endUs = 0.0;
+    for (size_t i = 0; i < frame.sections.size(); i++) {
+        const GpuSection& section = frame.sections[i];
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(section.query, GL_QUERY_RESULT, &ns);
+        timer.freeQueries.push_back(section.query);
+
+        double ms = ns / 1.0e6;
+        double startUs = section.submitUs > endUs ? section.submitUs : endUs;
+        endUs = startUs + ms * 1000.0;
+
+        char event[256];
+        snprintf(event, sizeof(event),
+                 "{\"name\": \"%s\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                 "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %d}}",
+                 section.name, timer.track, startUs, ms * 1000.0, frame.index);
+        timer.traceEvents.push_back(event);
+
+        size_t t = 0;
+        while (t < timer.totals.size() && timer.totals[t].name != section.name) t++;
+        if (t == timer.totals.size()) {
+            GpuSectionTotal total = { section.name, 0.0, 0 };
+            timer.totals.push_back(total);
+        }
+        timer.totals[t].totalMs += ms;
+        timer.totals[t].count++;
+    }
+
+    if (++timer.totalFrames == GPU_TIMER_REPORT_FRAMES) {
+        printGpuSectionAverages();
+        timer.totals.clear();
+        timer.totalFrames = 0;
+    }
+}
+
+// Close the frame and collect every earlier frame whose results are ready.
+// Queries finish in submission order, so checking a frame's last one is enough.
+inline void endGpuTimerFrame(int frameIndex) {
+    GpuTimer& timer = g_gpuTimer;
+    if (!timer.enabled) return;
+    endGpuSection();
+    if (!timer.current.sections.empty()) {
+        timer.current.index = frameIndex;
+        timer.pending.push_back(timer.current);
+        timer.current.sections.clear();
+    }
+
+    size_t ready = 0;
+    while (ready < timer.pending.size()) {
+        GLint available = 0;
+        glGetQueryObjectiv(timer.pending[ready].sections.back().query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        recordGpuTimerFrame(timer.pending[ready]);
+        ready++;
+    }
+    timer.pending.erase(timer.pending.begin(), timer.pending.begin() + ready);
+}
+
+// Write every event recorded so far as a Chrome trace
+inline bool writeGpuTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to write GPU trace '%s'\n", path);
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (size_t i = 0; i < g_gpuTimer.traceEvents.size(); i++)
+        fprintf(file, "  %s%s\n", g_gpuTimer.traceEvents[i].c_str(), i + 1 < g_gpuTimer.traceEvents.size() ? "," : "");
+    fprintf(file, "]}\n");
+    return fclose(file) == 0;
+}
+
+// Stop timing the activity (before its context goes away): wait for the
+// frames still in flight, report the remainder and write the trace
+inline void finishGpuTimer(const char* tracePath) {
+    GpuTimer& timer = g_gpuTimer;
+    if (!timer.enabled) return;
+    endGpuTimerFrame(-1);
+    for (size_t i = 0; i < timer.pending.size(); i++)
+        recordGpuTimerFrame(timer.pending[i]);  // GL_QUERY_RESULT waits here; shutdown only
+    timer.pending.clear();
+    if (timer.totalFrames > 0) printGpuSectionAverages();
+
+    if (!timer.freeQueries.empty())
+        glDeleteQueries((GLsizei)timer.freeQueries.size(), timer.freeQueries.data());
+    timer.freeQueries.clear();
+    timer.enabled = false;
+
+    if (tracePath && writeGpuTrace(tracePath))
+        printf("GPU trace written to %s\n", tracePath);
+}
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,329 @@
+#ifndef GRADIENT_FILL_H
+#define GRADIENT_FILL_H
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "simd.h"
+#include "thread_pool.h"
+#include "frame_stats.h"
+
+/*
+ * CPU gradient fill (Activity 3)
+ * Fills vertex-colored triangles into an RGB image the way GL rasterizes
+ * them: pixel centers at +0.5, vertices snapped to 1/256 pixel, a
+ * left/bottom fill rule and barycentric color interpolation, rounded to
+ * 8 bits. Rows run bottom to top like glReadPixels output, so a frame read
+ * back from GL can be compared byte for byte.
+ *
+ * fillGradientReference() tests every pixel on its own in double precision.
+ * fillGradient() computes each row's covered span exactly, then steps the
+ * colors across the span 4 pixels at a time (simd.h), with rows split into
+ * bands across threads.
+ */
+
+// Vertex in window coordinates (pixels, y up) with an RGB color in [0, 1]
+struct GradientVertex {
+    float x, y;
+    float r, g, b;
+};
+
+// Set-up triangle: edge functions e = a*px + b*py + c (positive inside) and
+// color planes (d/dx, d/dy, constant), all in pixel units
+struct GradientTriangle {
+    int x0, y0, x1, y1;  // Inclusive pixel bounds
+    double edge[3][3];
+    bool ownsEdge[3];    // Pixels exactly on the edge are inside
+    double color[3][3];
+};
+
+const int GRADIENT_BAND_ROWS = 16;   // Rows per thread-pool chunk
+const int GRADIENT_ANCHOR_SPAN = 256; // Pixels between exact color re-evaluations
+
+// Map vertices (position xyz + color rgb, stride in floats) through a
+// column-major projection matrix and a viewport of width x height pixels
+inline void projectGradientVertices(const float* vertices, int stride, int count, const float projection[16],
+                                    int width, int height, std::vector<GradientVertex>& out) {
+    out.resize(count);
+    for (int i = 0; i < count; i++, vertices += stride) {
+        const float* m = projection;
+        float p[4];
+        for (int r = 0; r < 4; r++)
+            p[r] = m[r] * vertices[0] + m[4 + r] * vertices[1] + m[8 + r] * vertices[2] + m[12 + r];
+        GradientVertex& v = out[i];
+        v.x = (p[0] / p[3] + 1.0f) * 0.5f * width;
+        v.y = (p[1] / p[3] + 1.0f) * 0.5f * height;
+        v.r = vertices[3];
+        v.g = vertices[4];
+        v.b = vertices[5];
+    }
+}
+
+// Set up one triangle for a width x height image; false if it covers no pixel
+inline bool setupGradientTriangle(const GradientVertex& v0, const GradientVertex& v1, const GradientVertex& v2,
+                                  int width, int height, GradientTriangle& tri) {
+    const GradientVertex* v[3] = { &v0, &v1, &v2 };
+    double x[3], y[3];
+    for (int i = 0; i < 3; i++) {
+        x[i] = floor(v[i]->x * 256.0 + 0.5) / 256.0;
+        y[i] = floor(v[i]->y * 256.0 + 0.5) / 256.0;
+    }
+    double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0.0) return false;
+    if (area < 0.0) {  // Make it counter-clockwise
+        const GradientVertex* t = v[1]; v[1] = v[2]; v[2] = t;
+        double tx = x[1]; x[1] = x[2]; x[2] = tx;
+        double ty = y[1]; y[1] = y[2]; y[2] = ty;
+        area = -area;
+    }
+
+    tri.x0 = (int)ceil(fmin(x[0], fmin(x[1], x[2])) - 0.5);
+    tri.x1 = (int)floor(fmax(x[0], fmax(x[1], x[2])) - 0.5);
+    tri.y0 = (int)ceil(fmin(y[0], fmin(y[1], y[2])) - 0.5);
+    tri.y1 = (int)floor(fmax(y[0], fmax(y[1], y[2])) - 0.5);
+    if (tri.x0 < 0) tri.x0 = 0;
+    if (tri.y0 < 0) tri.y0 = 0;
+    if (tri.x1 > width - 1) tri.x1 = width - 1;
+    if (tri.y1 > height - 1) tri.y1 = height - 1;
+    if (tri.x0 > tri.x1 || tri.y0 > tri.y1) return false;
+
+    // Edge i is opposite vertex i; snapped coordinates keep these products exact
+    for (int i = 0; i < 3; i++) {
+        int a = (i + 1) % 3, b = (i + 2) % 3;
+        double dx = x[b] - x[a], dy = y[b] - y[a];
+        tri.edge[i][0] = -dy;
+        tri.edge[i][1] = dx;
+        tri.edge[i][2] = dy * x[a] - dx * y[a];
+        tri.ownsEdge[i] = dy < 0.0 || (dy == 0.0 && dx > 0.0);
+    }
+
+    // Color = sum of vertex colors weighted by edge / area
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) {
+            double sum = 0.0;
+            for (int i = 0; i < 3; i++) {
+                float rgb[3] = { v[i]->r, v[i]->g, v[i]->b };
+                sum += tri.edge[i][k] * rgb[c];
+            }
+            tri.color[c][k] = sum / area;
+        }
+    }
+    return true;
+}
+
+// Set up every triangle of a vertex list (3 vertices each)
+inline void setupGradientTriangles(const std::vector<GradientVertex>& vertices, int width, int height,
+                                   std::vector<GradientTriangle>& triangles) {
+    triangles.clear();
+    GradientTriangle tri;
+    for (size_t i = 0; i + 2 < vertices.size(); i += 3) {
+        if (setupGradientTriangle(vertices[i], vertices[i + 1], vertices[i + 2], width, height, tri))
+            triangles.push_back(tri);
+    }
+}
+
+inline unsigned char gradientByte(double value) {
+    value = value < 0.0 ? 0.0 : (value > 1.0 ? 1.0 : value);
+    return (unsigned char)(value * 255.0 + 0.5);
+}
+
+// Reference: every pixel tested and shaded independently (single thread)
+inline void fillGradientReference(const std::vector<GradientTriangle>& triangles, int width, unsigned char* rgb) {
+    for (size_t t = 0; t < triangles.size(); t++) {
+        const GradientTriangle& tri = triangles[t];
+        for (int y = tri.y0; y <= tri.y1; y++) {
+            double py = y + 0.5;
+            for (int x = tri.x0; x <= tri.x1; x++) {
+                double px = x + 0.5;
+                bool inside = true;
+                for (int e = 0; e < 3 && inside; e++) {
+                    double value = tri.edge[e][0] * px + tri.edge[e][1] * py + tri.edge[e][2];
+                    inside = value > 0.0 || (value == 0.0 && tri.ownsEdge[e]);
+                }
+                if (!inside) continue;
+                unsigned char* p = rgb + ((size_t)y * width + x) * 3;
+                for (int c = 0; c < 3; c++)
+                    p[c] = gradientByte(tri.color[c][0] * px + tri.color[c][1] * py + tri.color[c][2]);
+            }
+        }
+    }
+}
+
+// Covered pixels [xMin, xMax] of row y; false if none
+inline bool gradientRowSpan(const GradientTriangle& tri, int y, int& xMin, int& xMax) {
+    double py = y + 0.5;
+    xMin = tri.x0;
+    xMax = tri.x1;
+    for (int e = 0; e < 3; e++) {
+        double a = tri.edge[e][0];
+        double rest = tri.edge[e][1] * py + tri.edge[e][2];
+        if (a == 0.0) {
+            if (!(rest > 0.0 || (rest == 0.0 && tri.ownsEdge[e]))) return false;
+            continue;
+        }
+        // The edge crosses the row at px = t; pixel centers are x + 0.5
+        double t = -rest / a - 0.5;
+        if (a > 0.0) {
+            int first = tri.ownsEdge[e] ? (int)ceil(t) : (int)floor(t) + 1;
+            if (first > xMin) xMin = first;
+        } else {
+            int last = tri.ownsEdge[e] ? (int)floor(t) : (int)ceil(t) - 1;
+            if (last < xMax) xMax = last;
+        }
+    }
+    return xMin <= xMax;
+}
+
+// Fill rows [rowBegin, rowEnd) of every triangle
+inline void fillGradientRows(const std::vector<GradientTriangle>& triangles, int width, unsigned char* rgb,
+                             int rowBegin, int rowEnd) {
+    const f32x4 laneOffsets = f32x4_set(0.0f, 1.0f, 2.0f, 3.0f);
+    const f32x4 zero = f32x4_set1(0.0f), top = f32x4_set1(255.0f);
+
+    for (size_t t = 0; t < triangles.size(); t++) {
+        const GradientTriangle& tri = triangles[t];
+        int y0 = tri.y0 > rowBegin ? tri.y0 : rowBegin;
+        int y1 = tri.y1 < rowEnd - 1 ? tri.y1 : rowEnd - 1;
+        f32x4 step[3], laneStep[3];
+        for (int c = 0; c < 3; c++) {
+            float dx = (float)(tri.color[c][0] * 255.0);
+            step[c] = f32x4_set1(4.0f * dx);
+            laneStep[c] = f32x4_mul(laneOffsets, f32x4_set1(dx));
+        }
+
+        for (int y = y0; y <= y1; y++) {
+            int xMin, xMax;
+            if (!gradientRowSpan(tri, y, xMin, xMax)) continue;
+            double py = y + 0.5;
+            unsigned char* row = rgb + (size_t)y * width * 3;
+
+            for (int anchor = xMin; anchor <= xMax; anchor += GRADIENT_ANCHOR_SPAN) {
+                int end = anchor + GRADIENT_ANCHOR_SPAN - 1 < xMax ? anchor + GRADIENT_ANCHOR_SPAN - 1 : xMax;
+
+                // Exact values at the anchor pixel, then 4-pixel float steps (+0.5 rounds on truncation)
+                double px = anchor + 0.5;
+                f32x4 value[3];
+                for (int c = 0; c < 3; c++) {
+                    double start = (tri.color[c][0] * px + tri.color[c][1] * py + tri.color[c][2]) * 255.0 + 0.5;
+                    value[c] = f32x4_add(f32x4_set1((float)start), laneStep[c]);
+                }
+
+                for (int x = anchor; x <= end; x += 4) {
+                    unsigned char bytes[3][4];
+                    for (int c = 0; c < 3; c++) {
+                        f32x4_store_u8(bytes[c], f32x4_min(f32x4_max(value[c], zero), top));
+                        value[c] = f32x4_add(value[c], step[c]);
+                    }
+                    int lanes = end - x + 1 < 4 ? end - x + 1 : 4;
+                    unsigned char* p = row + (size_t)x * 3;
+                    for (int k = 0; k < lanes; k++, p += 3) {
+                        p[0] = bytes[0][k];
+                        p[1] = bytes[1][k];
+                        p[2] = bytes[2][k];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Fill all triangles, rows split into bands across the pool (NULL = this thread)
+inline void fillGradient(const std::vector<GradientTriangle>& triangles, int width, int height,
+                         unsigned char* rgb, ThreadPool* pool) {
+    int bands = (height + GRADIENT_BAND_ROWS - 1) / GRADIENT_BAND_ROWS;
+    auto fillBands = [&](size_t begin, size_t end) {
+        int rowEnd = (int)end * GRADIENT_BAND_ROWS;
+        fillGradientRows(triangles, width, rgb, (int)begin * GRADIENT_BAND_ROWS, rowEnd < height ? rowEnd : height);
+    };
+    if (pool)
+        pool->parallelFor(bands, 1, fillBands);
+    else
+        fillBands(0, bands);
+}
+
+// Compare two RGB images: largest channel difference and pixels beyond tolerance
+inline size_t compareRGB(const unsigned char* a, const unsigned char* b, size_t pixels, int tolerance, int& maxDiff) {
+    size_t mismatches = 0;
+    maxDiff = 0;
+    for (size_t i = 0; i < pixels; i++, a += 3, b += 3) {
+        int worst = 0;
+        for (int c = 0; c < 3; c++) {
+            int d = a[c] > b[c] ? a[c] - b[c] : b[c] - a[c];
+            if (d > worst) worst = d;
+        }
+        if (worst > maxDiff) maxDiff = worst;
+        if (worst > tolerance) mismatches++;
+    }
+    return mismatches;
+}
+
+// Activity 3's corner colors on a square covering the whole image
+inline void makeGradientSquare(int width, int height, std::vector<GradientVertex>& vertices) {
+    const float w = (float)width, h = (float)height;
+    GradientVertex corners[4] = {
+        { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f },  // Bottom-left: Red
+        { w,    0.0f, 0.0f, 1.0f, 0.0f },  // Bottom-right: Green
+        { w,    h,    0.0f, 0.0f, 1.0f },  // Top-right: Blue
+        { 0.0f, h,    1.0f, 1.0f, 0.0f }   // Top-left: Yellow
+    };
+    const int order[6] = { 0, 1, 3, 1, 2, 3 };  // Same split as Activity 3's square
+    vertices.resize(6);
+    for (int i = 0; i < 6; i++)
+        vertices[i] = corners[order[i]];
+}
+
+// ./main --bench-cpu gradient: gradient-fill megapixels per second at 4K-16K
+inline void runGradientBenchmark(int frames) {
+    const int sizes[3][2] = { { 3840, 2160 }, { 7680, 4320 }, { 15360, 8640 } };
+    const char* names[3] = { "4K", "8K", "16K" };
+    int maxThreads = hardwareThreads();
+
+    printf("Gradient fill benchmark: %d frames per run, full-frame square\n\n", frames);
+    printf("Size  Threads    Time ms        MP/s   Speedup  Reference max diff\n");
+    printf("----  -------  ---------  ----------  --------  ------------------\n");
+
+    std::vector<GradientVertex> vertices;
+    std::vector<GradientTriangle> triangles;
+    std::vector<unsigned char> image, reference;
+    for (int s = 0; s < 3; s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        makeGradientSquare(width, height, vertices);
+        setupGradientTriangles(vertices, width, height, triangles);
+        image.assign((size_t)width * height * 3, 0);
+
+        // Check the fast path against the reference at the smallest size
+        char check[32] = "-";
+        if (s == 0) {
+            reference.assign(image.size(), 0);
+            fillGradientReference(triangles, width, reference.data());
+            fillGradient(triangles, width, height, image.data(), NULL);
+            int maxDiff;
+            size_t mismatches = compareRGB(image.data(), reference.data(), (size_t)width * height, 1, maxDiff);
+            snprintf(check, sizeof(check), "%d (%zu px > 1)", maxDiff, mismatches);
+            std::vector<unsigned char>().swap(reference);
+        }
+
+        double megapixels = (double)width * height * frames / 1.0e6;
+        double baseline = 0.0;
+        for (int threads = 1; ; threads *= 2) {
+            if (threads > maxThreads) threads = maxThreads;
+            ThreadPool pool(threads);
+
+            fillGradient(triangles, width, height, image.data(), &pool);  // Warm-up
+            double start = wallTimeMs();
+            for (int f = 0; f < frames; f++)
+                fillGradient(triangles, width, height, image.data(), &pool);
+            double elapsed = wallTimeMs() - start;
+
+            double rate = megapixels / (elapsed / 1000.0);
+            if (threads == 1) baseline = rate;
+            printf("%4s  %7d  %9.2f  %10.1f  %7.2fx  %s\n", names[s], threads, elapsed, rate,
+                   rate / baseline, threads == 1 ? check : "");
+
+            if (threads == maxThreads) break;
+        }
+    }
+    printf("\n");
+}
+
+#endif // GRADIENT_FILL_H
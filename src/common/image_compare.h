@@ -0,0 +1,182 @@
+#ifndef IMAGE_COMPARE_H
+#define IMAGE_COMPARE_H
+
+#include <math.h>
+#include <vector>
+#include "simd.h"
+#include "image_io.h"
+
+/*
+ * Image comparison for the golden-image regression suite (--regress)
+ * One pass over two RGB images, 4 pixels at a time (simd.h), accumulates the
+ * squared error for PSNR, counts pixels whose largest channel difference is
+ * above a tolerance, and writes both images' luma and the per-pixel error.
+ * SSIM is then computed on the luma planes over 8x8 windows placed every
+ * 4 pixels, each window row loaded as two f32x4.
+ */
+
+const int SSIM_WINDOW = 8;
+const int SSIM_STEP = 4;
+
+struct ImageDiff {
+    double psnr;          // dB over all RGB samples (INFINITY when identical)
+    double ssim;          // Mean SSIM of the luma windows, 1 = identical
+    int maxError;         // Largest channel difference
+    size_t badPixels;     // Pixels with a channel difference above the tolerance
+    size_t pixels;
+};
+
+// Sum of the four lanes
+inline float f32x4_sum(f32x4 a) {
+    float v[4];
+    f32x4_store(v, a);
+    return (v[0] + v[1]) + (v[2] + v[3]);
+}
+
+// Crop a region of src and shrink it by an integer factor (box filter).
+// Golden screenshots taken on a 2x display are brought to framebuffer size this way.
+inline bool cropAndShrink(const Image& src, int x0, int y0, int width, int height, int scale, Image& dst) {
+    if (scale < 1 || x0 < 0 || y0 < 0 || x0 + width * scale > src.width || y0 + height * scale > src.height)
+        return false;
+    int channels = src.channels;
+    allocateImage(dst, width, height, channels);
+    int area = scale * scale;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < channels; c++) {
+                int sum = 0;
+                for (int dy = 0; dy < scale; dy++) {
+                    const unsigned char* row = &src.pixels[((size_t)(y0 + y * scale + dy) * src.width + x0 + x * scale) * channels];
+                    for (int dx = 0; dx < scale; dx++)
+                        sum += row[dx * channels + c];
+                }
+                dst.pixels[((size_t)y * width + x) * channels + c] = (unsigned char)((sum + area / 2) / area);
+            }
+        }
+    }
+    return true;
+}
+
+// Mean SSIM over the luma planes (values in [0, 255])
+inline double computeSSIM(const std::vector<float>& lumaA, const std::vector<float>& lumaB, int width, int height) {
+    const float c1 = (0.01f * 255.0f) * (0.01f * 255.0f);
+    const float c2 = (0.03f * 255.0f) * (0.03f * 255.0f);
+    const float n = (float)(SSIM_WINDOW * SSIM_WINDOW);
+    double total = 0.0;
+    int windows = 0;
+
+    for (int wy = 0; wy + SSIM_WINDOW <= height; wy += SSIM_STEP) {
+        for (int wx = 0; wx + SSIM_WINDOW <= width; wx += SSIM_STEP) {
+            f32x4 sa = f32x4_set1(0.0f), sb = sa, saa = sa, sbb = sa, sab = sa;
+            for (int y = wy; y < wy + SSIM_WINDOW; y++) {
+                const float* a = &lumaA[(size_t)y * width + wx];
+                const float* b = &lumaB[(size_t)y * width + wx];
+                for (int x = 0; x < SSIM_WINDOW; x += SIMD_WIDTH) {
+                    f32x4 va = f32x4_load(a + x);
+                    f32x4 vb = f32x4_load(b + x);
+                    sa = f32x4_add(sa, va);
+                    sb = f32x4_add(sb, vb);
+                    saa = f32x4_add(saa, f32x4_mul(va, va));
+                    sbb = f32x4_add(sbb, f32x4_mul(vb, vb));
+                    sab = f32x4_add(sab, f32x4_mul(va, vb));
+                }
+            }
+            float meanA = f32x4_sum(sa) / n;
+            float meanB = f32x4_sum(sb) / n;
+            float varA = f32x4_sum(saa) / n - meanA * meanA;
+            float varB = f32x4_sum(sbb) / n - meanB * meanB;
+            float cov = f32x4_sum(sab) / n - meanA * meanB;
+            total += ((2.0f * meanA * meanB + c1) * (2.0f * cov + c2)) /
+                     ((meanA * meanA + meanB * meanB + c1) * (varA + varB + c2));
+            windows++;
+        }
+    }
+    return windows > 0 ? total / windows : 1.0;
+}
+
+// Compare two RGB images of the same size. If 'diff' is given it receives a
+// picture of the differences: the expected image faded, pixels within the
+// tolerance that differ in orange, pixels beyond it in red.
+inline ImageDiff compareImages(const Image& actual, const Image& expected, int tolerance, Image* diff) {
+    int width = actual.width, height = actual.height;
+    size_t pixels = (size_t)width * height;
+    std::vector<float> lumaA(pixels), lumaB(pixels), error(pixels);
+
+    const f32x4 zero = f32x4_set1(0.0f);
+    const f32x4 limit = f32x4_set1((float)tolerance);
+    const f32x4 kr = f32x4_set1(0.299f), kg = f32x4_set1(0.587f), kb = f32x4_set1(0.114f);
+    f32x4 squared = zero, worst = zero;
+    size_t bad = 0;
+
+    const unsigned char* a = actual.pixels.data();
+    const unsigned char* b = expected.pixels.data();
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= pixels; i += SIMD_WIDTH, a += 3 * SIMD_WIDTH, b += 3 * SIMD_WIDTH) {
+        // Deinterleave 4 RGB pixels into channel vectors
+        f32x4 ar = f32x4_set(a[0], a[3], a[6], a[9]);
+        f32x4 ag = f32x4_set(a[1], a[4], a[7], a[10]);
+        f32x4 ab = f32x4_set(a[2], a[5], a[8], a[11]);
+        f32x4 br = f32x4_set(b[0], b[3], b[6], b[9]);
+        f32x4 bg = f32x4_set(b[1], b[4], b[7], b[10]);
+        f32x4 bb = f32x4_set(b[2], b[5], b[8], b[11]);
+
+        f32x4 dr = f32x4_sub(ar, br), dg = f32x4_sub(ag, bg), db = f32x4_sub(ab, bb);
+        squared = f32x4_add(squared, f32x4_add(f32x4_mul(dr, dr), f32x4_add(f32x4_mul(dg, dg), f32x4_mul(db, db))));
+        f32x4 absR = f32x4_max(dr, f32x4_sub(zero, dr));
+        f32x4 absG = f32x4_max(dg, f32x4_sub(zero, dg));
+        f32x4 absB = f32x4_max(db, f32x4_sub(zero, db));
+        f32x4 pixelError = f32x4_max(absR, f32x4_max(absG, absB));
+        worst = f32x4_max(worst, pixelError);
+        int mask = f32x4_movemask(f32x4_cmpgt(pixelError, limit));
+        bad += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+
+        f32x4_store(&error[i], pixelError);
+        f32x4_store(&lumaA[i], f32x4_add(f32x4_mul(kr, ar), f32x4_add(f32x4_mul(kg, ag), f32x4_mul(kb, ab))));
+        f32x4_store(&lumaB[i], f32x4_add(f32x4_mul(kr, br), f32x4_add(f32x4_mul(kg, bg), f32x4_mul(kb, bb))));
+    }
+
+    // Leftover pixels
+    double squaredSum = f32x4_sum(squared);
+    float worstValue = 0.0f;
+    float lanes[4];
+    f32x4_store(lanes, worst);
+    for (int l = 0; l < 4; l++) worstValue = lanes[l] > worstValue ? lanes[l] : worstValue;
+    for (; i < pixels; i++, a += 3, b += 3) {
+        float pixelError = 0.0f;
+        for (int c = 0; c < 3; c++) {
+            float d = (float)a[c] - (float)b[c];
+            squaredSum += d * d;
+            pixelError = fabsf(d) > pixelError ? fabsf(d) : pixelError;
+        }
+        worstValue = pixelError > worstValue ? pixelError : worstValue;
+        if (pixelError > tolerance) bad++;
+        error[i] = pixelError;
+        lumaA[i] = 0.299f * a[0] + 0.587f * a[1] + 0.114f * a[2];
+        lumaB[i] = 0.299f * b[0] + 0.587f * b[1] + 0.114f * b[2];
+    }
+
+    ImageDiff result;
+    double mse = squaredSum / (3.0 * pixels);
+    result.psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+    result.ssim = computeSSIM(lumaA, lumaB, width, height);
+    result.maxError = (int)worstValue;
+    result.badPixels = bad;
+    result.pixels = pixels;
+
+    if (diff) {
+        allocateImage(*diff, width, height, 3);
+        for (size_t p = 0; p < pixels; p++) {
+            unsigned char* out = &diff->pixels[p * 3];
+            unsigned char faded = (unsigned char)(191.0f + lumaB[p] * 0.25f);
+            out[0] = out[1] = out[2] = faded;
+            if (error[p] > tolerance) {
+                out[0] = 255; out[1] = 0; out[2] = 0;
+            } else if (error[p] > 0.0f) {
+                out[0] = 255; out[1] = 160; out[2] = 0;
+            }
+        }
+    }
+    return result;
+}
+
+#endif // IMAGE_COMPARE_H
@@ -0,0 +1,224 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+#include <zlib.h>
+
+// 8-bit image, rows top to bottom, channels interleaved (1 = gray, 3 = RGB)
+struct Image {
+    int width;
+    int height;
+    int channels;
+    std::vector<unsigned char> pixels;
+};
+
+inline void allocateImage(Image& image, int width, int height, int channels) {
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize((size_t)width * height * channels);
+}
+
+// Create an output directory (existing directories are fine)
+inline bool ensureDirectory(const char* path) {
+    if (mkdir(path, 0755) == 0 || errno == EEXIST)
+        return true;
+    fprintf(stderr, "Failed to create directory '%s'\n", path);
+    return false;
+}
+
+// Write 8-bit RGB pixels as a binary PPM (P6) file.
+// GL framebuffers are stored bottom-up, so pass flipY = true for glReadPixels data.
+inline bool writePPM(const char* path, int width, int height, const unsigned char* rgb, bool flipY) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open '%s' for writing\n", path);
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+    size_t rowBytes = (size_t)width * 3;
+    bool ok = true;
+    for (int y = 0; y < height && ok; y++) {
+        int srcRow = flipY ? (height - 1 - y) : y;
+        ok = fwrite(rgb + (size_t)srcRow * rowBytes, 1, rowBytes, file) == rowBytes;
+    }
+
+    fclose(file);
+    if (!ok) fprintf(stderr, "Failed to write '%s'\n", path);
+    return ok;
+}
+
+// Write an Image as PGM (P5, 1 channel) or PPM (P6, 3 channels)
+inline bool writePNM(const char* path, const Image& image) {
+    if (image.channels == 3)
+        return writePPM(path, image.width, image.height, image.pixels.data(), false);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open '%s' for writing\n", path);
+        return false;
+    }
+    fprintf(file, "P5\n%d %d\n255\n", image.width, image.height);
+    bool ok = fwrite(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+    fclose(file);
+    if (!ok) fprintf(stderr, "Failed to write '%s'\n", path);
+    return ok;
+}
+
+// Read the next header number, skipping whitespace and # comments
+inline bool readPNMNumber(FILE* file, int& value) {
+    int c = fgetc(file);
+    while (c != EOF && (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '#')) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fgetc(file);
+        }
+        c = fgetc(file);
+    }
+    if (c < '0' || c > '9') return false;
+
+    value = 0;
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (c - '0');
+        c = fgetc(file);
+    }
+    return true;  // The single whitespace after the number has been consumed
+}
+
+// Read a binary 8-bit PGM (P5) or PPM (P6)
+inline bool readPNM(const char* path, Image& image) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open '%s'\n", path);
+        return false;
+    }
+
+    char magic[2];
+    int width, height, maxValue;
+    bool ok = fread(magic, 1, 2, file) == 2 && magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6') &&
+              readPNMNumber(file, width) && readPNMNumber(file, height) &&
+              readPNMNumber(file, maxValue) && maxValue == 255 && width > 0 && height > 0;
+    if (!ok) {
+        fprintf(stderr, "'%s' is not an 8-bit binary PGM/PPM file\n", path);
+        fclose(file);
+        return false;
+    }
+
+    allocateImage(image, width, height, magic[1] == '6' ? 3 : 1);
+    ok = fread(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+    fclose(file);
+    if (!ok) fprintf(stderr, "'%s' is truncated\n", path);
+    return ok;
+}
+
+// Big-endian 32-bit value, as used in PNG chunks
+inline unsigned int readPNGUint(const unsigned char* p) {
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+inline int pngPaeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Read an 8-bit, non-interlaced PNG (gray, RGB or RGBA) as an RGB Image.
+// Alpha is dropped; the golden screenshots in docs/ are opaque where compared.
+inline bool readPNG(const char* path, Image& image) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open '%s'\n", path);
+        return false;
+    }
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + got);
+    fclose(file);
+
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+    if (data.size() < 8 || memcmp(data.data(), signature, 8) != 0) {
+        fprintf(stderr, "'%s' is not a PNG file\n", path);
+        return false;
+    }
+
+    // Walk the chunks: IHDR for the format, IDAT concatenated into one zlib stream
+    int width = 0, height = 0, colorType = -1;
+    std::vector<unsigned char> compressed;
+    for (size_t p = 8; p + 12 <= data.size();) {
+        size_t length = readPNGUint(&data[p]);
+        const unsigned char* type = &data[p + 4];
+        const unsigned char* body = &data[p + 8];
+        if (p + 12 + length > data.size()) break;
+        if (memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+            width = (int)readPNGUint(body);
+            height = (int)readPNGUint(body + 4);
+            colorType = body[9];
+            if (body[8] != 8 || body[12] != 0) colorType = -1;  // 8 bits, not interlaced
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), body, body + length);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        p += 12 + length;
+    }
+    int channels = colorType == 0 ? 1 : colorType == 2 ? 3 : colorType == 6 ? 4 : 0;
+    if (channels == 0 || width <= 0 || height <= 0) {
+        fprintf(stderr, "'%s': only 8-bit non-interlaced gray, RGB and RGBA PNGs are supported\n", path);
+        return false;
+    }
+
+    // Each row is one filter byte followed by the filtered pixels
+    size_t stride = (size_t)width * channels;
+    std::vector<unsigned char> raw((stride + 1) * height);
+    uLongf rawSize = (uLongf)raw.size();
+    if (uncompress(raw.data(), &rawSize, compressed.data(), (uLong)compressed.size()) != Z_OK ||
+        rawSize != raw.size()) {
+        fprintf(stderr, "'%s': corrupt image data\n", path);
+        return false;
+    }
+
+    allocateImage(image, width, height, channels == 1 ? 1 : 3);
+    std::vector<unsigned char> previous(stride, 0);
+    for (int y = 0; y < height; y++) {
+        unsigned char filter = raw[y * (stride + 1)];
+        unsigned char* row = &raw[y * (stride + 1) + 1];
+        for (size_t x = 0; x < stride; x++) {
+            int a = x >= (size_t)channels ? row[x - channels] : 0;
+            int b = previous[x];
+            int c = x >= (size_t)channels ? previous[x - channels] : 0;
+            int predictor = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2 :
+                            filter == 4 ? pngPaeth(a, b, c) : 0;
+            row[x] = (unsigned char)(row[x] + predictor);
+        }
+        memcpy(previous.data(), row, stride);
+
+        unsigned char* out = &image.pixels[(size_t)y * width * image.channels];
+        if (channels == 4) {
+            for (int x = 0; x < width; x++)
+                memcpy(out + x * 3, row + x * 4, 3);
+        } else {
+            memcpy(out, row, stride);
+        }
+    }
+    return true;
+}
+
+// Read a PNG, or a binary PGM/PPM for any other extension
+inline bool readImage(const char* path, Image& image) {
+    size_t length = strlen(path);
+    if (length >= 4 && strcmp(path + length - 4, ".png") == 0)
+        return readPNG(path, image);
+    return readPNM(path, image);
+}
+
+#endif // IMAGE_IO_H
@@ -0,0 +1,523 @@
+#ifndef MAPPED_IMAGE_H
+#define MAPPED_IMAGE_H
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "opengl_setup.h"
+
+/*
+ * Memory-mapped image input and streaming texture upload
+ *
+ * Binary PGM/PPM files and raw YUV4MPEG2 (Y4M) streams are mapped read-only;
+ * only the header is parsed, and pixel pointers point straight into the
+ * mapping, so nothing is read into an intermediate buffer. Y4M frames are
+ * used through their luma plane (8-bit gray) whatever the chroma layout.
+ *
+ * Textures are filled through TEXTURE_UPLOAD_PBO_COUNT pixel-unpack buffers
+ * in turn, allocated once per frame size. mapStreamedTexture maps the next
+ * one write-only and invalidated (no copy of the old contents, no wait for
+ * the GPU) and the producer writes the frame straight into it, e.g. the
+ * lens remap (undistort.h); unmapStreamedTexture then sources the texture
+ * from it. uploadStreamedTexture does the same for pixels already in memory
+ * with one memcpy. The software renderer writes into staging memory, and
+ * uploadStreamedTexture copies directly from the mapping.
+ *
+ * ImageSequence maps the next file of a directory, or pages in the next frame
+ * of a Y4M, on a background thread while the current one is used, so disk
+ * reads overlap rendering.
+ */
+
+const int TEXTURE_UPLOAD_PBO_COUNT = 2;
+
+struct MappedFile {
+    const unsigned char* data;
+    size_t size;
+};
+
+// A PGM/PPM image or Y4M stream in a mapped file
+struct MappedImage {
+    MappedFile file;
+    int width;
+    int height;
+    int channels;        // 1 = gray (PGM, Y4M luma), 3 = RGB (PPM)
+    int frames;          // 1 for PGM/PPM
+    size_t firstFrame;   // Offset of frame 0's pixels
+    size_t frameStride;  // Bytes from one frame's pixels to the next
+};
+
+inline bool mapFile(const char* path, MappedFile& file) {
+    file.data = NULL;
+    file.size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open '%s'\n", path);
+        return false;
+    }
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0 && info.st_size > 0;
+    if (ok) {
+        void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = data != MAP_FAILED;
+        if (ok) {
+            file.data = (const unsigned char*)data;
+            file.size = (size_t)info.st_size;
+            madvise(data, file.size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);  // The mapping keeps the file
+    if (!ok) fprintf(stderr, "Failed to map '%s'\n", path);
+    return ok;
+}
+
+inline void unmapFile(MappedFile& file) {
+    if (file.data) munmap((void*)file.data, file.size);
+    file.data = NULL;
+    file.size = 0;
+}
+
+// Read [offset, offset + bytes) of a mapping into the page cache now (one
+// touch per page), so later access does not wait for the disk
+inline void pageInMappedRange(const MappedFile& file, size_t offset, size_t bytes) {
+    if (offset >= file.size) return;
+    if (bytes > file.size - offset) bytes = file.size - offset;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset / page * page;
+    madvise((void*)(file.data + start), offset + bytes - start, MADV_WILLNEED);
+    volatile unsigned char sink = 0;
+    for (size_t p = start; p < offset + bytes; p += page)
+        sink ^= file.data[p];
+    (void)sink;
+}
+
+// Next whitespace-separated number of a PNM header; comments are skipped
+inline bool parsePNMNumber(const MappedFile& file, size_t& pos, int& value) {
+    while (pos < file.size) {
+        unsigned char c = file.data[pos];
+        if (c == '#') {
+            while (pos < file.size && file.data[pos] != '\n') pos++;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            pos++;
+        } else {
+            break;
+        }
+    }
+    if (pos >= file.size || file.data[pos] < '0' || file.data[pos] > '9') return false;
+    value = 0;
+    while (pos < file.size && file.data[pos] >= '0' && file.data[pos] <= '9' && value < 1000000)
+        value = value * 10 + (file.data[pos++] - '0');
+    pos++;  // The single whitespace after the number
+    return true;
+}
+
+// Y4M header "YUV4MPEG2 W.. H.. [C420jpeg|C422|C444|Cmono|...] ...\n" and the
+// first "FRAME...\n" line. Frame headers are assumed to be the same length.
+inline bool parseY4MHeader(MappedImage& image) {
+    const MappedFile& file = image.file;
+    const char* text = (const char*)file.data;
+    size_t end = 0;
+    while (end < file.size && text[end] != '\n') end++;
+    if (end >= file.size) return false;
+
+    std::string header(text, end);
+    std::string colorspace = "420";
+    image.width = image.height = 0;
+    for (size_t pos = header.find(' '); pos != std::string::npos; pos = header.find(' ', pos + 1)) {
+        char tag = pos + 1 < header.size() ? header[pos + 1] : 0;
+        if (tag == 'W') image.width = atoi(header.c_str() + pos + 2);
+        if (tag == 'H') image.height = atoi(header.c_str() + pos + 2);
+        if (tag == 'C') colorspace = header.substr(pos + 2, header.find(' ', pos + 1) - pos - 2);
+    }
+    if (image.width <= 0 || image.height <= 0) return false;
+
+    size_t luma = (size_t)image.width * image.height;
+    size_t halfWidth = (size_t)(image.width + 1) / 2, halfHeight = (size_t)(image.height + 1) / 2;
+    size_t frameBytes;
+    if (colorspace.compare(0, 4, "mono") == 0) frameBytes = luma;
+    else if (colorspace.compare(0, 3, "444") == 0) frameBytes = 3 * luma;
+    else if (colorspace.compare(0, 3, "422") == 0) frameBytes = luma + 2 * halfWidth * image.height;
+    else if (colorspace.compare(0, 3, "420") == 0) frameBytes = luma + 2 * halfWidth * halfHeight;
+    else return false;
+
+    size_t frameLine = end + 1;
+    size_t frameEnd = frameLine;
+    while (frameEnd < file.size && text[frameEnd] != '\n') frameEnd++;
+    if (frameEnd >= file.size || strncmp(text + frameLine, "FRAME", 5) != 0) return false;
+
+    image.channels = 1;
+    image.firstFrame = frameEnd + 1;
+    image.frameStride = frameEnd + 1 - frameLine + frameBytes;
+    image.frames = (int)((file.size - frameLine) / image.frameStride);
+    return image.frames > 0;
+}
+
+// Map a binary 8-bit PGM (P5), PPM (P6) or a Y4M stream
+inline bool mapImageFile(const char* path, MappedImage& image) {
+    if (!mapFile(path, image.file)) return false;
+    const MappedFile& file = image.file;
+
+    bool ok;
+    if (file.size > 10 && memcmp(file.data, "YUV4MPEG2 ", 10) == 0) {
+        ok = parseY4MHeader(image);
+    } else {
+        size_t pos = 2;
+        int maxValue;
+        ok = file.size > 2 && file.data[0] == 'P' && (file.data[1] == '5' || file.data[1] == '6') &&
+             parsePNMNumber(file, pos, image.width) && parsePNMNumber(file, pos, image.height) &&
+             parsePNMNumber(file, pos, maxValue) && maxValue == 255 && image.width > 0 && image.height > 0;
+        if (ok) {
+            image.channels = file.data[1] == '6' ? 3 : 1;
+            image.frames = 1;
+            image.firstFrame = pos;
+            image.frameStride = (size_t)image.width * image.height * image.channels;
+            ok = pos + image.frameStride <= file.size;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "'%s' is not an 8-bit binary PGM/PPM or a Y4M stream (or is truncated)\n", path);
+        unmapFile(image.file);
+    }
+    return ok;
+}
+
+inline void unmapImage(MappedImage& image) {
+    unmapFile(image.file);
+}
+
+// Pixels of one frame, rows top to bottom, inside the mapping
+inline const unsigned char* mappedFramePixels(const MappedImage& image, int frame) {
+    return image.file.data + image.firstFrame + (size_t)frame * image.frameStride;
+}
+
+inline size_t mappedFrameBytes(const MappedImage& image) {
+    return (size_t)image.width * image.height * image.channels;
+}
+
+// PGM/PPM/Y4M files in a directory, in name order
+inline bool listImageFiles(const char* directory, std::vector<std::string>& paths) {
+    DIR* dir = opendir(directory);
+    if (!dir) return false;
+    paths.clear();
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        size_t dot = name.rfind('.');
+        std::string extension = dot == std::string::npos ? "" : name.substr(dot);
+        if (extension == ".ppm" || extension == ".pgm" || extension == ".y4m")
+            paths.push_back(std::string(directory) + "/" + name);
+    }
+    closedir(dir);
+    std::sort(paths.begin(), paths.end());
+    return true;
+}
+
+// Frames of one image file, a Y4M stream or a directory of image files, in
+// order. The next file is mapped and paged in on a background thread while
+// the caller uses the current frame.
+class ImageSequence {
+public:
+    ImageSequence() : fileIndex(0), frameIndex(0), prefetchOk(false) {
+        current.file.data = NULL;
+        prefetched.file.data = NULL;
+    }
+    ~ImageSequence() { close(); }
+
+    // 'path' is a PGM/PPM/Y4M file or a directory of them
+    bool open(const char* path) {
+        close();
+        struct stat info;
+        if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+            if (!listImageFiles(path, paths) || paths.empty()) {
+                fprintf(stderr, "No PGM/PPM/Y4M files in '%s'\n", path);
+                return false;
+            }
+        } else {
+            paths.assign(1, path);
+        }
+        if (!mapImageFile(paths[0].c_str(), current)) return false;
+        fileIndex = 0;
+        frameIndex = -1;
+        startPrefetch(1);
+        return true;
+    }
+
+    void close() {
+        if (prefetchWorker.joinable()) prefetchWorker.join();
+        if (pageWorker.joinable()) pageWorker.join();
+        if (prefetchOk) unmapImage(prefetched);
+        if (current.file.data) unmapImage(current);
+        prefetchOk = false;
+        paths.clear();
+    }
+
+    // Advance to the next frame, from the start again after the last one.
+    // Returns false if a file cannot be read. The frame stays valid until the next call.
+    bool next(const unsigned char*& pixels, int& width, int& height, int& channels) {
+        if (++frameIndex >= current.frames) {
+            if (paths.size() > 1) {
+                if (prefetchWorker.joinable()) prefetchWorker.join();
+                if (pageWorker.joinable()) pageWorker.join();
+                unmapImage(current);
+                if (!prefetchOk) return false;
+                current = prefetched;
+                prefetchOk = false;
+                fileIndex = (fileIndex + 1) % paths.size();
+                startPrefetch((fileIndex + 1) % paths.size());
+            }
+            frameIndex = 0;
+        }
+        // Within a Y4M stream, page in the frame after this one
+        if (frameIndex + 1 < current.frames) {
+            const MappedImage& image = current;
+            size_t offset = image.firstFrame + (size_t)(frameIndex + 1) * image.frameStride;
+            if (pageWorker.joinable()) pageWorker.join();
+            pageWorker = std::thread([image, offset] { pageInMappedRange(image.file, offset, image.frameStride); });
+        }
+        pixels = mappedFramePixels(current, frameIndex);
+        width = current.width;
+        height = current.height;
+        channels = current.channels;
+        return true;
+    }
+
+    // A single still image never changes, so it only needs uploading once
+    bool isStill() const { return paths.size() == 1 && current.frames == 1; }
+
+private:
+    void startPrefetch(size_t index) {
+        if (paths.size() < 2) return;
+        std::string path = paths[index];
+        prefetchWorker = std::thread([this, path] {
+            prefetchOk = mapImageFile(path.c_str(), prefetched);
+            if (prefetchOk)
+                pageInMappedRange(prefetched.file, prefetched.firstFrame, mappedFrameBytes(prefetched));
+        });
+    }
+
+    std::vector<std::string> paths;
+    size_t fileIndex;
+    int frameIndex;
+    MappedImage current;
+    MappedImage prefetched;      // Written by prefetchWorker until it is joined
+    bool prefetchOk;
+    std::thread prefetchWorker;  // Maps and pages in the next file
+    std::thread pageWorker;      // Pages in the next frame of a Y4M stream
+};
+
+// A texture refilled every frame through pixel-unpack buffers
+struct StreamedTexture {
+    unsigned int texture;
+    int width, height, channels;  // Current storage (0 = none yet)
+    unsigned int pbos[TEXTURE_UPLOAD_PBO_COUNT];
+    size_t pboBytes[TEXTURE_UPLOAD_PBO_COUNT];  // Allocated storage of each
+    int nextPbo;
+    // Frame between mapStreamedTexture and unmapStreamedTexture
+    int mappedWidth, mappedHeight, mappedChannels;
+    bool mappedPbo;                      // In pbos[nextPbo], else in staging
+    std::vector<unsigned char> staging;  // Software renderer, or a failed map
+    size_t bytesUploaded;
+    int uploads;
+};
+
+inline void createStreamedTexture(StreamedTexture& t) {
+    t = StreamedTexture();
+    glGenTextures(1, &t.texture);
+    glBindTexture(GL_TEXTURE_2D, t.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (!g_softGL.active) glGenBuffers(TEXTURE_UPLOAD_PBO_COUNT, t.pbos);
+}
+
+inline void deleteStreamedTexture(StreamedTexture& t) {
+    glDeleteTextures(1, &t.texture);
+    if (!g_softGL.active) glDeleteBuffers(TEXTURE_UPLOAD_PBO_COUNT, t.pbos);
+    t = StreamedTexture();
+}
+
+// (Re)specify the texture from 'source': client memory, or an offset into
+// the bound pixel-unpack buffer. Gray images are shown as gray.
+inline void specifyStreamedTexture(StreamedTexture& t, const void* source, int width, int height, int channels) {
+    GLenum format = channels == 3 ? GL_RGB : GL_RED;
+    bool resize = width != t.width || height != t.height || channels != t.channels;
+
+    glBindTexture(GL_TEXTURE_2D, t.texture);
+    if (resize && channels == 1) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+    } else if (resize) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_GREEN);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_BLUE);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (resize) {
+        glTexImage2D(GL_TEXTURE_2D, 0, channels == 3 ? GL_RGB8 : GL_R8, width, height, 0,
+                     format, GL_UNSIGNED_BYTE, source);
+        t.width = width;
+        t.height = height;
+        t.channels = channels;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, source);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    t.bytesUploaded += (size_t)width * height * channels;
+    t.uploads++;
+}
+
+// Start the next frame of an 8-bit gray or RGB image: returns where to write
+// its width * height * channels bytes, rows top to bottom
+inline unsigned char* mapStreamedTexture(StreamedTexture& t, int width, int height, int channels) {
+    size_t bytes = (size_t)width * height * channels;
+    t.mappedWidth = width;
+    t.mappedHeight = height;
+    t.mappedChannels = channels;
+    t.mappedPbo = false;
+    if (!g_softGL.active) {
+        int i = t.nextPbo;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, t.pbos[i]);
+        if (t.pboBytes[i] != bytes) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+            t.pboBytes[i] = bytes;
+        }
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (mapped) {
+            t.mappedPbo = true;
+            return (unsigned char*)mapped;
+        }
+    }
+    t.staging.resize(bytes);
+    return t.staging.data();
+}
+
+// Finish the frame started by mapStreamedTexture and upload it
+inline void unmapStreamedTexture(StreamedTexture& t) {
+    if (!t.mappedPbo) {
+        specifyStreamedTexture(t, t.staging.data(), t.mappedWidth, t.mappedHeight, t.mappedChannels);
+        return;
+    }
+    // The unpack buffer replaces the client pointer: pixels come from offset 0
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, t.pbos[t.nextPbo]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    specifyStreamedTexture(t, NULL, t.mappedWidth, t.mappedHeight, t.mappedChannels);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    t.nextPbo = (t.nextPbo + 1) % TEXTURE_UPLOAD_PBO_COUNT;
+    t.mappedPbo = false;
+}
+
+// Upload an 8-bit gray or RGB image already in memory, rows top to bottom
+inline void uploadStreamedTexture(StreamedTexture& t, const unsigned char* pixels, int width, int height, int channels) {
+    if (g_softGL.active) {
+        specifyStreamedTexture(t, pixels, width, height, channels);
+        return;
+    }
+    memcpy(mapStreamedTexture(t, width, height, channels), pixels, (size_t)width * height * channels);
+    unmapStreamedTexture(t);
+}
+
+// ./main --bench-cpu imageio: load (and, with a GL context, upload) a
+// directory of 1080p PPM files with fread into a heap image versus mapped
+// with prefetch. The files are freshly written, so both read from the page
+// cache; the difference is the copies and the blocking.
+inline void runImageStreamBenchmark(int fileCount) {
+    const int width = 1920, height = 1080;
+    char directory[] = "/tmp/imageio-bench-XXXXXX";
+    if (!mkdtemp(directory)) {
+        fprintf(stderr, "Failed to create a temporary directory\n");
+        return;
+    }
+    std::vector<std::string> paths;
+    Image frame;
+    allocateImage(frame, width, height, 3);
+    for (int f = 0; f < fileCount; f++) {
+        for (size_t i = 0; i < frame.pixels.size(); i++)
+            frame.pixels[i] = (unsigned char)(i / 3 % width + f * 7 + i % 3 * 60);
+        char name[64];
+        snprintf(name, sizeof(name), "/frame_%04d.ppm", f);
+        paths.push_back(std::string(directory) + name);
+        writePNM(paths.back().c_str(), frame);
+    }
+    double megabytes = (double)width * height * 3 * fileCount / 1.0e6;
+    printf("Image I/O benchmark: %d files of %dx%d RGB PPM (%.0f MB) in %s\n\n",
+           fileCount, width, height, megabytes, directory);
+
+    // CPU only: every byte is read once (a checksum) so both paths load the whole file
+    unsigned int checksum = 0;
+    double start = wallTimeMs();
+    for (int f = 0; f < fileCount; f++) {
+        Image image;
+        readPNM(paths[f].c_str(), image);
+        for (size_t i = 0; i < image.pixels.size(); i += 64) checksum += image.pixels[i];
+    }
+    double readMs = wallTimeMs() - start;
+
+    ImageSequence sequence;
+    const unsigned char* pixels;
+    int w, h, channels;
+    start = wallTimeMs();
+    sequence.open(directory);
+    for (int f = 0; f < fileCount && sequence.next(pixels, w, h, channels); f++) {
+        size_t bytes = (size_t)w * h * channels;
+        for (size_t i = 0; i < bytes; i += 64) checksum -= pixels[i];
+    }
+    sequence.close();
+    double mappedMs = wallTimeMs() - start;
+
+    printf("Path                                  Time ms      MB/s\n");
+    printf("-----------------------------------  ---------  --------\n");
+    printf("readPNM (fread into heap image)      %9.2f  %8.0f\n", readMs, megabytes / (readMs / 1000.0));
+    printf("Mapped, next file prefetched         %9.2f  %8.0f\n", mappedMs, megabytes / (mappedMs / 1000.0));
+    if (checksum != 0) printf("(checksum mismatch: the two paths read different data)\n");
+
+    // Texture upload needs a context; skip it quietly where none is available
+    GLFWwindow* window = initializeOpenGL("Image I/O benchmark", 500, 500);
+    if (window) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        start = wallTimeMs();
+        for (int f = 0; f < fileCount; f++) {
+            Image image;
+            readPNM(paths[f].c_str(), image);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels.data());
+        }
+        glFinish();
+        double readUploadMs = wallTimeMs() - start;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glDeleteTextures(1, &texture);
+
+        StreamedTexture streamed;
+        createStreamedTexture(streamed);
+        start = wallTimeMs();
+        sequence.open(directory);
+        for (int f = 0; f < fileCount && sequence.next(pixels, w, h, channels); f++)
+            uploadStreamedTexture(streamed, pixels, w, h, channels);
+        glFinish();
+        double streamMs = wallTimeMs() - start;
+        sequence.close();
+        deleteStreamedTexture(streamed);
+
+        printf("readPNM + glTexImage2D               %9.2f  %8.0f\n", readUploadMs,
+               megabytes / (readUploadMs / 1000.0));
+        printf("Mapped + pixel-unpack buffer upload  %9.2f  %8.0f\n", streamMs, megabytes / (streamMs / 1000.0));
+        shutdownOpenGL(window);
+    } else {
+        printf("(No OpenGL context: texture upload skipped)\n");
+    }
+    printf("\n");
+
+    for (size_t f = 0; f < paths.size(); f++) remove(paths[f].c_str());
+    rmdir(directory);
+}
+
+#endif // MAPPED_IMAGE_H
@@ -2,19 +2,151 @@
 #define OPENGL_SETUP_H
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
 #define GL_SILENCE_DEPRECATION
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
+#ifdef __APPLE__
 #include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include "image_io.h"
+#include "frame_stats.h"
+#include "shader_cache.h"
+#include "soft_gl.h"
+#include "gl_state.h"
+#include "gl_stats.h"
+#include "gpu_timer.h"
+#include "frame_capture.h"
+
+// Render options shared by every activity (filled from the command line)
+struct RenderOptions {
+    bool headless;          // Offscreen context + FBO, no window or display needed
+    bool software;          // Draw with the CPU rasterizer (soft_gl.h) instead of the GL driver
+    bool vsync;             // Sync buffer swaps to the display refresh
+    int frames;             // Close after this many frames (0 = run until ESC)
+    int count;              // Object count for scalable scenes (0 = activity default)
+    const char* outDir;     // Write every frame as PPM into this directory (NULL = off)
+    const char* input;      // Input image for activities that process images (NULL = built-in)
+    const char* lens;       // Lens parameter file from --calibrate (NULL = built-in lens)
+    const char* gpuTrace;   // Time render-loop sections on the GPU, Chrome trace to this file (NULL = off)
+    const char* capture;    // Record frames to this Y4M/PPM stream through async readback (NULL = off)
+    const char* glStats;    // Count GL calls and uploads per frame, CSV to this file (NULL = off)
+    const char* frameTag;   // File name prefix for written frames
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern RenderOptions g_renderOptions;  // Defined in main.o
+#else
+RenderOptions g_renderOptions = { false, false, true, 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, "frame" };
+#endif
+
+// Offscreen render target and frame counter for the current activity
+struct RenderTarget {
+    unsigned int fbo;
+    unsigned int colorRbo;
+    unsigned int depthRbo;
+    int width;
+    int height;
+    int frameIndex;
+    double lastFrameTime;               // glfwGetTime() at the previous frameDeltaSeconds()
+    std::vector<unsigned char> pixels;  // Readback scratch for frame output
+#ifndef __APPLE__
+    EGLDisplay eglDisplay;
+    EGLContext eglContext;
+#endif
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern RenderTarget g_renderTarget;  // Defined in main.o
+#else
+RenderTarget g_renderTarget;
+#endif
+
+inline void printRenderOptionsUsage() {
+    printf("Render options:\n");
+    printf("  --headless     Render offscreen into an FBO (no window or display needed)\n");
+    printf("  --renderer R   gl (default) or soft: multi-threaded CPU rasterizer, no GL driver needed\n");
+    printf("  --frames N     Close after N frames\n");
+    printf("  --out DIR      Write every frame to DIR as PPM (e.g. DIR/activity1_0000.ppm)\n");
+    printf("  --capture FILE Record frames without stalling: FILE.y4m video, otherwise a PPM stream\n");
+    printf("  --no-vsync     Do not wait for the display refresh between frames\n");
+    printf("  --count N      Object count for scalable scenes (activity 4: bull's-eye rings, activity 6: ball field, activity 7: extra swarm satellites, activity 8: grid lines per side)\n");
+    printf("  --input PATH   Input PGM/PPM image, Y4M video or directory of frames (activity 8: distorted photo to correct)\n");
+    printf("  --lens FILE    Lens parameters saved by --calibrate (activity 8)\n");
+    printf("  --gpu-trace F  GPU time per render-loop section (clear and each draw pass): Chrome trace to F, averages to stderr\n");
+    printf("  --gl-stats F   Count draws, state changes and upload bytes: per-frame CSV to F, summary per activity\n");
+}
+
+// Parse render options from argv[first..argc). Returns false on an unknown/invalid option.
+inline bool parseRenderOptions(int argc, char* argv[], int first) {
+    for (int i = first; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            g_renderOptions.headless = true;
+        } else if (strcmp(argv[i], "--renderer") == 0 && i + 1 < argc) {
+            const char* renderer = argv[++i];
+            if (strcmp(renderer, "gl") != 0 && strcmp(renderer, "soft") != 0) {
+                fprintf(stderr, "Error: --renderer must be 'gl' or 'soft'\n");
+                return false;
+            }
+            g_renderOptions.software = strcmp(renderer, "soft") == 0;
+        } else if (strcmp(argv[i], "--no-vsync") == 0) {
+            g_renderOptions.vsync = false;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            g_renderOptions.frames = atoi(argv[++i]);
+            if (g_renderOptions.frames <= 0) {
+                fprintf(stderr, "Error: --frames needs a positive number\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            g_renderOptions.count = atoi(argv[++i]);
+            if (g_renderOptions.count < 0) {
+                fprintf(stderr, "Error: --count cannot be negative\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            g_renderOptions.input = argv[++i];
+        } else if (strcmp(argv[i], "--lens") == 0 && i + 1 < argc) {
+            g_renderOptions.lens = argv[++i];
+        } else if (strcmp(argv[i], "--gpu-trace") == 0 && i + 1 < argc) {
+            g_renderOptions.gpuTrace = argv[++i];
+        } else if (strcmp(argv[i], "--gl-stats") == 0 && i + 1 < argc) {
+            g_renderOptions.glStats = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            g_renderOptions.outDir = argv[++i];
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            g_renderOptions.capture = argv[++i];
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            return false;
+        }
+    }
+
+    // Headless runs have no window to close, so they always need a frame limit
+    if (g_renderOptions.headless && g_renderOptions.frames == 0) {
+        fprintf(stderr, "Error: --headless needs --frames N\n");
+        return false;
+    }
+    if (g_renderOptions.outDir && !ensureDirectory(g_renderOptions.outDir))
+        return false;
+
+    return true;
+}
 
 // Common error callback
-void errorCallback(int error, const char* description) {
+inline void errorCallback(int error, const char* description) {
     (void)error; // Unused parameter
     fputs(description, stderr);
 }
 
 // Common key callback (ESC to close)
-void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+inline void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     (void)scancode; // Unused parameter
     (void)mods;     // Unused parameter
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
@@ -22,16 +154,132 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 }
 
 // Common framebuffer resize callback
-void frameBufferResizeCallback(GLFWwindow* window, int width, int height) {
+inline void frameBufferResizeCallback(GLFWwindow* window, int width, int height) {
     (void)window; // Unused parameter
     glViewport(0, 0, width, height);
 }
 
+#ifndef __APPLE__
+// Create a surfaceless EGL context (Mesa software renderer, no display server needed)
+inline bool createHeadlessContext() {
+    // Prefer Mesa's software rasterizer on machines without a GPU
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        fprintf(stderr, "Failed to initialize EGL display\n");
+        return false;
+    }
+
+    // The default EGL_SURFACE_TYPE is EGL_WINDOW_BIT, which surfaceless displays lack
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) ||
+        !eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        fprintf(stderr, "Failed to choose an EGL config for desktop OpenGL\n");
+        eglTerminate(display);
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 1,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        fprintf(stderr, "Failed to create a surfaceless OpenGL 4.1 context\n");
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    g_renderTarget.eglDisplay = display;
+    g_renderTarget.eglContext = context;
+    return true;
+}
+
+inline void destroyHeadlessContext() {
+    eglMakeCurrent(g_renderTarget.eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(g_renderTarget.eglDisplay, g_renderTarget.eglContext);
+    eglTerminate(g_renderTarget.eglDisplay);
+}
+#endif
+
+// Create the offscreen framebuffer every headless frame is rendered into
+inline bool createRenderTarget(int width, int height) {
+    RenderTarget& target = g_renderTarget;
+    target.width = width;
+    target.height = height;
+
+    glGenFramebuffers(1, &target.fbo);
+    glGenRenderbuffers(1, &target.colorRbo);
+    glGenRenderbuffers(1, &target.depthRbo);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, target.colorRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.depthRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.colorRbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depthRbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Offscreen framebuffer is incomplete\n");
+        return false;
+    }
+
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+// Start the per-activity GPU section timing and frame statistics
+inline void beginActivityTimers() {
+    if (g_renderOptions.gpuTrace && !g_softGL.active) beginGpuTimer(g_renderOptions.frameTag);
+    if (g_frameStats.enabled) beginFrameStats(g_renderOptions.frames);
+    if (g_renderOptions.capture) beginFrameCapture(g_renderOptions.capture, g_renderOptions.frameTag);
+}
+
+inline void destroyRenderTarget() {
+    glDeleteFramebuffers(1, &g_renderTarget.fbo);
+    glDeleteRenderbuffers(1, &g_renderTarget.colorRbo);
+    glDeleteRenderbuffers(1, &g_renderTarget.depthRbo);
+    g_renderTarget.fbo = 0;
+}
+
 // Initialize GLFW and create window
-GLFWwindow* initializeOpenGL(const char* windowTitle, int width = 640, int height = 480) {
+// In headless mode the window is an invisible placeholder and rendering goes to an FBO.
+// With --renderer soft, drawing goes to the CPU rasterizer; headless runs then
+// create no GL context at all.
+inline GLFWwindow* initializeOpenGL(const char* windowTitle, int width = 640, int height = 480) {
+    g_renderTarget.fbo = 0;
+    g_renderTarget.frameIndex = 0;
+    g_renderTarget.lastFrameTime = -1.0;
+    resetGLStateCache();
+
     // Set error callback
     glfwSetErrorCallback(errorCallback);
 
+#if !defined(__APPLE__) && defined(GLFW_PLATFORM_NULL)
+    // No display server on render nodes: use GLFW's null platform for the window
+    if (g_renderOptions.headless)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
     // Initialize GLFW
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
@@ -44,6 +292,17 @@ GLFWwindow* initializeOpenGL(const char* windowTitle, int width = 640, int heigh
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    if (g_renderOptions.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifndef __APPLE__
+        // The context comes from EGL instead of the (display-less) window
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+#else
+        if (g_renderOptions.software)
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+#endif
+    }
+
     // Create window
     GLFWwindow* window = glfwCreateWindow(width, height, windowTitle, NULL, NULL);
     if (!window) {
@@ -54,17 +313,225 @@ GLFWwindow* initializeOpenGL(const char* windowTitle, int width = 640, int heigh
 
     // Set callbacks
     glfwSetKeyCallback(window, keyCallback);
+
+    if (g_renderOptions.software && g_renderOptions.gpuTrace)
+        fprintf(stderr, "--gpu-trace needs the GL renderer; ignored with --renderer soft\n");
+
+    if (g_renderOptions.headless && g_renderOptions.software) {
+        initSoftGL(width, height, false);
+        beginActivityTimers();
+        return window;
+    }
+
+    if (g_renderOptions.headless) {
+#ifdef __APPLE__
+        glfwMakeContextCurrent(window);
+#else
+        if (!createHeadlessContext()) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return NULL;
+        }
+#endif
+        if (!createRenderTarget(width, height)) {
+            destroyRenderTarget();
+#ifndef __APPLE__
+            destroyHeadlessContext();
+#endif
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return NULL;
+        }
+        beginActivityTimers();
+        return window;
+    }
+
     glfwSetFramebufferSizeCallback(window, frameBufferResizeCallback);
 
     // Make context current
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1); // Enable vsync
+    glfwSwapInterval(g_renderOptions.vsync ? 1 : 0); // Enable vsync unless --no-vsync
+
+    // Software frames are blitted to the window through this context
+    if (g_renderOptions.software) {
+        int fbWidth, fbHeight;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        initSoftGL(fbWidth, fbHeight, true);
+    }
 
+    beginActivityTimers();
     return window;
 }
 
+// Hand an existing window and context to the next activity (activity_host.h):
+// retitle and resize the window and render target, restore the GL state
+// activities change, and restart the frame counter and timers.
+inline bool reuseOpenGL(GLFWwindow* window, const char* windowTitle, int width, int height) {
+    if (g_gpuTimer.enabled)
+        finishGpuTimer(g_renderOptions.gpuTrace);
+    finishFrameCapture();
+    g_renderTarget.frameIndex = 0;
+    g_renderTarget.lastFrameTime = -1.0;
+    glfwSetWindowShouldClose(window, GLFW_FALSE);
+    glfwSetWindowTitle(window, windowTitle);
+
+    if (g_renderOptions.headless) {
+        if (g_softGL.active) {
+            resizeSoftRasterizer(g_softGL.raster, width, height);
+            glViewport(0, 0, width, height);
+        } else if (width != g_renderTarget.width || height != g_renderTarget.height) {
+            destroyRenderTarget();
+            if (!createRenderTarget(width, height)) return false;
+        } else {
+            glViewport(0, 0, width, height);
+        }
+    } else {
+        // Windowed: later size changes arrive through the resize callback
+        glfwSetWindowSize(window, width, height);
+        int fbWidth, fbHeight;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        if (g_softGL.active)
+            resizeSoftRasterizer(g_softGL.raster, fbWidth, fbHeight);
+        glViewport(0, 0, fbWidth, fbHeight);
+    }
+
+    // GL defaults for everything an activity may have changed
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_LESS);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glLineWidth(1.0f);
+    glUseProgram(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    beginActivityTimers();
+    return true;
+}
+
+// Animation time to advance this frame, in seconds.
+// Real elapsed time when interactive; a fixed 1/60 s when headless or writing
+// frames, so offline output does not depend on how fast frames render.
+inline double frameDeltaSeconds() {
+    const double fixedDelta = 1.0 / 60.0;
+    if (g_renderOptions.headless || g_renderOptions.outDir || g_renderOptions.capture)
+        return fixedDelta;
+
+    double now = glfwGetTime();
+    double delta = g_renderTarget.lastFrameTime < 0.0 ? fixedDelta : now - g_renderTarget.lastFrameTime;
+    g_renderTarget.lastFrameTime = now;
+    return delta;
+}
+
+// Whether the GL driver reports an extension (never with --renderer soft)
+inline bool hasGLExtension(const char* name) {
+    if (g_softGL.active) return false;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+// Size in pixels of what the activity renders into (offscreen target or window)
+inline void getFramebufferSize(GLFWwindow* window, int& width, int& height) {
+    if (g_softGL.active) {
+        width = g_softGL.raster.width;
+        height = g_softGL.raster.height;
+    } else if (g_renderTarget.fbo) {
+        width = g_renderTarget.width;
+        height = g_renderTarget.height;
+    } else {
+        glfwGetFramebufferSize(window, &width, &height);
+    }
+}
+
+// Write the frame that was just rendered to <outDir>/<frameTag>_NNNN.ppm
+inline void writeFrame(GLFWwindow* window) {
+    int width, height;
+    getFramebufferSize(window, width, height);
+
+    std::vector<unsigned char>& pixels = g_renderTarget.pixels;
+    pixels.resize((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s_%04d.ppm",
+             g_renderOptions.outDir, g_renderOptions.frameTag, g_renderTarget.frameIndex);
+    writePPM(path, width, height, pixels.data(), true);
+}
+
+// Finish a frame: write it out if requested, swap (windowed only) and poll events.
+// Closes the window once the --frames limit is reached.
+inline void presentFrame(GLFWwindow* window) {
+    if (g_softGL.active)
+        flushSoftRasterizer(g_softGL.raster);
+    if (g_gpuTimer.enabled)
+        endGpuTimerFrame(g_renderTarget.frameIndex);
+    if (g_glStats.enabled)
+        endGLStatsFrame(g_renderTarget.frameIndex);
+
+    if (g_renderOptions.outDir)
+        writeFrame(window);
+    if (g_renderOptions.capture) {
+        int width, height;
+        getFramebufferSize(window, width, height);
+        captureFrame(width, height);
+    }
+
+    if (g_softGL.presentToWindow) {
+        presentSoftFrame();
+        glfwSwapBuffers(window);
+
+        // Follow window resizes (the next frame is drawn at the new size)
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width > 0 && height > 0 && (width != g_softGL.raster.width || height != g_softGL.raster.height))
+            resizeSoftRasterizer(g_softGL.raster, width, height);
+    } else if (!g_softGL.active && !g_renderTarget.fbo) {
+        glfwSwapBuffers(window);
+    }
+
+    // Benchmarks time completed frames, not queued commands
+    if (g_frameStats.enabled) {
+        glFinish();
+        recordFrameStats();
+    }
+    glfwPollEvents();
+
+    g_renderTarget.frameIndex++;
+    if (g_renderOptions.frames > 0 && g_renderTarget.frameIndex >= g_renderOptions.frames)
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+}
+
+// Destroy the window, the offscreen target and its context, then terminate GLFW
+inline void shutdownOpenGL(GLFWwindow* window) {
+    finishFrameCapture();
+    if (g_softGL.active)
+        shutdownSoftGL();
+    if (g_gpuTimer.enabled)
+        finishGpuTimer(g_renderOptions.gpuTrace);
+    closeGLStats(g_renderOptions.glStats);
+
+    if (g_renderTarget.fbo) {
+        destroyRenderTarget();
+#ifndef __APPLE__
+        destroyHeadlessContext();
+#endif
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    resetGLStateCache();
+}
+
 // Create and compile a shader
-unsigned int compileShader(GLenum type, const char* source) {
+inline unsigned int compileShader(GLenum type, const char* source) {
     unsigned int shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
@@ -81,18 +548,58 @@ unsigned int compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-// Create shader program from vertex and fragment shaders
-unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource) {
+// Program cache key: both sources plus the driver that links them
+inline uint64_t shaderProgramKey(const char* vertexSource, const char* fragmentSource) {
+    const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    uint64_t key = hashString(fragmentSource, hashString(vertexSource));
+    for (int i = 0; i < 3; i++) {
+        const char* value = (const char*)glGetString(driverStrings[i]);
+        key = hashString(value ? value : "", key);
+    }
+    return key;
+}
+
+// Create shader program from vertex and fragment shaders.
+// Linked binaries are cached (shader_cache.h), so identical programs skip
+// compiling and linking after the first time, in this process and later ones.
+// softShader is the CPU version of the vertex shader for --renderer soft.
+inline unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource,
+                                        SoftVertexShader softShader = NULL,
+                                        SoftFragmentMode softFragment = SOFT_FRAGMENT_COLOR) {
+    if (softShader)
+        registerSoftProgram(vertexSource, fragmentSource, softShader, softFragment);
+
+    int binaryFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    bool cacheable = binaryFormats > 0;
+    uint64_t key = cacheable ? shaderProgramKey(vertexSource, fragmentSource) : 0;
+
+    int success;
+    if (cacheable) {
+        const ProgramBinary* binary = findProgramBinary(key);
+        if (binary) {
+            unsigned int program = glCreateProgram();
+            glProgramBinary(program, binary->format, binary->bytes.data(), (GLsizei)binary->bytes.size());
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (success) return program;
+
+            // Rejected by the driver: rebuild from source below
+            glDeleteProgram(program);
+            dropProgramBinary(key);
+        }
+    }
+
     unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
     unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
     unsigned int program = glCreateProgram();
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
+    if (cacheable)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
 
     // Check for linking errors
-    int success;
     char infoLog[512];
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
@@ -104,11 +611,24 @@ unsigned int createShaderProgram(const char* vertexSource, const char* fragmentS
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    // Cache the linked binary for the next request
+    int length = 0;
+    if (success && cacheable)
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length > 0) {
+        ProgramBinary binary;
+        GLenum format;
+        binary.bytes.resize(length);
+        glGetProgramBinary(program, length, NULL, &format, binary.bytes.data());
+        binary.format = format;
+        storeProgramBinary(key, binary);
+    }
+
     return program;
 }
 
 // Common vertex shader for basic rendering
-const char* DEFAULT_VERTEX_SHADER = "#version 410 core\n"
+const char* const DEFAULT_VERTEX_SHADER = "#version 410 core\n"
     "layout (location = 0) in vec3 aPos;\n"
     "layout (location = 1) in vec3 aColor;\n"
     "out vec3 vertexColor;\n"
@@ -118,7 +638,7 @@ const char* DEFAULT_VERTEX_SHADER = "#version 410 core\n"
     "}\0";
 
 // Common fragment shader for basic rendering
-const char* DEFAULT_FRAGMENT_SHADER = "#version 410 core\n"
+const char* const DEFAULT_FRAGMENT_SHADER = "#version 410 core\n"
     "in vec3 vertexColor;\n"
     "out vec4 FragColor;\n"
     "void main() {\n"
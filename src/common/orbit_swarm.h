@@ -0,0 +1,220 @@
+#ifndef ORBIT_SWARM_H
+#define ORBIT_SWARM_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "simd.h"
+#include "thread_pool.h"
+#include "frame_stats.h"
+
+/*
+ * Satellite swarm simulation
+ * Bodies orbit a central mass at the origin. State is kept as structure-of-arrays
+ * so the integrator runs 4 bodies per SIMD lane, and bodies are independent, so
+ * the arrays are split into chunks that worker threads advance on their own.
+ *
+ * Integration is semi-implicit (symplectic) Euler with a small softening length,
+ * which keeps elliptical orbits closed over long runs. Time advances in fixed
+ * steps fed by FixedTimestep, independent of the render rate.
+ */
+
+struct OrbitSwarm {
+    float gm;         // Gravitational parameter of the central body
+    float softening;  // Softening length squared (avoids the singularity at r = 0)
+    std::vector<float> x, y;    // Positions
+    std::vector<float> vx, vy;  // Velocities
+};
+
+inline void initOrbitSwarm(OrbitSwarm& swarm, float gm, size_t capacity) {
+    swarm.gm = gm;
+    swarm.softening = 1.0e-6f;
+    swarm.x.clear();
+    swarm.y.clear();
+    swarm.vx.clear();
+    swarm.vy.clear();
+    swarm.x.reserve(capacity);
+    swarm.y.reserve(capacity);
+    swarm.vx.reserve(capacity);
+    swarm.vy.reserve(capacity);
+}
+
+inline size_t swarmSize(const OrbitSwarm& swarm) { return swarm.x.size(); }
+
+// Add a body at rest (e.g. the central planet itself)
+inline size_t addStaticBody(OrbitSwarm& swarm, float x, float y) {
+    swarm.x.push_back(x);
+    swarm.y.push_back(y);
+    swarm.vx.push_back(0.0f);
+    swarm.vy.push_back(0.0f);
+    return swarm.x.size() - 1;
+}
+
+// Add a body from orbital elements:
+// semi-major axis a, eccentricity e (0 = circle), argument of periapsis omega
+// and starting true anomaly nu (radians). Orbits run counter-clockwise.
+inline size_t addOrbitingBody(OrbitSwarm& swarm, float a, float e, float omega, float nu) {
+    float p = a * (1.0f - e * e);              // Semi-latus rectum
+    float r = p / (1.0f + e * cosf(nu));
+    float theta = nu + omega;
+    float c = cosf(theta), s = sinf(theta);
+
+    float k = sqrtf(swarm.gm / p);
+    float vRadial = k * e * sinf(nu);
+    float vTangential = k * (1.0f + e * cosf(nu));
+
+    swarm.x.push_back(r * c);
+    swarm.y.push_back(r * s);
+    swarm.vx.push_back(vRadial * c - vTangential * s);
+    swarm.vy.push_back(vRadial * s + vTangential * c);
+    return swarm.x.size() - 1;
+}
+
+// Fill the swarm with count random elliptical orbits between rMin and rMax
+inline void addRandomOrbits(OrbitSwarm& swarm, size_t count, float rMin, float rMax,
+                            float maxEccentricity, unsigned int seed) {
+    srand(seed);
+    for (size_t i = 0; i < count; i++) {
+        float u = rand() / (float)RAND_MAX;
+        float e = maxEccentricity * (rand() / (float)RAND_MAX);
+        // Keep periapsis and apoapsis inside [rMin, rMax]
+        float aMin = rMin / (1.0f - e);
+        float aMax = rMax / (1.0f + e);
+        float a = aMax > aMin ? aMin + u * (aMax - aMin) : 0.5f * (rMin + rMax);
+        float omega = 6.2831853f * (rand() / (float)RAND_MAX);
+        float nu = 6.2831853f * (rand() / (float)RAND_MAX);
+        addOrbitingBody(swarm, a, e, omega, nu);
+    }
+}
+
+// Advance bodies [begin, end) by 'steps' fixed steps of dt.
+// All steps run on one chunk before moving on, so the chunk stays in cache.
+inline void integrateOrbitRange(OrbitSwarm& swarm, size_t begin, size_t end, int steps, float dt) {
+    float* px = swarm.x.data();
+    float* py = swarm.y.data();
+    float* pvx = swarm.vx.data();
+    float* pvy = swarm.vy.data();
+    const float gm = swarm.gm;
+    const float eps = swarm.softening;
+
+    size_t simdEnd = begin + (end - begin) / SIMD_WIDTH * SIMD_WIDTH;
+
+    const f32x4 vdt = f32x4_set1(dt);
+    const f32x4 vgm = f32x4_set1(-gm);
+    const f32x4 veps = f32x4_set1(eps);
+
+    for (size_t i = begin; i < simdEnd; i += SIMD_WIDTH) {
+        f32x4 x = f32x4_load(px + i), y = f32x4_load(py + i);
+        f32x4 vx = f32x4_load(pvx + i), vy = f32x4_load(pvy + i);
+
+        for (int s = 0; s < steps; s++) {
+            // a = -GM * r / |r|^3
+            f32x4 r2 = f32x4_add(f32x4_add(f32x4_mul(x, x), f32x4_mul(y, y)), veps);
+            f32x4 r3 = f32x4_mul(r2, f32x4_sqrt(r2));
+            f32x4 k = f32x4_div(vgm, r3);
+            vx = f32x4_add(vx, f32x4_mul(f32x4_mul(k, x), vdt));
+            vy = f32x4_add(vy, f32x4_mul(f32x4_mul(k, y), vdt));
+            x = f32x4_add(x, f32x4_mul(vx, vdt));
+            y = f32x4_add(y, f32x4_mul(vy, vdt));
+        }
+
+        f32x4_store(px + i, x);
+        f32x4_store(py + i, y);
+        f32x4_store(pvx + i, vx);
+        f32x4_store(pvy + i, vy);
+    }
+
+    // Remainder bodies
+    for (size_t i = simdEnd; i < end; i++) {
+        float x = px[i], y = py[i], vx = pvx[i], vy = pvy[i];
+        for (int s = 0; s < steps; s++) {
+            float r2 = x * x + y * y + eps;
+            float k = -gm / (r2 * sqrtf(r2));
+            vx += k * x * dt;
+            vy += k * y * dt;
+            x += vx * dt;
+            y += vy * dt;
+        }
+        px[i] = x;
+        py[i] = y;
+        pvx[i] = vx;
+        pvy[i] = vy;
+    }
+}
+
+// Bodies per parallel chunk (multiple of the SIMD width, ~64 KB of state)
+const size_t ORBIT_CHUNK = 4096;
+
+// Advance the whole swarm by 'steps' fixed steps, split across the pool
+inline void advanceOrbitSwarm(OrbitSwarm& swarm, int steps, float dt, ThreadPool* pool) {
+    if (steps <= 0) return;
+    size_t count = swarmSize(swarm);
+    if (!pool) {
+        integrateOrbitRange(swarm, 0, count, steps, dt);
+        return;
+    }
+    pool->parallelFor(count, ORBIT_CHUNK, [&](size_t begin, size_t end) {
+        integrateOrbitRange(swarm, begin, end, steps, dt);
+    });
+}
+
+// Fixed-timestep accumulator: turns variable frame times into whole simulation steps
+struct FixedTimestep {
+    double dt;           // Simulation step (seconds)
+    double accumulator;  // Unsimulated time carried to the next frame
+    int maxSteps;        // Cap per frame so a long stall cannot snowball
+};
+
+inline FixedTimestep makeFixedTimestep(double dt, int maxSteps = 32) {
+    FixedTimestep timestep = { dt, 0.0, maxSteps };
+    return timestep;
+}
+
+// Add a frame's elapsed time and return how many steps to simulate
+inline int consumeTimestep(FixedTimestep& timestep, double frameSeconds) {
+    timestep.accumulator += frameSeconds;
+    int steps = (int)(timestep.accumulator / timestep.dt);
+    if (steps > timestep.maxSteps) {
+        steps = timestep.maxSteps;
+        timestep.accumulator = 0.0;  // Drop the backlog instead of spiralling
+    } else {
+        timestep.accumulator -= steps * timestep.dt;
+    }
+    return steps;
+}
+
+// ./main --bench-cpu swarm: body updates per second versus thread count
+inline void runSwarmBenchmark(size_t bodies) {
+    const int steps = 100;
+    const float dt = 1.0f / 240.0f;
+
+    printf("Swarm benchmark: %zu bodies, %d steps per run\n\n", bodies, steps);
+    printf("Threads    Time ms   Body-updates/s   Speedup\n");
+    printf("-------  ---------  ---------------  --------\n");
+
+    double baseline = 0.0;
+    int maxThreads = hardwareThreads();
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads) threads = maxThreads;
+
+        OrbitSwarm swarm;
+        initOrbitSwarm(swarm, 0.18f, bodies);
+        addRandomOrbits(swarm, bodies, 0.2f, 0.95f, 0.6f, 1234);
+        ThreadPool pool(threads);
+
+        advanceOrbitSwarm(swarm, 1, dt, &pool);  // Warm up threads and caches
+        double start = wallTimeMs();
+        advanceOrbitSwarm(swarm, steps, dt, &pool);
+        double elapsed = wallTimeMs() - start;
+
+        double rate = (double)bodies * steps / (elapsed / 1000.0);
+        if (threads == 1) baseline = rate;
+        printf("%7d  %9.2f  %15.3e  %7.2fx\n", threads, elapsed, rate, rate / baseline);
+
+        if (threads == maxThreads) break;
+    }
+    printf("\n");
+}
+
+#endif // ORBIT_SWARM_H
@@ -0,0 +1,188 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image_io.h"
+#include "image_compare.h"
+#include "frame_stats.h"
+
+/*
+ * Golden-image regression suite (./main --regress)
+ * Every activity with a golden image is rendered headless in its own child
+ * process (this executable, --frames 1 --out), all of them at once, and
+ * the first frame is compared with the golden image (image_compare.h). A
+ * render passes when PSNR and SSIM are high enough and few pixels differ by
+ * more than the per-pixel tolerance. Failures leave the expected image and a
+ * diff image next to the render in the output directory.
+ *
+ * The goldens in docs/ are macOS window screenshots on a 2x display: title
+ * bar and shadow around the framebuffer, every framebuffer pixel 2x2 file
+ * pixels. The table records where the framebuffer sits in each file.
+ */
+
+struct GoldenImage {
+    int activity;
+    const char* file;  // In the golden directory
+    int x, y;          // Top-left corner of the framebuffer in the file
+    int scale;         // File pixels per framebuffer pixel
+};
+
+const GoldenImage GOLDEN_IMAGES[] = {
+    { 1, "activity1.png", 112, 132, 2 },
+    { 2, "activity2.png", 112, 132, 2 },
+    { 3, "activity3.png", 112, 132, 2 },
+    { 4, "activity4.png", 112, 132, 2 },
+};
+const int GOLDEN_IMAGE_COUNT = sizeof(GOLDEN_IMAGES) / sizeof(GOLDEN_IMAGES[0]);
+
+// Pass thresholds. Screenshots are downsampled and the window's title-bar
+// edge overlaps the top row, so exact matches are not expected.
+const int REGRESS_DEFAULT_TOLERANCE = 32;       // Largest channel difference of a matching pixel
+const double REGRESS_MIN_PSNR = 24.0;           // dB
+const double REGRESS_MIN_SSIM = 0.90;
+const double REGRESS_MAX_BAD_FRACTION = 0.02;   // Pixels beyond the tolerance
+
+struct RegressionOptions {
+    const char* program;     // This executable, run once per activity
+    const char* goldenDir;   // Set by main from --golden or findGoldenDirectory
+    const char* outDir;
+    int tolerance;
+    std::string renderArgs;  // Extra render options for the children (e.g. --renderer soft)
+};
+
+struct RegressionResult {
+    const GoldenImage* golden;
+    bool passed;
+    ImageDiff diff;
+    double ms;
+    std::string message;  // Why the case failed or could not be compared
+};
+
+inline const GoldenImage* findGoldenImage(int activity) {
+    for (int i = 0; i < GOLDEN_IMAGE_COUNT; i++)
+        if (GOLDEN_IMAGES[i].activity == activity) return &GOLDEN_IMAGES[i];
+    return NULL;
+}
+
+inline bool hasGoldenImages(const std::string& directory) {
+    FILE* file = fopen((directory + "/" + GOLDEN_IMAGES[0].file).c_str(), "rb");
+    if (file) fclose(file);
+    return file != NULL;
+}
+
+// Default golden directory: docs/ in the current directory, else next to the
+// executable or one level above it (./main, build/main-lto). Falls back to
+// "docs", which the suite then reports as missing.
+inline std::string findGoldenDirectory(const char* program) {
+    std::string executable = program;
+    size_t slash = executable.rfind('/');
+    std::string base = slash == std::string::npos ? "." : executable.substr(0, slash);
+    const std::string candidates[] = { "docs", base + "/docs", base + "/../docs" };
+    for (int i = 0; i < 3; i++)
+        if (hasGoldenImages(candidates[i])) return candidates[i];
+    return "docs";
+}
+
+// Single-quote an argument for the shell
+inline std::string shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\'') quoted += "'\\''";
+        else quoted += text[i];
+    }
+    return quoted + "'";
+}
+
+// Render one activity in a child process and compare its first frame
+inline void runRegressionCase(const RegressionOptions& options, RegressionResult& result) {
+    const GoldenImage& golden = *result.golden;
+    double start = wallTimeMs();
+    result.passed = false;
+    result.diff = ImageDiff();
+
+    char name[64];
+    snprintf(name, sizeof(name), "activity%d", golden.activity);
+    std::string outDir = options.outDir;
+    std::string rendered = outDir + "/" + name + "_0000.ppm";
+    std::string log = outDir + "/" + name + ".log";
+    remove(rendered.c_str());
+
+    char activityArgs[64];
+    snprintf(activityArgs, sizeof(activityArgs), " %d --headless --frames 1 --out ", golden.activity);
+    std::string command = shellQuote(options.program) + activityArgs + shellQuote(outDir) +
+                          options.renderArgs + " > " + shellQuote(log) + " 2>&1";
+    int status = system(command.c_str());
+
+    Image actual, goldenFile, expected;
+    std::string goldenPath = std::string(options.goldenDir) + "/" + golden.file;
+    if (status != 0) {
+        result.message = "render failed, see " + log;
+    } else if (!readPNM(rendered.c_str(), actual) || actual.channels != 3) {
+        result.message = "no frame in " + rendered;
+    } else if (!readImage(goldenPath.c_str(), goldenFile) || goldenFile.channels != 3) {
+        result.message = "cannot read golden " + goldenPath;
+    } else if (!cropAndShrink(goldenFile, golden.x, golden.y, actual.width, actual.height, golden.scale, expected)) {
+        result.message = "frame size does not fit golden " + goldenPath;
+    } else {
+        Image diffImage;
+        result.diff = compareImages(actual, expected, options.tolerance, &diffImage);
+        double badFraction = (double)result.diff.badPixels / result.diff.pixels;
+        result.passed = result.diff.psnr >= REGRESS_MIN_PSNR && result.diff.ssim >= REGRESS_MIN_SSIM &&
+                        badFraction <= REGRESS_MAX_BAD_FRACTION;
+        if (!result.passed) {
+            std::string base = outDir + "/" + name;
+            writePNM((base + "_expected.ppm").c_str(), expected);
+            writePNM((base + "_diff.ppm").c_str(), diffImage);
+            result.message = "see " + base + "_diff.ppm";
+        }
+    }
+    result.ms = wallTimeMs() - start;
+}
+
+// Run the cases for the given activities in parallel and print a report.
+// Returns true if every case passed.
+inline bool runRegressionSuite(const RegressionOptions& options, const std::vector<int>& activities) {
+    if (!hasGoldenImages(options.goldenDir)) {
+        fprintf(stderr, "No golden images in '%s' (looked for %s/%s); pass --golden DIR\n",
+                options.goldenDir, options.goldenDir, GOLDEN_IMAGES[0].file);
+        return false;
+    }
+    if (!ensureDirectory(options.outDir)) return false;
+
+    std::vector<RegressionResult> results(activities.size());
+    for (size_t i = 0; i < activities.size(); i++)
+        results[i].golden = findGoldenImage(activities[i]);
+
+    double start = wallTimeMs();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); i++)
+        threads.push_back(std::thread(runRegressionCase, std::cref(options), std::ref(results[i])));
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    double elapsed = wallTimeMs() - start;
+
+    printf("Activity  Result      PSNR dB    SSIM   Max err   Bad pixels    Time ms\n");
+    int failed = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const RegressionResult& r = results[i];
+        if (!r.passed) failed++;
+        if (r.diff.pixels > 0) {
+            printf("%8d  %-6s  %10.2f  %6.4f  %8d  %11zu  %9.1f\n", r.golden->activity, r.passed ? "pass" : "FAIL",
+                   r.diff.psnr, r.diff.ssim, r.diff.maxError, r.diff.badPixels, r.ms);
+        } else {
+            printf("%8d  %-6s  %s\n", r.golden->activity, "FAIL", r.message.c_str());
+        }
+        if (!r.passed && r.diff.pixels > 0)
+            printf("          %s\n", r.message.c_str());
+    }
+    printf("\n%d of %zu passed in %.1f ms (tolerance %d, PSNR >= %.0f dB, SSIM >= %.2f, <= %.0f%% bad pixels)\n",
+           (int)results.size() - failed, results.size(), elapsed, options.tolerance,
+           REGRESS_MIN_PSNR, REGRESS_MIN_SSIM, REGRESS_MAX_BAD_FRACTION * 100.0);
+    return failed == 0;
+}
+
+#endif // REGRESSION_H
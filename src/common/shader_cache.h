@@ -0,0 +1,151 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Linked shader-program binaries, cached in memory and on disk.
+ *
+ * Entries are keyed by a hash of the GLSL sources and the driver string
+ * (vendor, renderer, version), so a driver update never loads a stale
+ * binary. The GL calls that produce and consume the binaries live in
+ * createShaderProgram() (opengl_setup.h); this file only stores bytes.
+ *
+ * The disk cache defaults to $HOME/.cache/comvis-shaders and can be moved
+ * with COMVIS_SHADER_CACHE=<dir> (empty disables it). Files are written to
+ * a temporary name and renamed, so parallel batch runs never read a
+ * half-written binary.
+ */
+
+struct ProgramBinary {
+    unsigned int format;
+    std::vector<unsigned char> bytes;
+};
+
+struct ShaderCache {
+    bool initialized;
+    std::string directory;                       // Empty = no disk cache
+    std::map<uint64_t, ProgramBinary> programs;  // In-process cache
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern ShaderCache g_shaderCache;  // Defined in main.o
+#else
+ShaderCache g_shaderCache = { false, std::string(), std::map<uint64_t, ProgramBinary>() };
+#endif
+
+const char SHADER_CACHE_MAGIC[4] = { 'G', 'L', 'P', 'B' };
+
+// 64-bit FNV-1a, chained through seed; the terminating '\0' is hashed too
+// so ("ab", "c") and ("a", "bc") differ
+inline uint64_t hashString(const char* text, uint64_t seed = 14695981039346656037ULL) {
+    uint64_t hash = seed;
+    do {
+        hash ^= (unsigned char)*text;
+        hash *= 1099511628211ULL;
+    } while (*text++);
+    return hash;
+}
+
+// Create every missing directory along path (like mkdir -p)
+inline bool ensureDirectoryPath(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i == path.size() || path[i] == '/') {
+            std::string prefix = path.substr(0, i);
+            if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Resolve the disk cache directory once per process
+inline void initShaderCache() {
+    if (g_shaderCache.initialized) return;
+    g_shaderCache.initialized = true;
+
+    const char* cacheDir = getenv("COMVIS_SHADER_CACHE");
+    const char* home = getenv("HOME");
+    if (cacheDir)
+        g_shaderCache.directory = cacheDir;
+    else if (home && home[0])
+        g_shaderCache.directory = std::string(home) + "/.cache/comvis-shaders";
+
+    if (!g_shaderCache.directory.empty() && !ensureDirectoryPath(g_shaderCache.directory)) {
+        fprintf(stderr, "Shader cache disabled: cannot create '%s'\n", g_shaderCache.directory.c_str());
+        g_shaderCache.directory.clear();
+    }
+}
+
+inline std::string shaderCachePath(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+    return g_shaderCache.directory + name;
+}
+
+// Look up a binary in memory, then on disk (disk hits are kept in memory)
+inline const ProgramBinary* findProgramBinary(uint64_t key) {
+    initShaderCache();
+    std::map<uint64_t, ProgramBinary>::const_iterator it = g_shaderCache.programs.find(key);
+    if (it != g_shaderCache.programs.end())
+        return &it->second;
+    if (g_shaderCache.directory.empty())
+        return NULL;
+
+    FILE* file = fopen(shaderCachePath(key).c_str(), "rb");
+    if (!file) return NULL;
+
+    char magic[4];
+    uint32_t header[2];  // format, byte count
+    ProgramBinary binary;
+    bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, SHADER_CACHE_MAGIC, 4) == 0 &&
+              fread(header, sizeof(uint32_t), 2, file) == 2 && header[1] > 0;
+    if (ok) {
+        binary.format = header[0];
+        binary.bytes.resize(header[1]);
+        ok = fread(binary.bytes.data(), 1, header[1], file) == header[1];
+    }
+    fclose(file);
+    if (!ok) return NULL;
+
+    return &(g_shaderCache.programs[key] = binary);
+}
+
+// Remember a freshly linked binary in memory and on disk
+inline void storeProgramBinary(uint64_t key, const ProgramBinary& binary) {
+    initShaderCache();
+    g_shaderCache.programs[key] = binary;
+    if (g_shaderCache.directory.empty()) return;
+
+    std::string path = shaderCachePath(key);
+    char tempPath[1024];
+    snprintf(tempPath, sizeof(tempPath), "%s.%d.tmp", path.c_str(), (int)getpid());
+
+    FILE* file = fopen(tempPath, "wb");
+    if (!file) return;
+    uint32_t header[2] = { binary.format, (uint32_t)binary.bytes.size() };
+    bool ok = fwrite(SHADER_CACHE_MAGIC, 1, 4, file) == 4 &&
+              fwrite(header, sizeof(uint32_t), 2, file) == 2 &&
+              fwrite(binary.bytes.data(), 1, binary.bytes.size(), file) == binary.bytes.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempPath, path.c_str()) != 0)
+        remove(tempPath);
+}
+
+// Forget a binary the driver rejected (e.g. after a driver-internal change)
+inline void dropProgramBinary(uint64_t key) {
+    g_shaderCache.programs.erase(key);
+    if (!g_shaderCache.directory.empty())
+        remove(shaderCachePath(key).c_str());
+}
+
+#endif // SHADER_CACHE_H
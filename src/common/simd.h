@@ -0,0 +1,173 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/*
+ * Minimal 4-wide float SIMD wrapper
+ * SSE2 on x86-64, NEON on Apple Silicon / AArch64, plain scalar code elsewhere.
+ * Loads and stores are unaligned so std::vector<float> storage can be used directly.
+ */
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#endif
+
+#define SIMD_WIDTH 4
+
+#if defined(SIMD_SSE2)
+
+typedef __m128 f32x4;
+
+inline f32x4 f32x4_load(const float* p) { return _mm_loadu_ps(p); }
+inline void f32x4_store(float* p, f32x4 a) { _mm_storeu_ps(p, a); }
+inline f32x4 f32x4_set1(float v) { return _mm_set1_ps(v); }
+inline f32x4 f32x4_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+inline f32x4 f32x4_add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+inline f32x4 f32x4_sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+inline f32x4 f32x4_mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+inline f32x4 f32x4_div(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+inline f32x4 f32x4_sqrt(f32x4 a) { return _mm_sqrt_ps(a); }
+inline f32x4 f32x4_min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+inline f32x4 f32x4_max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+inline f32x4 f32x4_cmplt(f32x4 a, f32x4 b) { return _mm_cmplt_ps(a, b); }
+inline f32x4 f32x4_cmpgt(f32x4 a, f32x4 b) { return _mm_cmpgt_ps(a, b); }
+inline f32x4 f32x4_and(f32x4 a, f32x4 b) { return _mm_and_ps(a, b); }
+inline f32x4 f32x4_or(f32x4 a, f32x4 b) { return _mm_or_ps(a, b); }
+// Per lane: mask ? a : b
+inline f32x4 f32x4_select(f32x4 mask, f32x4 a, f32x4 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+// Bit i set if lane i of a comparison mask is true
+inline int f32x4_movemask(f32x4 mask) { return _mm_movemask_ps(mask); }
+// Truncate lanes in [0, 255] to integers and store them as 4 bytes
+inline void f32x4_store_u8(unsigned char* p, f32x4 a) {
+    __m128i i32 = _mm_cvttps_epi32(a);
+    __m128i u8 = _mm_packus_epi16(_mm_packs_epi32(i32, i32), i32);
+    int bytes = _mm_cvtsi128_si32(u8);
+    memcpy(p, &bytes, 4);
+}
+
+#elif defined(SIMD_NEON)
+
+typedef float32x4_t f32x4;
+
+inline f32x4 f32x4_load(const float* p) { return vld1q_f32(p); }
+inline void f32x4_store(float* p, f32x4 a) { vst1q_f32(p, a); }
+inline f32x4 f32x4_set1(float v) { return vdupq_n_f32(v); }
+inline f32x4 f32x4_set(float a, float b, float c, float d) {
+    float v[4] = { a, b, c, d };
+    return vld1q_f32(v);
+}
+inline f32x4 f32x4_add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+inline f32x4 f32x4_sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+inline f32x4 f32x4_mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+inline f32x4 f32x4_div(f32x4 a, f32x4 b) { return vdivq_f32(a, b); }
+inline f32x4 f32x4_sqrt(f32x4 a) { return vsqrtq_f32(a); }
+inline f32x4 f32x4_min(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+inline f32x4 f32x4_max(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+inline f32x4 f32x4_cmplt(f32x4 a, f32x4 b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+inline f32x4 f32x4_cmpgt(f32x4 a, f32x4 b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+inline f32x4 f32x4_and(f32x4 a, f32x4 b) {
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline f32x4 f32x4_or(f32x4 a, f32x4 b) {
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline f32x4 f32x4_select(f32x4 mask, f32x4 a, f32x4 b) {
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+inline int f32x4_movemask(f32x4 mask) {
+    uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+    return (int)(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                 (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+}
+inline void f32x4_store_u8(unsigned char* p, f32x4 a) {
+    uint16x4_t u16 = vmovn_u32(vcvtq_u32_f32(a));
+    uint8x8_t u8 = vmovn_u16(vcombine_u16(u16, u16));
+    vst1_lane_u32((uint32_t*)(void*)p, vreinterpret_u32_u8(u8), 0);
+}
+
+#else
+
+#include <math.h>
+
+struct f32x4 { float v[4]; };
+
+inline f32x4 f32x4_load(const float* p) { f32x4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void f32x4_store(float* p, f32x4 a) { memcpy(p, a.v, sizeof(a.v)); }
+inline f32x4 f32x4_set1(float v) { f32x4 r = { { v, v, v, v } }; return r; }
+inline f32x4 f32x4_set(float a, float b, float c, float d) { f32x4 r = { { a, b, c, d } }; return r; }
+
+#define SIMD_SCALAR_OP(name, expr) \
+    inline f32x4 name(f32x4 a, f32x4 b) { \
+        f32x4 r; \
+        for (int i = 0; i < 4; i++) { float x = a.v[i], y = b.v[i]; (void)y; r.v[i] = (expr); } \
+        return r; \
+    }
+
+SIMD_SCALAR_OP(f32x4_add, x + y)
+SIMD_SCALAR_OP(f32x4_sub, x - y)
+SIMD_SCALAR_OP(f32x4_mul, x * y)
+SIMD_SCALAR_OP(f32x4_div, x / y)
+SIMD_SCALAR_OP(f32x4_min, x < y ? x : y)
+SIMD_SCALAR_OP(f32x4_max, x > y ? x : y)
+#undef SIMD_SCALAR_OP
+
+inline f32x4 f32x4_sqrt(f32x4 a) {
+    f32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = sqrtf(a.v[i]);
+    return r;
+}
+
+// Masks use all-ones / all-zeros bit patterns, like the hardware versions
+inline float simdMaskBits(bool b) {
+    unsigned int bits = b ? 0xFFFFFFFFu : 0u;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+inline unsigned int simdBits(float f) { unsigned int u; memcpy(&u, &f, sizeof(u)); return u; }
+inline float simdFromBits(unsigned int u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+inline f32x4 f32x4_cmplt(f32x4 a, f32x4 b) {
+    f32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = simdMaskBits(a.v[i] < b.v[i]);
+    return r;
+}
+inline f32x4 f32x4_cmpgt(f32x4 a, f32x4 b) {
+    f32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = simdMaskBits(a.v[i] > b.v[i]);
+    return r;
+}
+inline f32x4 f32x4_and(f32x4 a, f32x4 b) {
+    f32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = simdFromBits(simdBits(a.v[i]) & simdBits(b.v[i]));
+    return r;
+}
+inline f32x4 f32x4_or(f32x4 a, f32x4 b) {
+    f32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = simdFromBits(simdBits(a.v[i]) | simdBits(b.v[i]));
+    return r;
+}
+inline f32x4 f32x4_select(f32x4 mask, f32x4 a, f32x4 b) {
+    f32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = simdBits(mask.v[i]) ? a.v[i] : b.v[i];
+    return r;
+}
+inline int f32x4_movemask(f32x4 mask) {
+    int bits = 0;
+    for (int i = 0; i < 4; i++) bits |= (simdBits(mask.v[i]) >> 31) << i;
+    return bits;
+}
+inline void f32x4_store_u8(unsigned char* p, f32x4 a) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)a.v[i];
+}
+
+#endif
+
+#endif // SIMD_H
@@ -0,0 +1,1132 @@
+#ifndef SOFT_GL_H
+#define SOFT_GL_H
+
+// Included by opengl_setup.h, after the GL headers
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "shader_cache.h"
+#include "soft_raster.h"
+
+/*
+ * Software backend for the slice of OpenGL the activities use (--renderer soft)
+ *
+ * The GL entry points below are redirected (see the #defines at the end) to
+ * soft* wrappers. With the GL renderer a wrapper just forwards the call.
+ * With the software renderer it keeps buffers, vertex arrays, programs,
+ * uniforms and textures in memory and feeds draws to the tile rasterizer
+ * (soft_raster.h), so the activities' own vertex buffers and draw calls run
+ * unchanged with no GL driver involved.
+ *
+ * GLSL is not executed. Each program passes a CPU equivalent of its vertex
+ * shader to createShaderProgram(); it receives the attributes by location and
+ * the uniforms in declaration order (vertex shader first) and writes
+ * gl_Position plus up to four varyings. Fragments either output the
+ * interpolated varyings as RGBA or, for SOFT_FRAGMENT_TEXTURE, sample the
+ * bound texture at (u, v) and scale it by the third varying.
+ *
+ * Supported: float, half-float and (normalized) 8/16-bit integer vertex
+ * attributes plus GL_INT_2_10_10_10_REV, constant attribute values
+ * (glVertexAttrib*f), gl_VertexID/gl_InstanceID (see SOFT_VERTEX_ID), instancing, indexed draws (8/16/32-bit indices),
+ * GL_TRIANGLES/_STRIP/_FAN, GL_LINES/_LINE_STRIP/_LINE_LOOP, glLineWidth,
+ * glPolygonMode(GL_LINE), depth test with any depth function, 2D textures.
+ * Not supported: blending, face culling, points, and clipping of primitives
+ * that cross w = 0.
+ */
+
+const int SOFT_MAX_ATTRIBS = 8;
+const int SOFT_MAX_UNIFORMS = 8;
+const int SOFT_VERTEX_ID = SOFT_MAX_ATTRIBS;  // attribs[SOFT_VERTEX_ID] = (gl_VertexID, gl_InstanceID, 0, 1)
+
+// CPU vertex shader: attribute values (missing components are 0, 0, 0, 1)
+// and uniform values in -> clip-space position and varyings out.
+// Shaders that pull their vertices read gl_VertexID from attribs[SOFT_VERTEX_ID].
+typedef void (*SoftVertexShader)(const float attribs[][4], const float* const uniforms[],
+                                 float position[4], float varying[SOFT_VARYINGS]);
+
+enum SoftFragmentMode {
+    SOFT_FRAGMENT_COLOR,    // Varyings are the RGBA output
+    SOFT_FRAGMENT_TEXTURE   // Bound texture at varyings (u, v), scaled by varying 2
+};
+
+struct SoftBuffer {
+    bool alive;
+    std::vector<unsigned char> data;
+};
+
+struct SoftAttrib {
+    bool enabled;
+    unsigned int buffer;
+    int size;
+    GLenum type;
+    bool normalized;
+    int stride;
+    size_t offset;
+    unsigned int divisor;
+};
+
+struct SoftVertexArray {
+    bool alive;
+    SoftAttrib attribs[SOFT_MAX_ATTRIBS];
+    unsigned int elementBuffer;  // GL_ELEMENT_ARRAY_BUFFER binding (vertex array state, as in GL)
+};
+
+struct SoftShaderObject {
+    bool alive;
+    GLenum type;
+    std::string source;
+};
+
+struct SoftProgramObject {
+    bool alive;
+    bool linked;
+    std::string vertexSource;
+    std::string fragmentSource;
+    SoftVertexShader shader;
+    SoftFragmentMode fragmentMode;
+    std::vector<std::string> uniformNames;
+    std::vector<float> uniformValues;  // 16 floats per uniform
+};
+
+struct SoftTextureObject {
+    bool alive;
+    SoftTexture texture;
+};
+
+// CPU shaders registered for (vertex source, fragment source) pairs
+struct SoftProgramEntry {
+    uint64_t key;
+    SoftVertexShader shader;
+    SoftFragmentMode fragmentMode;
+};
+
+struct SoftGL {
+    bool active;
+    bool presentToWindow;  // Windowed: blit each frame to the window with real GL
+    SoftRasterizer raster;
+
+    std::vector<SoftBuffer> buffers;  // Index = object name, 0 unused
+    std::vector<SoftVertexArray> vertexArrays;
+    std::vector<SoftShaderObject> shaders;
+    std::vector<SoftProgramObject> programs;  // Shares the name space with shaders, like GL
+    std::vector<SoftTextureObject> textures;
+    std::vector<SoftProgramEntry> registry;
+
+    unsigned int arrayBuffer;
+    unsigned int vertexArray;
+    unsigned int program;
+    unsigned int texture;
+    float currentAttribs[SOFT_MAX_ATTRIBS][4];  // Values of disabled attribute arrays (glVertexAttrib*f)
+    float clearColor[4];
+    bool depthTest;
+    int depthFunc;
+    bool wireframe;
+    float lineWidth;
+    int viewport[4];
+    int packAlignment;
+    int unpackAlignment;
+
+    unsigned int presentTexture;  // Real GL objects used by the windowed presenter
+    unsigned int presentFbo;
+    int presentWidth;
+    int presentHeight;
+};
+
+#if defined(SEPARATE_ACTIVITIES) && !defined(MAIN_DISPATCHER)
+extern SoftGL g_softGL;  // Defined in main.o
+#else
+SoftGL g_softGL;
+#endif
+
+// Remember the CPU vertex shader for a program's sources (done by createShaderProgram)
+inline void registerSoftProgram(const char* vertexSource, const char* fragmentSource,
+                                SoftVertexShader shader, SoftFragmentMode fragmentMode) {
+    uint64_t key = hashString(fragmentSource, hashString(vertexSource));
+    for (size_t i = 0; i < g_softGL.registry.size(); i++) {
+        if (g_softGL.registry[i].key == key) {
+            g_softGL.registry[i].shader = shader;
+            g_softGL.registry[i].fragmentMode = fragmentMode;
+            return;
+        }
+    }
+    SoftProgramEntry entry = { key, shader, fragmentMode };
+    g_softGL.registry.push_back(entry);
+}
+
+// column-major mat4 * vec4, as in GLSL
+inline void softTransform(const float* m, const float* v, float out[4]) {
+    for (int r = 0; r < 4; r++)
+        out[r] = m[r] * v[0] + m[4 + r] * v[1] + m[8 + r] * v[2] + m[12 + r] * v[3];
+}
+
+// CPU shaders for the shared GLSL programs.
+// DEFAULT_VERTEX_SHADER: position (loc 0) as-is, color (loc 1)
+inline void softVertexColorShader(const float attribs[][4], const float* const uniforms[],
+                                  float position[4], float varying[SOFT_VARYINGS]) {
+    (void)uniforms;
+    memcpy(position, attribs[0], 4 * sizeof(float));
+    memcpy(varying, attribs[1], 3 * sizeof(float));
+    varying[3] = 1.0f;
+}
+
+// projection * position, color (loc 1)
+inline void softProjectedVertexColorShader(const float attribs[][4], const float* const uniforms[],
+                                           float position[4], float varying[SOFT_VARYINGS]) {
+    softTransform(uniforms[0], attribs[0], position);
+    memcpy(varying, attribs[1], 3 * sizeof(float));
+    varying[3] = 1.0f;
+}
+
+// projection * position, uniform vec4 color
+inline void softProjectedUniformColorShader(const float attribs[][4], const float* const uniforms[],
+                                            float position[4], float varying[SOFT_VARYINGS]) {
+    softTransform(uniforms[0], attribs[0], position);
+    memcpy(varying, uniforms[1], 4 * sizeof(float));
+}
+
+// Names declared with "uniform <type> <name>" in a GLSL source, in order
+inline void parseSoftUniforms(const std::string& source, std::vector<std::string>& names) {
+    const char* blanks = " \t\r\n";
+    size_t pos = 0;
+    while ((pos = source.find("uniform", pos)) != std::string::npos) {
+        bool declaration = (pos == 0 || strchr(" \t\r\n;}", source[pos - 1])) &&
+                           pos + 7 < source.size() && strchr(blanks, source[pos + 7]);
+        pos += 7;
+        if (!declaration) continue;
+
+        size_t typeStart = source.find_first_not_of(blanks, pos);
+        size_t typeEnd = source.find_first_of(blanks, typeStart);
+        size_t nameStart = source.find_first_not_of(blanks, typeEnd);
+        size_t nameEnd = source.find_first_of(" \t\r\n;[", nameStart);
+        if (nameStart == std::string::npos || nameEnd == std::string::npos) break;
+
+        std::string name = source.substr(nameStart, nameEnd - nameStart);
+        bool seen = false;
+        for (size_t i = 0; i < names.size(); i++) seen = seen || names[i] == name;
+        if (!seen) names.push_back(name);
+    }
+}
+
+// Allocate n object names in a table (index 0 is never used)
+template <typename T>
+void genSoftObjects(std::vector<T>& table, GLsizei n, GLuint* names) {
+    if (table.empty()) table.resize(1);
+    for (GLsizei i = 0; i < n; i++) {
+        T object = T();
+        object.alive = true;
+        table.push_back(object);
+        names[i] = (GLuint)table.size() - 1;
+    }
+}
+
+template <typename T>
+T* findSoftObject(std::vector<T>& table, GLuint name) {
+    return name > 0 && name < table.size() && table[name].alive ? &table[name] : NULL;
+}
+
+template <typename T>
+void deleteSoftObjects(std::vector<T>& table, GLsizei n, const GLuint* names) {
+    for (GLsizei i = 0; i < n; i++) {
+        T* object = findSoftObject(table, names[i]);
+        if (object) *object = T();
+    }
+}
+
+// Start the software renderer for a width x height framebuffer
+inline void initSoftGL(int width, int height, bool presentToWindow) {
+    SoftGL& gl = g_softGL;
+    gl.active = true;
+    gl.presentToWindow = presentToWindow;
+    if (!gl.raster.pool) gl.raster.pool = new ThreadPool();
+    resizeSoftRasterizer(gl.raster, width, height);
+
+    gl.buffers.assign(1, SoftBuffer());
+    gl.vertexArrays.assign(1, SoftVertexArray());
+    gl.vertexArrays[0].alive = true;  // GL's default vertex array, so draws without one are harmless
+    gl.shaders.assign(1, SoftShaderObject());
+    gl.programs.assign(1, SoftProgramObject());
+    gl.textures.assign(1, SoftTextureObject());
+
+    gl.arrayBuffer = gl.vertexArray = gl.program = gl.texture = 0;
+    for (int a = 0; a < SOFT_MAX_ATTRIBS; a++) {
+        gl.currentAttribs[a][0] = gl.currentAttribs[a][1] = gl.currentAttribs[a][2] = 0.0f;
+        gl.currentAttribs[a][3] = 1.0f;
+    }
+    for (int i = 0; i < 4; i++) gl.clearColor[i] = 0.0f;
+    gl.depthTest = false;
+    gl.depthFunc = SOFT_DEPTH_LESS;
+    gl.wireframe = false;
+    gl.lineWidth = 1.0f;
+    gl.viewport[0] = gl.viewport[1] = 0;
+    gl.viewport[2] = width;
+    gl.viewport[3] = height;
+    gl.packAlignment = gl.unpackAlignment = 4;
+    gl.presentTexture = gl.presentFbo = 0;
+    gl.presentWidth = gl.presentHeight = 0;
+}
+
+// Copy the finished frame to the window's default framebuffer (windowed mode)
+inline void presentSoftFrame() {
+    SoftGL& gl = g_softGL;
+    SoftRasterizer& r = gl.raster;
+    if (!gl.presentFbo) {
+        glGenTextures(1, &gl.presentTexture);
+        glGenFramebuffers(1, &gl.presentFbo);
+    }
+    glBindTexture(GL_TEXTURE_2D, gl.presentTexture);
+    if (gl.presentWidth != r.width || gl.presentHeight != r.height) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, r.width, r.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, gl.presentFbo);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gl.presentTexture, 0);
+        gl.presentWidth = r.width;
+        gl.presentHeight = r.height;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, r.stride);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r.width, r.height, GL_RGBA, GL_UNSIGNED_BYTE, r.color.data());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gl.presentFbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, r.width, r.height, 0, 0, r.width, r.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+inline void shutdownSoftGL() {
+    SoftGL& gl = g_softGL;
+    if (gl.presentFbo) {
+        glDeleteFramebuffers(1, &gl.presentFbo);
+        glDeleteTextures(1, &gl.presentTexture);
+    }
+    delete gl.raster.pool;
+    gl.raster = SoftRasterizer();
+    gl.buffers.clear();
+    gl.vertexArrays.clear();
+    gl.shaders.clear();
+    gl.programs.clear();
+    gl.textures.clear();
+    gl.active = false;
+}
+
+// ---- Buffers and vertex arrays ----
+
+inline void softGenBuffers(GLsizei n, GLuint* buffers) {
+    if (!g_softGL.active) { glGenBuffers(n, buffers); return; }
+    genSoftObjects(g_softGL.buffers, n, buffers);
+}
+
+inline void softDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    if (!g_softGL.active) { glDeleteBuffers(n, buffers); return; }
+    deleteSoftObjects(g_softGL.buffers, n, buffers);
+}
+
+inline SoftVertexArray* currentSoftVertexArray() {
+    SoftGL& gl = g_softGL;
+    return gl.vertexArray ? findSoftObject(gl.vertexArrays, gl.vertexArray) : &gl.vertexArrays[0];
+}
+
+inline void softBindBuffer(GLenum target, GLuint buffer) {
+    if (!g_softGL.active) { glBindBuffer(target, buffer); return; }
+    if (target == GL_ARRAY_BUFFER) {
+        g_softGL.arrayBuffer = buffer;
+    } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        SoftVertexArray* vao = currentSoftVertexArray();
+        if (vao) vao->elementBuffer = buffer;
+    }
+}
+
+// Buffer bound to an array or element-array target (NULL for other targets)
+inline SoftBuffer* boundSoftBuffer(GLenum target) {
+    SoftVertexArray* vao = currentSoftVertexArray();
+    unsigned int name = target == GL_ARRAY_BUFFER ? g_softGL.arrayBuffer
+                      : (target == GL_ELEMENT_ARRAY_BUFFER && vao ? vao->elementBuffer : 0);
+    return findSoftObject(g_softGL.buffers, name);
+}
+
+inline void softBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    if (!g_softGL.active) { glBufferData(target, size, data, usage); return; }
+    SoftBuffer* buffer = boundSoftBuffer(target);
+    if (!buffer) return;
+    buffer->data.assign((size_t)size, 0);
+    if (data) memcpy(buffer->data.data(), data, (size_t)size);
+}
+
+inline void softBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    if (!g_softGL.active) { glBufferSubData(target, offset, size, data); return; }
+    SoftBuffer* buffer = boundSoftBuffer(target);
+    if (!buffer || (size_t)(offset + size) > buffer->data.size()) return;
+    memcpy(buffer->data.data() + offset, data, (size_t)size);
+}
+
+inline void softGenVertexArrays(GLsizei n, GLuint* arrays) {
+    if (!g_softGL.active) { glGenVertexArrays(n, arrays); return; }
+    genSoftObjects(g_softGL.vertexArrays, n, arrays);
+}
+
+inline void softDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+    if (!g_softGL.active) { glDeleteVertexArrays(n, arrays); return; }
+    deleteSoftObjects(g_softGL.vertexArrays, n, arrays);
+}
+
+inline void softBindVertexArray(GLuint array) {
+    if (!g_softGL.active) { glBindVertexArray(array); return; }
+    g_softGL.vertexArray = array;
+}
+
+inline SoftAttrib* currentSoftAttrib(GLuint index) {
+    SoftVertexArray* vao = currentSoftVertexArray();
+    return vao && index < (GLuint)SOFT_MAX_ATTRIBS ? &vao->attribs[index] : NULL;
+}
+
+// Bytes of one attribute element, 0 for types the software renderer cannot fetch
+inline int softAttribBytes(GLenum type, int size) {
+    switch (type) {
+    case GL_FLOAT: return size * 4;
+    case GL_HALF_FLOAT: case GL_SHORT: case GL_UNSIGNED_SHORT: return size * 2;
+    case GL_BYTE: case GL_UNSIGNED_BYTE: return size;
+    case GL_INT_2_10_10_10_REV: return 4;
+    default: return 0;
+    }
+}
+
+inline float softHalfToFloat(uint16_t half) {
+    int exponent = (half >> 10) & 0x1F, mantissa = half & 0x3FF;
+    float magnitude;
+    if (exponent == 0) magnitude = ldexpf((float)mantissa, -24);
+    else if (exponent == 31) magnitude = mantissa ? NAN : INFINITY;
+    else magnitude = ldexpf((float)(mantissa | 0x400), exponent - 25);
+    return (half & 0x8000) ? -magnitude : magnitude;
+}
+
+// One attribute element to floats, with GL's conversions for normalized
+// integers (signed: c / (2^(b-1) - 1) clamped to -1, unsigned: c / (2^b - 1))
+inline void fetchSoftAttrib(const unsigned char* src, GLenum type, bool normalized, int size, float value[4]) {
+    switch (type) {
+    case GL_FLOAT:
+        memcpy(value, src, size * sizeof(float));
+        break;
+    case GL_HALF_FLOAT:
+        for (int c = 0; c < size; c++) {
+            uint16_t half;
+            memcpy(&half, src + 2 * c, 2);
+            value[c] = softHalfToFloat(half);
+        }
+        break;
+    case GL_SHORT:
+        for (int c = 0; c < size; c++) {
+            int16_t v;
+            memcpy(&v, src + 2 * c, 2);
+            value[c] = normalized ? fmaxf(v / 32767.0f, -1.0f) : (float)v;
+        }
+        break;
+    case GL_UNSIGNED_SHORT:
+        for (int c = 0; c < size; c++) {
+            uint16_t v;
+            memcpy(&v, src + 2 * c, 2);
+            value[c] = normalized ? v / 65535.0f : (float)v;
+        }
+        break;
+    case GL_BYTE:
+        for (int c = 0; c < size; c++) {
+            int8_t v = (int8_t)src[c];
+            value[c] = normalized ? fmaxf(v / 127.0f, -1.0f) : (float)v;
+        }
+        break;
+    case GL_UNSIGNED_BYTE:
+        for (int c = 0; c < size; c++)
+            value[c] = normalized ? src[c] / 255.0f : (float)src[c];
+        break;
+    case GL_INT_2_10_10_10_REV: {
+        uint32_t packed;
+        memcpy(&packed, src, 4);
+        for (int c = 0; c < 3; c++) {
+            int v = (int)((packed >> (10 * c)) & 0x3FF);
+            v = v >= 512 ? v - 1024 : v;  // Sign-extend
+            value[c] = normalized ? fmaxf(v / 511.0f, -1.0f) : (float)v;
+        }
+        int w = (int)(packed >> 30);
+        w = w >= 2 ? w - 4 : w;
+        value[3] = normalized ? fmaxf((float)w, -1.0f) : (float)w;
+        break;
+    }
+    }
+}
+
+inline void softVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                    GLsizei stride, const void* pointer) {
+    if (!g_softGL.active) { glVertexAttribPointer(index, size, type, normalized, stride, pointer); return; }
+    SoftAttrib* attrib = currentSoftAttrib(index);
+    if (!attrib) return;
+    int bytes = softAttribBytes(type, size);
+    if (!bytes) fprintf(stderr, "Software renderer: unsupported attribute type 0x%x\n", type);
+    attrib->buffer = g_softGL.arrayBuffer;
+    attrib->size = size;
+    attrib->type = type;
+    attrib->normalized = normalized == GL_TRUE;
+    attrib->stride = stride ? stride : bytes;
+    attrib->offset = (size_t)pointer;
+}
+
+inline void softVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    if (!g_softGL.active) { glVertexAttrib4f(index, x, y, z, w); return; }
+    if (index >= (GLuint)SOFT_MAX_ATTRIBS) return;
+    float* value = g_softGL.currentAttribs[index];
+    value[0] = x; value[1] = y; value[2] = z; value[3] = w;
+}
+
+inline void softVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z) {
+    if (!g_softGL.active) { glVertexAttrib3f(index, x, y, z); return; }
+    softVertexAttrib4f(index, x, y, z, 1.0f);
+}
+
+inline void softEnableVertexAttribArray(GLuint index) {
+    if (!g_softGL.active) { glEnableVertexAttribArray(index); return; }
+    SoftAttrib* attrib = currentSoftAttrib(index);
+    if (attrib) attrib->enabled = true;
+}
+
+inline void softDisableVertexAttribArray(GLuint index) {
+    if (!g_softGL.active) { glDisableVertexAttribArray(index); return; }
+    SoftAttrib* attrib = currentSoftAttrib(index);
+    if (attrib) attrib->enabled = false;
+}
+
+inline void softVertexAttribDivisor(GLuint index, GLuint divisor) {
+    if (!g_softGL.active) { glVertexAttribDivisor(index, divisor); return; }
+    SoftAttrib* attrib = currentSoftAttrib(index);
+    if (attrib) attrib->divisor = divisor;
+}
+
+// ---- Shaders and programs ----
+
+inline GLuint softCreateShader(GLenum type) {
+    if (!g_softGL.active) return glCreateShader(type);
+    GLuint name;
+    genSoftObjects(g_softGL.shaders, 1, &name);
+    g_softGL.programs.resize(g_softGL.shaders.size());  // Keep the shared name space in step
+    g_softGL.shaders[name].type = type;
+    return name;
+}
+
+inline void softShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+    if (!g_softGL.active) { glShaderSource(shader, count, string, length); return; }
+    SoftShaderObject* object = findSoftObject(g_softGL.shaders, shader);
+    if (!object) return;
+    object->source.clear();
+    for (GLsizei i = 0; i < count; i++)
+        object->source.append(string[i], length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]));
+}
+
+inline void softCompileShader(GLuint shader) {
+    if (!g_softGL.active) glCompileShader(shader);
+}
+
+inline void softGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    if (!g_softGL.active) { glGetShaderiv(shader, pname, params); return; }
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+inline void softGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (!g_softGL.active) { glGetShaderInfoLog(shader, bufSize, length, infoLog); return; }
+    if (bufSize > 0) infoLog[0] = '\0';
+    if (length) *length = 0;
+}
+
+inline void softDeleteShader(GLuint shader) {
+    if (!g_softGL.active) { glDeleteShader(shader); return; }
+    deleteSoftObjects(g_softGL.shaders, 1, &shader);
+}
+
+inline GLuint softCreateProgram() {
+    if (!g_softGL.active) return glCreateProgram();
+    GLuint name;
+    genSoftObjects(g_softGL.programs, 1, &name);
+    g_softGL.shaders.resize(g_softGL.programs.size());
+    return name;
+}
+
+inline void softAttachShader(GLuint program, GLuint shader) {
+    if (!g_softGL.active) { glAttachShader(program, shader); return; }
+    SoftProgramObject* object = findSoftObject(g_softGL.programs, program);
+    SoftShaderObject* source = findSoftObject(g_softGL.shaders, shader);
+    if (!object || !source) return;
+    if (source->type == GL_VERTEX_SHADER)
+        object->vertexSource = source->source;
+    else
+        object->fragmentSource = source->source;
+}
+
+inline void softLinkProgram(GLuint program) {
+    if (!g_softGL.active) { glLinkProgram(program); return; }
+    SoftProgramObject* object = findSoftObject(g_softGL.programs, program);
+    if (!object) return;
+
+    uint64_t key = hashString(object->fragmentSource.c_str(), hashString(object->vertexSource.c_str()));
+    object->linked = false;
+    for (size_t i = 0; i < g_softGL.registry.size(); i++) {
+        if (g_softGL.registry[i].key == key) {
+            object->linked = true;
+            object->shader = g_softGL.registry[i].shader;
+            object->fragmentMode = g_softGL.registry[i].fragmentMode;
+        }
+    }
+
+    object->uniformNames.clear();
+    parseSoftUniforms(object->vertexSource, object->uniformNames);
+    parseSoftUniforms(object->fragmentSource, object->uniformNames);
+    if (object->uniformNames.size() > (size_t)SOFT_MAX_UNIFORMS)
+        object->uniformNames.resize(SOFT_MAX_UNIFORMS);
+    object->uniformValues.assign(object->uniformNames.size() * 16, 0.0f);
+}
+
+inline void softGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    if (!g_softGL.active) { glGetProgramiv(program, pname, params); return; }
+    SoftProgramObject* object = findSoftObject(g_softGL.programs, program);
+    *params = pname == GL_LINK_STATUS && object && object->linked ? GL_TRUE : 0;
+}
+
+inline void softGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (!g_softGL.active) { glGetProgramInfoLog(program, bufSize, length, infoLog); return; }
+    const char* message = "no CPU vertex shader was given to createShaderProgram() for this program\n";
+    snprintf(infoLog, bufSize, "%s", message);
+    if (length) *length = (GLsizei)strlen(infoLog);
+}
+
+inline void softProgramParameteri(GLuint program, GLenum pname, GLint value) {
+    if (!g_softGL.active) glProgramParameteri(program, pname, value);
+}
+
+inline void softProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length) {
+    if (!g_softGL.active) glProgramBinary(program, binaryFormat, binary, length);
+}
+
+inline void softGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary) {
+    if (!g_softGL.active) { glGetProgramBinary(program, bufSize, length, binaryFormat, binary); return; }
+    if (length) *length = 0;
+}
+
+inline void softUseProgram(GLuint program) {
+    if (!g_softGL.active) { glUseProgram(program); return; }
+    g_softGL.program = program;
+}
+
+inline void softDeleteProgram(GLuint program) {
+    if (!g_softGL.active) { glDeleteProgram(program); return; }
+    deleteSoftObjects(g_softGL.programs, 1, &program);
+}
+
+inline GLint softGetUniformLocation(GLuint program, const GLchar* name) {
+    if (!g_softGL.active) return glGetUniformLocation(program, name);
+    SoftProgramObject* object = findSoftObject(g_softGL.programs, program);
+    if (!object) return -1;
+    for (size_t i = 0; i < object->uniformNames.size(); i++)
+        if (object->uniformNames[i] == name) return (GLint)i;
+    return -1;
+}
+
+// Storage for a uniform of the current program (NULL for location -1)
+inline float* currentSoftUniform(GLint location) {
+    SoftProgramObject* object = findSoftObject(g_softGL.programs, g_softGL.program);
+    if (!object || location < 0 || (size_t)location >= object->uniformNames.size()) return NULL;
+    return &object->uniformValues[(size_t)location * 16];
+}
+
+inline void softUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    if (!g_softGL.active) { glUniformMatrix4fv(location, count, transpose, value); return; }
+    float* uniform = currentSoftUniform(location);
+    if (!uniform) return;
+    for (int i = 0; i < 16; i++)
+        uniform[i] = transpose ? value[(i % 4) * 4 + i / 4] : value[i];
+}
+
+inline void softUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    if (!g_softGL.active) { glUniform4f(location, x, y, z, w); return; }
+    float* uniform = currentSoftUniform(location);
+    if (!uniform) return;
+    uniform[0] = x; uniform[1] = y; uniform[2] = z; uniform[3] = w;
+}
+
+inline void softUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+    if (!g_softGL.active) { glUniform3f(location, x, y, z); return; }
+    float* uniform = currentSoftUniform(location);
+    if (!uniform) return;
+    uniform[0] = x; uniform[1] = y; uniform[2] = z;
+}
+
+inline void softUniform2f(GLint location, GLfloat x, GLfloat y) {
+    if (!g_softGL.active) { glUniform2f(location, x, y); return; }
+    float* uniform = currentSoftUniform(location);
+    if (!uniform) return;
+    uniform[0] = x; uniform[1] = y;
+}
+
+inline void softUniform1f(GLint location, GLfloat x) {
+    if (!g_softGL.active) { glUniform1f(location, x); return; }
+    float* uniform = currentSoftUniform(location);
+    if (uniform) uniform[0] = x;
+}
+
+inline void softUniform1i(GLint location, GLint x) {
+    if (!g_softGL.active) { glUniform1i(location, x); return; }
+    float* uniform = currentSoftUniform(location);
+    if (uniform) uniform[0] = (float)x;
+}
+
+// ---- Textures ----
+
+inline void softGenTextures(GLsizei n, GLuint* textures) {
+    if (!g_softGL.active) { glGenTextures(n, textures); return; }
+    genSoftObjects(g_softGL.textures, n, textures);
+    for (GLsizei i = 0; i < n; i++) {
+        SoftTexture& texture = g_softGL.textures[textures[i]].texture;
+        for (int c = 0; c < 4; c++) texture.swizzle[c] = c;
+        texture.linear = true;
+    }
+}
+
+inline void softDeleteTextures(GLsizei n, const GLuint* textures) {
+    if (!g_softGL.active) { glDeleteTextures(n, textures); return; }
+    deleteSoftObjects(g_softGL.textures, n, textures);
+}
+
+inline void softBindTexture(GLenum target, GLuint texture) {
+    if (!g_softGL.active) { glBindTexture(target, texture); return; }
+    if (target == GL_TEXTURE_2D) g_softGL.texture = texture;
+}
+
+inline void softTexParameteri(GLenum target, GLenum pname, GLint param) {
+    if (!g_softGL.active) { glTexParameteri(target, pname, param); return; }
+    SoftTextureObject* object = findSoftObject(g_softGL.textures, g_softGL.texture);
+    if (!object) return;
+
+    if (pname == GL_TEXTURE_MAG_FILTER) {
+        object->texture.linear = param == GL_LINEAR;
+    } else if (pname >= GL_TEXTURE_SWIZZLE_R && pname <= GL_TEXTURE_SWIZZLE_A) {
+        int source = param == GL_ZERO ? 4 : (param == GL_ONE ? 5 : param - GL_RED);
+        object->texture.swizzle[pname - GL_TEXTURE_SWIZZLE_R] = source;
+    }
+}
+
+// Expand client rows (unpack alignment applies) into the RGBA texels of a region
+inline void copySoftTexels(SoftTexture& texture, int x0, int y0, int width, int height, int channels,
+                           const void* pixels) {
+    int align = g_softGL.unpackAlignment;
+    size_t rowBytes = ((size_t)width * channels + align - 1) / align * align;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* src = (const unsigned char*)pixels + y * rowBytes;
+        unsigned char* dst = &texture.rgba[((size_t)(y0 + y) * texture.width + x0) * 4];
+        for (int x = 0; x < width; x++, src += channels, dst += 4) {
+            dst[0] = src[0];
+            dst[1] = channels > 1 ? src[1] : 0;
+            dst[2] = channels > 2 ? src[2] : 0;
+            dst[3] = channels > 3 ? src[3] : 255;
+        }
+    }
+}
+
+inline void softTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                           GLint border, GLenum format, GLenum type, const void* pixels) {
+    if (!g_softGL.active) {
+        glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+        return;
+    }
+    SoftTextureObject* object = findSoftObject(g_softGL.textures, g_softGL.texture);
+    if (!object || level != 0 || type != GL_UNSIGNED_BYTE) return;
+
+    int channels = format == GL_RGBA ? 4 : (format == GL_RGB ? 3 : (format == GL_RED ? 1 : 0));
+    if (!channels) {
+        fprintf(stderr, "Software renderer: unsupported texture format 0x%x\n", format);
+        return;
+    }
+    SoftTexture& texture = object->texture;
+    texture.width = width;
+    texture.height = height;
+    texture.rgba.assign((size_t)width * height * 4, 0);
+    if (pixels) copySoftTexels(texture, 0, 0, width, height, channels, pixels);
+}
+
+inline void softTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                              GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    if (!g_softGL.active) {
+        glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+        return;
+    }
+    SoftTextureObject* object = findSoftObject(g_softGL.textures, g_softGL.texture);
+    if (!object || level != 0 || type != GL_UNSIGNED_BYTE || !pixels) return;
+    SoftTexture& texture = object->texture;
+    if (xoffset < 0 || yoffset < 0 || xoffset + width > texture.width || yoffset + height > texture.height) return;
+
+    int channels = format == GL_RGBA ? 4 : (format == GL_RGB ? 3 : (format == GL_RED ? 1 : 0));
+    if (!channels) {
+        fprintf(stderr, "Software renderer: unsupported texture format 0x%x\n", format);
+        return;
+    }
+    copySoftTexels(texture, xoffset, yoffset, width, height, channels, pixels);
+}
+
+inline void softPixelStorei(GLenum pname, GLint param) {
+    if (!g_softGL.active) { glPixelStorei(pname, param); return; }
+    if (pname == GL_PACK_ALIGNMENT) g_softGL.packAlignment = param;
+    if (pname == GL_UNPACK_ALIGNMENT) g_softGL.unpackAlignment = param;
+}
+
+// ---- Fixed-function state ----
+
+inline void softEnable(GLenum cap) {
+    if (!g_softGL.active) { glEnable(cap); return; }
+    if (cap == GL_DEPTH_TEST) g_softGL.depthTest = true;
+}
+
+inline void softDisable(GLenum cap) {
+    if (!g_softGL.active) { glDisable(cap); return; }
+    if (cap == GL_DEPTH_TEST) g_softGL.depthTest = false;
+}
+
+inline void softDepthFunc(GLenum func) {
+    if (!g_softGL.active) { glDepthFunc(func); return; }
+    g_softGL.depthFunc = (int)(func - GL_NEVER);
+}
+
+inline void softPolygonMode(GLenum face, GLenum mode) {
+    if (!g_softGL.active) { glPolygonMode(face, mode); return; }
+    g_softGL.wireframe = mode == GL_LINE;
+}
+
+inline void softLineWidth(GLfloat width) {
+    if (!g_softGL.active) { glLineWidth(width); return; }
+    g_softGL.lineWidth = width > 1.0f ? width : 1.0f;
+}
+
+inline void softViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (!g_softGL.active) { glViewport(x, y, width, height); return; }
+    g_softGL.viewport[0] = x;
+    g_softGL.viewport[1] = y;
+    g_softGL.viewport[2] = width;
+    g_softGL.viewport[3] = height;
+}
+
+inline void softClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    if (!g_softGL.active) { glClearColor(r, g, b, a); return; }
+    g_softGL.clearColor[0] = r;
+    g_softGL.clearColor[1] = g;
+    g_softGL.clearColor[2] = b;
+    g_softGL.clearColor[3] = a;
+}
+
+inline void softClear(GLbitfield mask) {
+    if (!g_softGL.active) { glClear(mask); return; }
+    const float* c = g_softGL.clearColor;
+    clearSoftRasterizer(g_softGL.raster, (mask & GL_COLOR_BUFFER_BIT) != 0, packSoftColor(c[0], c[1], c[2], c[3]),
+                        (mask & GL_DEPTH_BUFFER_BIT) != 0, 1.0f);
+}
+
+// ---- Queries ----
+
+inline const GLubyte* softGetString(GLenum name) {
+    if (!g_softGL.active) return glGetString(name);
+    switch (name) {
+        case GL_VENDOR:   return (const GLubyte*)"comvis-assignments";
+        case GL_RENDERER: return (const GLubyte*)"Tile-based software rasterizer";
+        case GL_VERSION:  return (const GLubyte*)"4.1 (software subset)";
+        default:          return (const GLubyte*)"";
+    }
+}
+
+inline void softGetIntegerv(GLenum pname, GLint* data) {
+    if (!g_softGL.active) { glGetIntegerv(pname, data); return; }
+    if (pname == GL_VIEWPORT)
+        memcpy(data, g_softGL.viewport, 4 * sizeof(GLint));
+    else
+        *data = 0;  // Includes GL_NUM_PROGRAM_BINARY_FORMATS: no program binaries
+}
+
+// ---- Drawing ----
+
+// Local vertex indices of the triangles (3 each) or line segments (2 each) of one draw
+inline bool assembleSoftPrimitives(GLenum mode, int count, bool wireframe, std::vector<int>& indices) {
+    indices.clear();
+    bool lines = true;
+    switch (mode) {
+        case GL_LINES:
+            for (int i = 0; i + 1 < count; i += 2) { indices.push_back(i); indices.push_back(i + 1); }
+            break;
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            for (int i = 0; i + 1 < count; i++) { indices.push_back(i); indices.push_back(i + 1); }
+            if (mode == GL_LINE_LOOP && count > 2) { indices.push_back(count - 1); indices.push_back(0); }
+            break;
+        case GL_TRIANGLES:
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            lines = false;
+            for (int i = 0; i + 2 < count; i += (mode == GL_TRIANGLES ? 3 : 1)) {
+                int a = mode == GL_TRIANGLE_FAN ? 0 : i;
+                int b = i + 1, c = i + 2;
+                if (mode == GL_TRIANGLE_STRIP && (i & 1)) { int t = b; b = a; a = t; }  // Keep winding
+                indices.push_back(a); indices.push_back(b); indices.push_back(c);
+            }
+            break;
+        default:
+            fprintf(stderr, "Software renderer: unsupported primitive mode 0x%x\n", mode);
+            break;
+    }
+
+    // Polygon mode GL_LINE: every triangle becomes its three edges
+    if (!lines && wireframe) {
+        std::vector<int> edges;
+        edges.reserve(indices.size() * 2);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            int t[3] = { indices[i], indices[i + 1], indices[i + 2] };
+            for (int e = 0; e < 3; e++) { edges.push_back(t[e]); edges.push_back(t[(e + 1) % 3]); }
+        }
+        indices.swap(edges);
+        lines = true;
+    }
+    return lines;
+}
+
+// Shade vertices [first, first + count) of every instance and set up the
+// primitives in 'indices' (local vertex numbers, from assembleSoftPrimitives)
+inline void drawSoftPrimitives(GLint first, GLsizei count, const std::vector<int>& indices, bool lines,
+                               GLsizei instanceCount) {
+    SoftGL& gl = g_softGL;
+    SoftProgramObject* program = findSoftObject(gl.programs, gl.program);
+    SoftVertexArray* vao = currentSoftVertexArray();
+    if (!program || !program->linked || !vao || count <= 0 || instanceCount <= 0) return;
+
+    size_t primitiveCount = indices.size() / (lines ? 2 : 3);
+    size_t trianglesPerInstance = primitiveCount * (lines ? 2 : 1);
+    if (!trianglesPerInstance) return;
+
+    // Attribute sources: base pointer, format, stride, last readable element.
+    // Disabled arrays (base NULL) read the current attribute value instead.
+    struct Fetch {
+        const unsigned char* base; int size; GLenum type; bool normalized;
+        int stride; unsigned int divisor; long last;
+    };
+    Fetch fetches[SOFT_MAX_ATTRIBS];
+    for (int a = 0; a < SOFT_MAX_ATTRIBS; a++) {
+        const SoftAttrib& attrib = vao->attribs[a];
+        SoftBuffer* buffer = attrib.enabled ? findSoftObject(gl.buffers, attrib.buffer) : NULL;
+        fetches[a].base = NULL;
+        if (!buffer) continue;
+        size_t elementBytes = softAttribBytes(attrib.type, attrib.size);
+        if (!elementBytes || buffer->data.size() < attrib.offset + elementBytes) continue;
+        fetches[a].base = buffer->data.data() + attrib.offset;
+        fetches[a].size = attrib.size;
+        fetches[a].type = attrib.type;
+        fetches[a].normalized = attrib.normalized;
+        fetches[a].stride = attrib.stride;
+        fetches[a].divisor = attrib.divisor;
+        fetches[a].last = (long)((buffer->data.size() - attrib.offset - elementBytes) / attrib.stride);
+    }
+
+    const float* uniforms[SOFT_MAX_UNIFORMS];
+    for (size_t u = 0; u < program->uniformNames.size(); u++)
+        uniforms[u] = &program->uniformValues[u * 16];
+
+    SoftRasterizer& r = gl.raster;
+    SoftRasterState state = { gl.depthTest, gl.depthFunc, NULL };
+    if (program->fragmentMode == SOFT_FRAGMENT_TEXTURE) {
+        SoftTextureObject* texture = findSoftObject(gl.textures, gl.texture);
+        if (!texture || texture->texture.rgba.empty()) return;
+        state.texture = &texture->texture;
+    }
+    int stateIndex = pushSoftState(r, state);
+
+    // Viewport transform and scissor to the viewport
+    const int* vp = gl.viewport;
+    int sx0 = vp[0] > 0 ? vp[0] : 0, sy0 = vp[1] > 0 ? vp[1] : 0;
+    int sx1 = (vp[0] + vp[2] < r.width ? vp[0] + vp[2] : r.width) - 1;
+    int sy1 = (vp[1] + vp[3] < r.height ? vp[1] + vp[3] : r.height) - 1;
+    float lineWidth = gl.lineWidth;
+    SoftVertexShader shader = program->shader;
+
+    size_t base = r.triangles.size();
+    r.triangles.resize(base + trianglesPerInstance * instanceCount);
+
+    auto shadeInstances = [&](size_t begin, size_t end) {
+        std::vector<SoftVertex> vertices(count);
+        float attribs[SOFT_MAX_ATTRIBS + 1][4];
+        for (size_t instance = begin; instance < end; instance++) {
+            for (int i = 0; i < count; i++) {
+                attribs[SOFT_VERTEX_ID][0] = (float)(first + i);
+                attribs[SOFT_VERTEX_ID][1] = (float)instance;
+                attribs[SOFT_VERTEX_ID][2] = 0.0f;
+                attribs[SOFT_VERTEX_ID][3] = 1.0f;
+                for (int a = 0; a < SOFT_MAX_ATTRIBS; a++) {
+                    float* value = attribs[a];
+                    const Fetch& f = fetches[a];
+                    if (!f.base) {
+                        memcpy(value, gl.currentAttribs[a], 4 * sizeof(float));
+                        continue;
+                    }
+                    value[0] = value[1] = value[2] = 0.0f;
+                    value[3] = 1.0f;
+                    long element = f.divisor ? (long)(instance / f.divisor) : (long)(first + i);
+                    if (element > f.last) continue;
+                    fetchSoftAttrib(f.base + element * f.stride, f.type, f.normalized, f.size, value);
+                }
+
+                float position[4];
+                SoftVertex& v = vertices[i];
+                shader(attribs, uniforms, position, v.varying);
+                v.clipped = position[3] <= 0.0f;
+                float invW = v.clipped ? 0.0f : 1.0f / position[3];
+                v.x = vp[0] + (position[0] * invW + 1.0f) * 0.5f * vp[2];
+                v.y = vp[1] + (position[1] * invW + 1.0f) * 0.5f * vp[3];
+                v.z = (position[2] * invW + 1.0f) * 0.5f;
+            }
+
+            SoftTriangle* out = &r.triangles[base + instance * trianglesPerInstance];
+            if (lines) {
+                for (size_t p = 0; p < primitiveCount; p++, out += 2)
+                    setupSoftLine(vertices[indices[2 * p]], vertices[indices[2 * p + 1]], lineWidth,
+                                  stateIndex, sx0, sy0, sx1, sy1, out);
+            } else {
+                for (size_t p = 0; p < primitiveCount; p++, out++)
+                    setupSoftTriangle(vertices[indices[3 * p]], vertices[indices[3 * p + 1]],
+                                      vertices[indices[3 * p + 2]], stateIndex, sx0, sy0, sx1, sy1, *out);
+            }
+        }
+    };
+
+    // Large instanced draws shade and set up in parallel; each instance owns its output slots
+    if ((size_t)instanceCount * count >= 4096)
+        r.pool->parallelFor((size_t)instanceCount, 256, shadeInstances);
+    else
+        shadeInstances(0, (size_t)instanceCount);
+}
+
+inline void softDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+    if (!g_softGL.active) { glDrawArraysInstanced(mode, first, count, instanceCount); return; }
+    std::vector<int> indices;
+    bool lines = assembleSoftPrimitives(mode, count, g_softGL.wireframe, indices);
+    drawSoftPrimitives(first, count, indices, lines, instanceCount);
+}
+
+// Indexed draw: only the vertex range the indices span is shaded, once per instance
+inline void softDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* offset,
+                                      GLsizei instanceCount) {
+    if (!g_softGL.active) { glDrawElementsInstanced(mode, count, type, offset, instanceCount); return; }
+    SoftVertexArray* vao = currentSoftVertexArray();
+    SoftBuffer* buffer = vao ? findSoftObject(g_softGL.buffers, vao->elementBuffer) : NULL;
+    size_t indexBytes = type == GL_UNSIGNED_BYTE ? 1 : (type == GL_UNSIGNED_SHORT ? 2 : 4);
+    if (!buffer || count <= 0 || (size_t)offset + count * indexBytes > buffer->data.size()) return;
+
+    std::vector<int> elements(count);
+    const unsigned char* source = buffer->data.data() + (size_t)offset;
+    int minIndex = 0x7fffffff, maxIndex = 0;
+    for (GLsizei i = 0; i < count; i++) {
+        if (indexBytes == 1) elements[i] = source[i];
+        else if (indexBytes == 2) elements[i] = ((const uint16_t*)source)[i];
+        else elements[i] = (int)((const uint32_t*)source)[i];
+        minIndex = elements[i] < minIndex ? elements[i] : minIndex;
+        maxIndex = elements[i] > maxIndex ? elements[i] : maxIndex;
+    }
+
+    // Primitives over the index list, then renumbered into the shaded range
+    std::vector<int> indices;
+    bool lines = assembleSoftPrimitives(mode, count, g_softGL.wireframe, indices);
+    for (size_t i = 0; i < indices.size(); i++)
+        indices[i] = elements[indices[i]] - minIndex;
+    drawSoftPrimitives(minIndex, maxIndex - minIndex + 1, indices, lines, instanceCount);
+}
+
+inline void softDrawElements(GLenum mode, GLsizei count, GLenum type, const void* offset) {
+    if (!g_softGL.active) { glDrawElements(mode, count, type, offset); return; }
+    softDrawElementsInstanced(mode, count, type, offset, 1);
+}
+
+inline void softDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    if (!g_softGL.active) { glDrawArrays(mode, first, count); return; }
+    softDrawArraysInstanced(mode, first, count, 1);
+}
+
+inline void softFinish() {
+    if (!g_softGL.active) { glFinish(); return; }
+    flushSoftRasterizer(g_softGL.raster);
+}
+
+inline void softReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+    if (!g_softGL.active) { glReadPixels(x, y, width, height, format, type, pixels); return; }
+    SoftRasterizer& r = g_softGL.raster;
+    flushSoftRasterizer(r);
+
+    int channels = format == GL_RGBA ? 4 : 3;
+    int align = g_softGL.packAlignment;
+    size_t rowBytes = ((size_t)width * channels + align - 1) / align * align;
+    for (int row = 0; row < height; row++) {
+        unsigned char* dst = (unsigned char*)pixels + row * rowBytes;
+        int sy = y + row;
+        for (int col = 0; col < width; col++, dst += channels) {
+            int sx = x + col;
+            uint32_t c = sx >= 0 && sx < r.width && sy >= 0 && sy < r.height ? r.color[(size_t)sy * r.stride + sx] : 0;
+            for (int k = 0; k < channels; k++) dst[k] = (unsigned char)(c >> (8 * k));
+        }
+    }
+}
+
+// Route the activities' GL calls through the wrappers above
+#define glGenBuffers softGenBuffers
+#define glDeleteBuffers softDeleteBuffers
+#define glBindBuffer softBindBuffer
+#define glBufferData softBufferData
+#define glBufferSubData softBufferSubData
+#define glGenVertexArrays softGenVertexArrays
+#define glDeleteVertexArrays softDeleteVertexArrays
+#define glBindVertexArray softBindVertexArray
+#define glVertexAttribPointer softVertexAttribPointer
+#define glEnableVertexAttribArray softEnableVertexAttribArray
+#define glDisableVertexAttribArray softDisableVertexAttribArray
+#define glVertexAttribDivisor softVertexAttribDivisor
+#define glVertexAttrib4f softVertexAttrib4f
+#define glVertexAttrib3f softVertexAttrib3f
+#define glCreateShader softCreateShader
+#define glShaderSource softShaderSource
+#define glCompileShader softCompileShader
+#define glGetShaderiv softGetShaderiv
+#define glGetShaderInfoLog softGetShaderInfoLog
+#define glDeleteShader softDeleteShader
+#define glCreateProgram softCreateProgram
+#define glAttachShader softAttachShader
+#define glLinkProgram softLinkProgram
+#define glGetProgramiv softGetProgramiv
+#define glGetProgramInfoLog softGetProgramInfoLog
+#define glProgramParameteri softProgramParameteri
+#define glProgramBinary softProgramBinary
+#define glGetProgramBinary softGetProgramBinary
+#define glUseProgram softUseProgram
+#define glDeleteProgram softDeleteProgram
+#define glGetUniformLocation softGetUniformLocation
+#define glUniformMatrix4fv softUniformMatrix4fv
+#define glUniform4f softUniform4f
+#define glUniform3f softUniform3f
+#define glUniform2f softUniform2f
+#define glUniform1f softUniform1f
+#define glUniform1i softUniform1i
+#define glGenTextures softGenTextures
+#define glDeleteTextures softDeleteTextures
+#define glBindTexture softBindTexture
+#define glTexParameteri softTexParameteri
+#define glTexImage2D softTexImage2D
+#define glTexSubImage2D softTexSubImage2D
+#define glPixelStorei softPixelStorei
+#define glEnable softEnable
+#define glDisable softDisable
+#define glDepthFunc softDepthFunc
+#define glPolygonMode softPolygonMode
+#define glLineWidth softLineWidth
+#define glViewport softViewport
+#define glClearColor softClearColor
+#define glClear softClear
+#define glGetString softGetString
+#define glGetIntegerv softGetIntegerv
+#define glDrawArrays softDrawArrays
+#define glDrawArraysInstanced softDrawArraysInstanced
+#define glDrawElements softDrawElements
+#define glDrawElementsInstanced softDrawElementsInstanced
+#define glFinish softFinish
+#define glReadPixels softReadPixels
+
+#endif // SOFT_GL_H
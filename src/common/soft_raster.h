@@ -0,0 +1,369 @@
+#ifndef SOFT_RASTER_H
+#define SOFT_RASTER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "simd.h"
+#include "thread_pool.h"
+
+/*
+ * Binned, tile-parallel triangle rasterizer (CPU backend for soft_gl.h)
+ *
+ * Draws are not rasterized immediately. Each triangle is set up once (edge
+ * functions and attribute planes) and appended to the frame's list; a flush
+ * bins the list into 64x64 tiles and rasterizes tiles in parallel. Inside a
+ * tile, triangles run in submission order, so results match the GL
+ * ordering rules without locks. Pixels are tested 4 at a time with the
+ * half-space edge functions (simd.h).
+ *
+ * Conventions follow GL: window coordinates with y up, row 0 at the bottom,
+ * pixel centers at +0.5, vertices snapped to 1/256 pixel, and a left/bottom
+ * fill rule so shared edges are drawn exactly once. Lines are drawn
+ * as quads of the current line width.
+ */
+
+const int SOFT_TILE_SIZE = 64;
+const int SOFT_VARYINGS = 4;
+const int SOFT_PLANES = 1 + SOFT_VARYINGS;  // Depth, then varyings
+
+// Depth functions in GL order (GL_NEVER + i)
+enum SoftDepthFunc {
+    SOFT_DEPTH_NEVER, SOFT_DEPTH_LESS, SOFT_DEPTH_EQUAL, SOFT_DEPTH_LEQUAL,
+    SOFT_DEPTH_GREATER, SOFT_DEPTH_NOTEQUAL, SOFT_DEPTH_GEQUAL, SOFT_DEPTH_ALWAYS
+};
+
+// RGBA8 texture, rows bottom to top like GL; swizzle picks the source channel
+// (0-3) or a constant (4 = zero, 5 = one) for each output channel
+struct SoftTexture {
+    int width;
+    int height;
+    std::vector<unsigned char> rgba;
+    int swizzle[4];
+    bool linear;
+};
+
+// Fixed-function state captured with each draw
+struct SoftRasterState {
+    bool depthTest;
+    int depthFunc;               // SoftDepthFunc
+    const SoftTexture* texture;  // Non-NULL: varyings are (u, v, brightness, -)
+};
+
+// Vertex after the vertex shader and viewport transform
+struct SoftVertex {
+    float x, y, z;
+    float varying[SOFT_VARYINGS];
+    bool clipped;  // w <= 0: primitives using it are dropped
+};
+
+// Set-up triangle. Edge functions and planes are relative to the center of
+// pixel (x0, y0); planes are (d/dx, d/dy, value at that center).
+struct SoftTriangle {
+    int x0, y0, x1, y1;  // Inclusive pixel bounds; x0 > x1 means nothing to draw
+    float edgeA[3], edgeB[3], edgeC[3];
+    float edgeBias[3];   // Pixel is inside when edge > bias
+    float plane[SOFT_PLANES][3];
+    int state;
+};
+
+struct SoftRasterizer {
+    int width;
+    int height;
+    int stride;                       // Row pitch in pixels (multiple of 4)
+    std::vector<uint32_t> color;      // RGBA8, bytes r, g, b, a in memory
+    std::vector<float> depth;
+    int tilesX;
+    int tilesY;
+    std::vector<std::vector<uint32_t> > bins;
+    std::vector<SoftTriangle> triangles;
+    std::vector<SoftRasterState> states;
+    ThreadPool* pool;
+};
+
+inline void resizeSoftRasterizer(SoftRasterizer& r, int width, int height) {
+    r.width = width;
+    r.height = height;
+    r.stride = (width + 3) & ~3;
+    r.color.assign((size_t)r.stride * height, 0);
+    r.depth.assign((size_t)r.stride * height, 1.0f);
+    r.tilesX = (width + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    r.tilesY = (height + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    r.bins.assign((size_t)r.tilesX * r.tilesY, std::vector<uint32_t>());
+}
+
+inline uint32_t packSoftColor(float r, float g, float b, float a) {
+    float c[4] = { r, g, b, a };
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; i++) {
+        float v = c[i] < 0.0f ? 0.0f : (c[i] > 1.0f ? 1.0f : c[i]);
+        packed |= (uint32_t)(v * 255.0f + 0.5f) << (8 * i);
+    }
+    return packed;
+}
+
+// Start a new draw's state; returns its index for the triangles that follow
+inline int pushSoftState(SoftRasterizer& r, const SoftRasterState& state) {
+    r.states.push_back(state);
+    return (int)r.states.size() - 1;
+}
+
+inline float snapSubpixel(float v) {
+    return floorf(v * 256.0f + 0.5f) * (1.0f / 256.0f);
+}
+
+// Set up one triangle clipped to the scissor rectangle [sx0, sx1] x [sy0, sy1]
+// (inclusive pixels). Either winding is accepted; there is no face culling.
+inline void setupSoftTriangle(const SoftVertex& v0, const SoftVertex& v1, const SoftVertex& v2, int state,
+                              int sx0, int sy0, int sx1, int sy1, SoftTriangle& tri) {
+    tri.state = state;
+    tri.x0 = 1;
+    tri.x1 = 0;  // Empty until proven otherwise
+    if (v0.clipped || v1.clipped || v2.clipped) return;
+
+    const SoftVertex* v[3] = { &v0, &v1, &v2 };
+    double x[3], y[3];
+    for (int i = 0; i < 3; i++) {
+        x[i] = snapSubpixel(v[i]->x);
+        y[i] = snapSubpixel(v[i]->y);
+    }
+    double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0.0) return;
+    if (area < 0.0) {  // Make it counter-clockwise
+        const SoftVertex* t = v[1]; v[1] = v[2]; v[2] = t;
+        double tx = x[1]; x[1] = x[2]; x[2] = tx;
+        double ty = y[1]; y[1] = y[2]; y[2] = ty;
+        area = -area;
+    }
+
+    double minX = fmin(x[0], fmin(x[1], x[2])), maxX = fmax(x[0], fmax(x[1], x[2]));
+    double minY = fmin(y[0], fmin(y[1], y[2])), maxY = fmax(y[0], fmax(y[1], y[2]));
+    int x0 = (int)ceil(minX - 0.5), x1 = (int)floor(maxX - 0.5);
+    int y0 = (int)ceil(minY - 0.5), y1 = (int)floor(maxY - 0.5);
+    tri.x0 = x0 > sx0 ? x0 : sx0;
+    tri.y0 = y0 > sy0 ? y0 : sy0;
+    tri.x1 = x1 < sx1 ? x1 : sx1;
+    tri.y1 = y1 < sy1 ? y1 : sy1;
+    if (tri.x0 > tri.x1 || tri.y0 > tri.y1) return;
+
+    // Edge i is opposite vertex i, so its value is vertex i's barycentric weight * area
+    double ox = tri.x0 + 0.5, oy = tri.y0 + 0.5;
+    double weightC[3];
+    for (int i = 0; i < 3; i++) {
+        int a = (i + 1) % 3, b = (i + 2) % 3;
+        double dx = x[b] - x[a], dy = y[b] - y[a];
+        tri.edgeA[i] = (float)-dy;
+        tri.edgeB[i] = (float)dx;
+        weightC[i] = -dy * (ox - x[a]) + dx * (oy - y[a]);
+        tri.edgeC[i] = (float)weightC[i];
+        // Fill rule: pixels exactly on an edge belong to left and bottom edges only
+        // (D3D's top-left rule with y pointing up; matches Mesa)
+        bool ownsEdge = dy < 0.0 || (dy == 0.0 && dx > 0.0);
+        tri.edgeBias[i] = ownsEdge ? -1.0f / 1024.0f : 0.0f;
+    }
+
+    // Attribute planes from the barycentric weights
+    for (int p = 0; p < SOFT_PLANES; p++) {
+        double value[3];
+        for (int i = 0; i < 3; i++)
+            value[i] = p == 0 ? v[i]->z : v[i]->varying[p - 1];
+        double dx = 0.0, dy = 0.0, c = 0.0;
+        for (int i = 0; i < 3; i++) {
+            dx += tri.edgeA[i] * value[i];
+            dy += tri.edgeB[i] * value[i];
+            c += weightC[i] * value[i];
+        }
+        tri.plane[p][0] = (float)(dx / area);
+        tri.plane[p][1] = (float)(dy / area);
+        tri.plane[p][2] = (float)(c / area);
+    }
+}
+
+// A line of the given width becomes a quad (two triangles)
+inline void setupSoftLine(const SoftVertex& a, const SoftVertex& b, float width, int state,
+                          int sx0, int sy0, int sx1, int sy1, SoftTriangle tris[2]) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0.0f || a.clipped || b.clipped) {
+        tris[0].x0 = tris[1].x0 = 1;
+        tris[0].x1 = tris[1].x1 = 0;
+        return;
+    }
+    float nx = -dy / length * width * 0.5f, ny = dx / length * width * 0.5f;
+    SoftVertex a0 = a, a1 = a, b0 = b, b1 = b;
+    a0.x += nx; a0.y += ny;
+    a1.x -= nx; a1.y -= ny;
+    b0.x -= nx; b0.y -= ny;
+    b1.x += nx; b1.y += ny;
+    setupSoftTriangle(a0, a1, b0, state, sx0, sy0, sx1, sy1, tris[0]);
+    setupSoftTriangle(a0, b0, b1, state, sx0, sy0, sx1, sy1, tris[1]);
+}
+
+// Sample a texture at (u, v) in [0, 1]^2 (clamp to edge)
+inline void sampleSoftTexture(const SoftTexture& t, float u, float v, float out[4]) {
+    float fx = u * t.width - 0.5f, fy = v * t.height - 0.5f;
+    float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    if (t.linear) {
+        int ix = (int)floorf(fx), iy = (int)floorf(fy);
+        float wx = fx - ix, wy = fy - iy;
+        for (int j = 0; j < 2; j++) {
+            int sy = iy + j < 0 ? 0 : (iy + j >= t.height ? t.height - 1 : iy + j);
+            for (int i = 0; i < 2; i++) {
+                int sx = ix + i < 0 ? 0 : (ix + i >= t.width ? t.width - 1 : ix + i);
+                float w = (i ? wx : 1.0f - wx) * (j ? wy : 1.0f - wy);
+                const unsigned char* p = &t.rgba[((size_t)sy * t.width + sx) * 4];
+                for (int c = 0; c < 4; c++) texel[c] += w * p[c];
+            }
+        }
+    } else {
+        int sx = (int)floorf(fx + 0.5f), sy = (int)floorf(fy + 0.5f);
+        sx = sx < 0 ? 0 : (sx >= t.width ? t.width - 1 : sx);
+        sy = sy < 0 ? 0 : (sy >= t.height ? t.height - 1 : sy);
+        const unsigned char* p = &t.rgba[((size_t)sy * t.width + sx) * 4];
+        for (int c = 0; c < 4; c++) texel[c] = p[c];
+    }
+    for (int c = 0; c < 4; c++) {
+        int s = t.swizzle[c];
+        out[c] = s < 4 ? texel[s] * (1.0f / 255.0f) : (s == 5 ? 1.0f : 0.0f);
+    }
+}
+
+// Bits of the 4 lanes that pass the depth function
+inline int softDepthPass(int depthFunc, f32x4 z, f32x4 stored) {
+    int less = f32x4_movemask(f32x4_cmplt(z, stored));
+    int greater = f32x4_movemask(f32x4_cmpgt(z, stored));
+    int equal = ~(less | greater) & 0xF;
+    switch (depthFunc) {
+        case SOFT_DEPTH_NEVER:    return 0;
+        case SOFT_DEPTH_LESS:     return less;
+        case SOFT_DEPTH_EQUAL:    return equal;
+        case SOFT_DEPTH_LEQUAL:   return less | equal;
+        case SOFT_DEPTH_GREATER:  return greater;
+        case SOFT_DEPTH_NOTEQUAL: return less | greater;
+        case SOFT_DEPTH_GEQUAL:   return greater | equal;
+        default:                  return 0xF;
+    }
+}
+
+// Rasterize every binned triangle of one tile, in submission order
+inline void rasterizeSoftTile(SoftRasterizer& r, int tile) {
+    int tileX0 = (tile % r.tilesX) * SOFT_TILE_SIZE;
+    int tileY0 = (tile / r.tilesX) * SOFT_TILE_SIZE;
+    int tileX1 = tileX0 + SOFT_TILE_SIZE - 1 < r.width - 1 ? tileX0 + SOFT_TILE_SIZE - 1 : r.width - 1;
+    int tileY1 = tileY0 + SOFT_TILE_SIZE - 1 < r.height - 1 ? tileY0 + SOFT_TILE_SIZE - 1 : r.height - 1;
+    const f32x4 laneOffsets = f32x4_set(0.0f, 1.0f, 2.0f, 3.0f);
+    const f32x4 zero = f32x4_set1(0.0f), one = f32x4_set1(1.0f);
+
+    const std::vector<uint32_t>& bin = r.bins[tile];
+    for (size_t t = 0; t < bin.size(); t++) {
+        const SoftTriangle& tri = r.triangles[bin[t]];
+        const SoftRasterState& state = r.states[tri.state];
+        int x0 = tri.x0 > tileX0 ? tri.x0 : tileX0, x1 = tri.x1 < tileX1 ? tri.x1 : tileX1;
+        int y0 = tri.y0 > tileY0 ? tri.y0 : tileY0, y1 = tri.y1 < tileY1 ? tri.y1 : tileY1;
+
+        f32x4 edgeA[3], edgeBias[3];
+        for (int e = 0; e < 3; e++) {
+            edgeA[e] = f32x4_set1(tri.edgeA[e]);
+            edgeBias[e] = f32x4_set1(tri.edgeBias[e]);
+        }
+
+        for (int y = y0; y <= y1; y++) {
+            float rowY = (float)(y - tri.y0);
+            f32x4 rowEdge[3];
+            for (int e = 0; e < 3; e++)
+                rowEdge[e] = f32x4_set1(tri.edgeC[e] + tri.edgeB[e] * rowY);
+            uint32_t* colorRow = &r.color[(size_t)y * r.stride];
+            float* depthRow = &r.depth[(size_t)y * r.stride];
+
+            for (int x = x0; x <= x1; x += 4) {
+                f32x4 dx = f32x4_add(f32x4_set1((float)(x - tri.x0)), laneOffsets);
+                int mask = x1 - x >= 3 ? 0xF : (1 << (x1 - x + 1)) - 1;
+                for (int e = 0; e < 3 && mask; e++) {
+                    f32x4 edge = f32x4_add(rowEdge[e], f32x4_mul(edgeA[e], dx));
+                    mask &= f32x4_movemask(f32x4_cmpgt(edge, edgeBias[e]));
+                }
+                if (!mask) continue;
+
+                // Depth: drop fragments outside [0, 1] (the near/far planes), then test
+                f32x4 z = f32x4_add(f32x4_set1(tri.plane[0][2] + tri.plane[0][1] * rowY),
+                                    f32x4_mul(f32x4_set1(tri.plane[0][0]), dx));
+                mask &= ~(f32x4_movemask(f32x4_cmplt(z, zero)) | f32x4_movemask(f32x4_cmpgt(z, one)));
+                float zs[4];
+                f32x4_store(zs, z);
+                if (state.depthTest && mask) {
+                    float stored[4];
+                    for (int k = 0; k < 4; k++)
+                        stored[k] = (mask >> k) & 1 ? depthRow[x + k] : 0.0f;
+                    mask &= softDepthPass(state.depthFunc, z, f32x4_load(stored));
+                    for (int k = 0; k < 4; k++)
+                        if ((mask >> k) & 1) depthRow[x + k] = zs[k];
+                }
+                if (!mask) continue;
+
+                float varying[SOFT_VARYINGS][4];
+                for (int p = 0; p < SOFT_VARYINGS; p++) {
+                    const float* plane = tri.plane[p + 1];
+                    f32x4 value = f32x4_add(f32x4_set1(plane[2] + plane[1] * rowY),
+                                            f32x4_mul(f32x4_set1(plane[0]), dx));
+                    f32x4_store(varying[p], value);
+                }
+
+                for (int k = 0; k < 4; k++) {
+                    if (!((mask >> k) & 1)) continue;
+                    if (state.texture) {
+                        float texel[4];
+                        sampleSoftTexture(*state.texture, varying[0][k], varying[1][k], texel);
+                        float brightness = varying[2][k];
+                        colorRow[x + k] = packSoftColor(texel[0] * brightness, texel[1] * brightness,
+                                                        texel[2] * brightness, 1.0f);
+                    } else {
+                        colorRow[x + k] = packSoftColor(varying[0][k], varying[1][k],
+                                                        varying[2][k], varying[3][k]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Rasterize everything queued since the last flush
+inline void flushSoftRasterizer(SoftRasterizer& r) {
+    if (r.triangles.empty()) {
+        r.states.clear();
+        return;
+    }
+
+    // Bin: every triangle goes to each tile its bounds touch, in submission order
+    for (size_t i = 0; i < r.bins.size(); i++)
+        r.bins[i].clear();
+    for (size_t i = 0; i < r.triangles.size(); i++) {
+        const SoftTriangle& tri = r.triangles[i];
+        if (tri.x0 > tri.x1) continue;
+        int tx0 = tri.x0 / SOFT_TILE_SIZE, tx1 = tri.x1 / SOFT_TILE_SIZE;
+        int ty0 = tri.y0 / SOFT_TILE_SIZE, ty1 = tri.y1 / SOFT_TILE_SIZE;
+        for (int ty = ty0; ty <= ty1; ty++)
+            for (int tx = tx0; tx <= tx1; tx++)
+                r.bins[(size_t)ty * r.tilesX + tx].push_back((uint32_t)i);
+    }
+
+    r.pool->parallelFor(r.bins.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++)
+            rasterizeSoftTile(r, (int)tile);
+    });
+
+    r.triangles.clear();
+    r.states.clear();
+}
+
+// Clear color and/or depth (queued triangles are drawn first)
+inline void clearSoftRasterizer(SoftRasterizer& r, bool clearColor, uint32_t color, bool clearDepth, float depth) {
+    flushSoftRasterizer(r);
+    r.pool->parallelFor((size_t)r.height, 16, [&](size_t begin, size_t end) {
+        size_t from = begin * r.stride, to = end * r.stride;
+        if (clearColor) std::fill(r.color.begin() + from, r.color.begin() + to, color);
+        if (clearDepth) std::fill(r.depth.begin() + from, r.depth.begin() + to, depth);
+    });
+}
+
+#endif // SOFT_RASTER_H
@@ -0,0 +1,159 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "opengl_setup.h"
+
+/*
+ * Triple-buffered streaming vertex buffer
+ *
+ * One GL buffer is split into STREAM_BUFFER_REGIONS regions; each frame
+ * writes its dynamic vertices into the next region while the GPU may still
+ * be reading the previous ones. A fence after each frame's draws guards the
+ * region: it is only rewritten once that fence has signaled, so there is no
+ * driver reallocation (as with glBufferData orphaning) and no implicit wait
+ * (as with glBufferSubData on a buffer in use).
+ *
+ * Where GL_ARB_buffer_storage is available (GL 4.4, Mesa) the buffer is
+ * mapped once, persistent and coherent. Core 4.1 (macOS) has no persistent
+ * mapping, so each region is mapped unsynchronized for the frame's writes;
+ * the fences make that safe. The software renderer stages writes in memory
+ * and copies them in with glBufferSubData.
+ *
+ * Per frame: beginStreamFrame(), streamWrite() for each array (returns the
+ * byte offset to point attributes at), commitStreamFrame(), then draw.
+ */
+
+const int STREAM_BUFFER_REGIONS = 3;
+const size_t STREAM_BUFFER_ALIGNMENT = 64;  // Offset alignment of each write
+
+struct StreamBuffer {
+    unsigned int vbo;
+    size_t regionBytes;
+    int region;                          // Region written this frame (-1 before the first)
+    GLsync fences[STREAM_BUFFER_REGIONS];
+    unsigned char* persistent;           // Whole buffer when mapped once, else NULL
+    unsigned char* mapped;               // Current region while it is being written
+    size_t used;                         // Bytes written into the current region
+    std::vector<unsigned char> staging;  // Software renderer
+    int frames;
+    size_t totalBytes;
+    int fenceWaits;                      // Frames that found their region still in use
+};
+
+// Create a buffer holding STREAM_BUFFER_REGIONS regions of regionBytes each
+inline void createStreamBuffer(StreamBuffer& stream, size_t regionBytes) {
+    stream.regionBytes = (regionBytes + STREAM_BUFFER_ALIGNMENT - 1) & ~(STREAM_BUFFER_ALIGNMENT - 1);
+    stream.region = -1;
+    for (int i = 0; i < STREAM_BUFFER_REGIONS; i++) stream.fences[i] = 0;
+    stream.persistent = NULL;
+    stream.mapped = NULL;
+    stream.used = 0;
+    stream.frames = 0;
+    stream.totalBytes = 0;
+    stream.fenceWaits = 0;
+
+    size_t bufferBytes = stream.regionBytes * STREAM_BUFFER_REGIONS;
+    glGenBuffers(1, &stream.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+#ifndef __APPLE__
+    if (hasGLExtension("GL_ARB_buffer_storage")) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, bufferBytes, NULL, flags);
+        stream.persistent = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferBytes, flags);
+        if (stream.persistent) return;
+        // Immutable storage cannot be respecified: start over with a mutable buffer
+        glDeleteBuffers(1, &stream.vbo);
+        glGenBuffers(1, &stream.vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+    }
+#endif
+    glBufferData(GL_ARRAY_BUFFER, bufferBytes, NULL, GL_STREAM_DRAW);
+    if (g_softGL.active) stream.staging.resize(stream.regionBytes);
+}
+
+// Move to the next region, waiting for the GPU if it still reads it.
+// The fence for the previous frame is placed here, after its draws.
+inline void beginStreamFrame(StreamBuffer& stream) {
+    bool gl = !g_softGL.active;
+    if (gl && stream.region >= 0) stream.fences[stream.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stream.region = (stream.region + 1) % STREAM_BUFFER_REGIONS;
+    stream.used = 0;
+
+    GLsync& fence = stream.fences[stream.region];
+    if (fence) {
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            stream.fenceWaits++;
+            while (status == GL_TIMEOUT_EXPIRED)
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);  // 1 s
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    size_t offset = (size_t)stream.region * stream.regionBytes;
+    if (!gl) {
+        stream.mapped = stream.staging.data();
+    } else if (stream.persistent) {
+        stream.mapped = stream.persistent + offset;
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+        stream.mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, offset, stream.regionBytes,
+                                                         GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                                         GL_MAP_INVALIDATE_RANGE_BIT);
+    }
+}
+
+// Copy bytes into this frame's region and set offset to where they start in
+// the buffer. False if the region is full (or could not be mapped).
+inline bool streamWrite(StreamBuffer& stream, const void* data, size_t bytes, size_t& offset) {
+    size_t start = (stream.used + STREAM_BUFFER_ALIGNMENT - 1) & ~(STREAM_BUFFER_ALIGNMENT - 1);
+    if (!stream.mapped || start + bytes > stream.regionBytes) {
+        fprintf(stderr, "Stream buffer: %zu bytes do not fit the %zu-byte region\n", bytes, stream.regionBytes);
+        return false;
+    }
+    memcpy(stream.mapped + start, data, bytes);
+    stream.used = start + bytes;
+    stream.totalBytes += bytes;
+    offset = (size_t)stream.region * stream.regionBytes + start;
+    return true;
+}
+
+// Finish this frame's writes; draws may use the region afterwards
+inline void commitStreamFrame(StreamBuffer& stream) {
+    if (g_softGL.active) {
+        glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, (size_t)stream.region * stream.regionBytes, stream.used, stream.mapped);
+    } else if (!stream.persistent && stream.mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    stream.mapped = NULL;
+    stream.frames++;
+}
+
+inline void printStreamBufferStats(const StreamBuffer& stream, const char* name) {
+    if (stream.frames == 0) return;
+    printf("%s: %.1f KB streamed per frame over %d frames (%s, %d fence waits)\n", name,
+           stream.totalBytes / 1024.0 / stream.frames, stream.frames,
+           g_softGL.active ? "software" : (stream.persistent ? "persistent map" : "unsynchronized map"),
+           stream.fenceWaits);
+}
+
+inline void destroyStreamBuffer(StreamBuffer& stream) {
+    if (!g_softGL.active) {
+        for (int i = 0; i < STREAM_BUFFER_REGIONS; i++)
+            if (stream.fences[i]) glDeleteSync(stream.fences[i]);
+        if (stream.persistent) {
+            glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+    }
+    glDeleteBuffers(1, &stream.vbo);
+    stream = StreamBuffer();
+}
+
+#endif // STREAM_BUFFER_H
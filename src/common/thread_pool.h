@@ -0,0 +1,117 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Persistent worker pool for data-parallel loops
+ * parallelFor() splits [0, count) into chunks that workers (and the calling
+ * thread) claim from a shared counter, then blocks until every chunk is done.
+ */
+
+// Number of hardware threads (at least 1)
+inline int hardwareThreads() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n > 0 ? (int)n : 1;
+}
+
+class ThreadPool {
+public:
+    // threadCount includes the calling thread; 0 means one per hardware thread
+    explicit ThreadPool(int threadCount = 0)
+        : generation(0), pendingWorkers(0), stopping(false), count(0), grain(1), job(NULL) {
+        if (threadCount <= 0) threadCount = hardwareThreads();
+        for (int i = 1; i < threadCount; i++)
+            workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    int size() const { return (int)workers.size() + 1; }
+
+    // Run fn(begin, end) over [0, count) in chunks of 'grain' items
+    void parallelFor(size_t itemCount, size_t chunkSize, const std::function<void(size_t, size_t)>& fn) {
+        if (itemCount == 0) return;
+        if (chunkSize == 0) chunkSize = 1;
+
+        // Small jobs (or a single-thread pool) run inline
+        if (workers.empty() || itemCount <= chunkSize) {
+            fn(0, itemCount);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count = itemCount;
+            grain = chunkSize;
+            job = &fn;
+            next.store(0);
+            pendingWorkers = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pendingWorkers == 0; });
+        job = NULL;
+    }
+
+private:
+    void runChunks() {
+        for (;;) {
+            size_t begin = next.fetch_add(grain);
+            if (begin >= count) break;
+            size_t end = begin + grain < count ? begin + grain : count;
+            (*job)(begin, end);
+        }
+    }
+
+    void workerLoop() {
+        unsigned long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+
+            runChunks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pendingWorkers == 0) done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned long generation;
+    int pendingWorkers;
+    bool stopping;
+
+    // Current job
+    size_t count;
+    size_t grain;
+    std::atomic<size_t> next;
+    const std::function<void(size_t, size_t)>* job;
+};
+
+#endif // THREAD_POOL_H
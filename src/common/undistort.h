@@ -0,0 +1,357 @@
+#ifndef UNDISTORT_H
+#define UNDISTORT_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "image_io.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "frame_stats.h"
+
+/*
+ * Lens undistortion
+ * Brown-Conrady model: radial k1, k2, k3 and tangential p1, p2 on top of a
+ * pinhole camera (fx, fy, cx, cy). A remap table is built once per set of lens
+ * parameters: for every output pixel it stores the top-left source pixel and
+ * 8-bit fractional bilinear weights (8 bytes per pixel). Applying it to a frame
+ * is then a pure streaming pass, split into cache-sized tiles across threads
+ * and sampled 4 pixels at a time with SIMD.
+ */
+
+struct LensModel {
+    float fx, fy;          // Focal lengths in pixels
+    float cx, cy;          // Principal point
+    float k1, k2, k3;      // Radial coefficients
+    float p1, p2;          // Tangential coefficients
+};
+
+// Lens for a width x height image with the principal point at the center
+inline LensModel makeLensModel(int width, int height, float k1, float k2,
+                               float k3 = 0.0f, float p1 = 0.0f, float p2 = 0.0f) {
+    float f = 0.5f * (width > height ? width : height);
+    LensModel lens = { f, f, 0.5f * (width - 1), 0.5f * (height - 1), k1, k2, k3, p1, p2 };
+    return lens;
+}
+
+// Apply the distortion model to normalized camera coordinates
+inline void distortNormalized(const LensModel& lens, float x, float y, float& xd, float& yd) {
+    float r2 = x * x + y * y;
+    float radial = 1.0f + r2 * (lens.k1 + r2 * (lens.k2 + r2 * lens.k3));
+    xd = x * radial + 2.0f * lens.p1 * x * y + lens.p2 * (r2 + 2.0f * x * x);
+    yd = y * radial + lens.p1 * (r2 + 2.0f * y * y) + 2.0f * lens.p2 * x * y;
+}
+
+// Invert the distortion by fixed-point iteration (converges for moderate distortion)
+inline void undistortNormalized(const LensModel& lens, float xd, float yd, float& x, float& y) {
+    x = xd;
+    y = yd;
+    for (int i = 0; i < 20; i++) {
+        float r2 = x * x + y * y;
+        float radial = 1.0f + r2 * (lens.k1 + r2 * (lens.k2 + r2 * lens.k3));
+        float dx = 2.0f * lens.p1 * x * y + lens.p2 * (r2 + 2.0f * x * x);
+        float dy = lens.p1 * (r2 + 2.0f * y * y) + 2.0f * lens.p2 * x * y;
+        x = (xd - dx) / radial;
+        y = (yd - dy) / radial;
+    }
+}
+
+// Lens parameters as a text file, written by --calibrate:
+// "width height fx fy cx cy k1 k2 k3 p1 p2", width x height being the size
+// of the calibration images the pixel parameters refer to
+inline bool writeLensModel(const char* path, const LensModel& lens, int width, int height) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to write lens file: %s\n", path);
+        return false;
+    }
+    fprintf(file, "# width height fx fy cx cy k1 k2 k3 p1 p2\n%d %d %.6f %.6f %.6f %.6f %.9g %.9g %.9g %.9g %.9g\n",
+            width, height, lens.fx, lens.fy, lens.cx, lens.cy, lens.k1, lens.k2, lens.k3, lens.p1, lens.p2);
+    fclose(file);
+    return true;
+}
+
+inline bool readLensModel(const char* path, LensModel& lens, int& width, int& height) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open lens file: %s\n", path);
+        return false;
+    }
+    char line[256];
+    float v[11];
+    int fields = 0;
+    while (fields <= 0 && fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        fields = sscanf(line, "%f %f %f %f %f %f %f %f %f %f %f",
+                        &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9], &v[10]);
+    }
+    fclose(file);
+    if (fields == 11 && v[0] >= 1.0f && v[1] >= 1.0f) {
+        width = (int)v[0];
+        height = (int)v[1];
+        LensModel read = { v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10] };
+        lens = read;
+        return true;
+    }
+    if (fields == 9)  // Written before the size was recorded
+        fprintf(stderr, "Lens file %s has no calibration image size; save it again with --calibrate\n", path);
+    else
+        fprintf(stderr, "Invalid lens file: %s\n", path);
+    return false;
+}
+
+// The lens of a width x height calibration at another image size. Only a
+// uniform rescale keeps the pixel parameters valid: false if the aspect ratio
+// differs (the image was cropped, not just resized).
+inline bool scaleLensModel(const LensModel& lens, int width, int height, int toWidth, int toHeight, LensModel& out) {
+    double sx = (double)toWidth / width, sy = (double)toHeight / height;
+    if (fabs(sx - sy) > 0.01 * sx) return false;
+    out = lens;
+    out.fx = (float)(lens.fx * sx);
+    out.fy = (float)(lens.fy * sy);
+    out.cx = (float)((lens.cx + 0.5) * sx - 0.5);  // Pixel centers sit at +0.5
+    out.cy = (float)((lens.cy + 0.5) * sy - 0.5);
+    return true;
+}
+
+// One output pixel: byte offset of the top-left source pixel (-1 = outside)
+// and bilinear fractions in 1/256 steps
+struct RemapEntry {
+    int32_t offset;
+    uint16_t fx;
+    uint16_t fy;
+};
+
+struct RemapTable {
+    int width, height;        // Output size
+    int srcWidth, srcHeight;  // Source size
+    int channels;             // Source/output channels the offsets were built for
+    std::vector<RemapEntry> entries;
+};
+
+// Store the source position (sx, sy) for output pixel i
+inline void setRemapEntry(RemapTable& table, size_t i, float sx, float sy) {
+    RemapEntry& e = table.entries[i];
+    if (!(sx >= 0.0f && sy >= 0.0f && sx <= table.srcWidth - 1 && sy <= table.srcHeight - 1)) {
+        e.offset = -1;
+        e.fx = e.fy = 0;
+        return;
+    }
+
+    // Keep x0 + 1 / y0 + 1 inside the image on the last row/column
+    int x0 = (int)sx, y0 = (int)sy;
+    if (x0 > table.srcWidth - 2) x0 = table.srcWidth - 2;
+    if (y0 > table.srcHeight - 2) y0 = table.srcHeight - 2;
+    e.offset = (int32_t)(((size_t)y0 * table.srcWidth + x0) * table.channels);
+    e.fx = (uint16_t)((sx - x0) * 256.0f + 0.5f);
+    e.fy = (uint16_t)((sy - y0) * 256.0f + 0.5f);
+}
+
+enum RemapDirection {
+    REMAP_UNDISTORT,  // Output is the corrected image of a distorted source
+    REMAP_DISTORT     // Output is what the lens would record of an ideal source
+};
+
+// Build the table once per lens; rows are split across the pool
+inline void buildRemapTable(const LensModel& lens, RemapDirection direction, int width, int height,
+                            int channels, RemapTable& table, ThreadPool* pool) {
+    table.width = table.srcWidth = width;
+    table.height = table.srcHeight = height;
+    table.channels = channels;
+    table.entries.resize((size_t)width * height);
+
+    auto buildRows = [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            for (int u = 0; u < width; u++) {
+                float x = (u - lens.cx) / lens.fx;
+                float y = ((float)v - lens.cy) / lens.fy;
+                float sx, sy;
+                if (direction == REMAP_UNDISTORT)
+                    distortNormalized(lens, x, y, sx, sy);
+                else
+                    undistortNormalized(lens, x, y, sx, sy);
+                setRemapEntry(table, v * width + u, sx * lens.fx + lens.cx, sy * lens.fy + lens.cy);
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(height, 16, buildRows);
+    else
+        buildRows(0, height);
+}
+
+// Remap output pixels [begin, end) of one row span; 4 pixels per SIMD iteration
+inline void remapSpan(const RemapTable& table, const unsigned char* src, unsigned char* dst,
+                      size_t begin, size_t end) {
+    const int channels = table.channels;
+    const int stride = table.srcWidth * channels;
+    const RemapEntry* entries = table.entries.data();
+    const f32x4 scale = f32x4_set1(1.0f / 256.0f);
+    const f32x4 one = f32x4_set1(1.0f);
+    const f32x4 half = f32x4_set1(0.5f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const RemapEntry& e0 = entries[i];
+        const RemapEntry& e1 = entries[i + 1];
+        const RemapEntry& e2 = entries[i + 2];
+        const RemapEntry& e3 = entries[i + 3];
+
+        // Outside pixels sample offset 0 with zero weight
+        f32x4 valid = f32x4_set(e0.offset >= 0, e1.offset >= 0, e2.offset >= 0, e3.offset >= 0);
+        f32x4 fx = f32x4_mul(f32x4_set(e0.fx, e1.fx, e2.fx, e3.fx), scale);
+        f32x4 fy = f32x4_mul(f32x4_set(e0.fy, e1.fy, e2.fy, e3.fy), scale);
+        f32x4 gx = f32x4_sub(one, fx);
+        f32x4 gy = f32x4_mul(f32x4_sub(one, fy), valid);
+        fy = f32x4_mul(fy, valid);
+        f32x4 w00 = f32x4_mul(gx, gy), w01 = f32x4_mul(fx, gy);
+        f32x4 w10 = f32x4_mul(gx, fy), w11 = f32x4_mul(fx, fy);
+
+        const unsigned char* s0 = src + (e0.offset >= 0 ? e0.offset : 0);
+        const unsigned char* s1 = src + (e1.offset >= 0 ? e1.offset : 0);
+        const unsigned char* s2 = src + (e2.offset >= 0 ? e2.offset : 0);
+        const unsigned char* s3 = src + (e3.offset >= 0 ? e3.offset : 0);
+
+        for (int c = 0; c < channels; c++) {
+            f32x4 p00 = f32x4_set(s0[c], s1[c], s2[c], s3[c]);
+            f32x4 p01 = f32x4_set(s0[c + channels], s1[c + channels], s2[c + channels], s3[c + channels]);
+            f32x4 p10 = f32x4_set(s0[c + stride], s1[c + stride], s2[c + stride], s3[c + stride]);
+            f32x4 p11 = f32x4_set(s0[c + stride + channels], s1[c + stride + channels],
+                                  s2[c + stride + channels], s3[c + stride + channels]);
+            f32x4 value = f32x4_add(f32x4_add(f32x4_mul(p00, w00), f32x4_mul(p01, w01)),
+                                    f32x4_add(f32x4_mul(p10, w10), f32x4_mul(p11, w11)));
+            float out[4];
+            f32x4_store(out, f32x4_add(value, half));
+            for (int k = 0; k < 4; k++)
+                dst[(i + k) * channels + c] = (unsigned char)out[k];
+        }
+    }
+
+    // Remainder pixels
+    for (; i < end; i++) {
+        const RemapEntry& e = entries[i];
+        for (int c = 0; c < channels; c++) {
+            if (e.offset < 0) {
+                dst[i * channels + c] = 0;
+                continue;
+            }
+            const unsigned char* s = src + e.offset + c;
+            int top = s[0] * (256 - e.fx) + s[channels] * e.fx;
+            int bottom = s[stride] * (256 - e.fx) + s[stride + channels] * e.fx;
+            dst[i * channels + c] = (unsigned char)((top * (256 - e.fy) + bottom * e.fy + 32768) >> 16);
+        }
+    }
+}
+
+// Output tile size: 64 x 32 pixels = 16 KB of table plus the touched source rows
+const int REMAP_TILE_W = 64;
+const int REMAP_TILE_H = 32;
+
+// Apply a remap table to source pixels laid out as the table expects (e.g. a
+// memory-mapped frame) into table.width x table.height x channels bytes at
+// dstPixels (e.g. a mapped pixel-unpack buffer), tiles split across the pool
+inline void remapPixels(const RemapTable& table, const unsigned char* srcPixels, unsigned char* dstPixels,
+                        ThreadPool* pool) {
+    int tilesX = (table.width + REMAP_TILE_W - 1) / REMAP_TILE_W;
+    int tilesY = (table.height + REMAP_TILE_H - 1) / REMAP_TILE_H;
+
+    auto remapTiles = [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            int x0 = (int)(t % tilesX) * REMAP_TILE_W;
+            int y0 = (int)(t / tilesX) * REMAP_TILE_H;
+            int x1 = x0 + REMAP_TILE_W < table.width ? x0 + REMAP_TILE_W : table.width;
+            int y1 = y0 + REMAP_TILE_H < table.height ? y0 + REMAP_TILE_H : table.height;
+            for (int y = y0; y < y1; y++) {
+                size_t row = (size_t)y * table.width;
+                remapSpan(table, srcPixels, dstPixels, row + x0, row + x1);
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor((size_t)tilesX * tilesY, 4, remapTiles);
+    else
+        remapTiles(0, (size_t)tilesX * tilesY);
+}
+
+inline void remapPixels(const RemapTable& table, const unsigned char* srcPixels, Image& dst, ThreadPool* pool) {
+    allocateImage(dst, table.width, table.height, table.channels);
+    remapPixels(table, srcPixels, dst.pixels.data(), pool);
+}
+
+// Apply a remap table to one image
+inline bool remapImage(const RemapTable& table, const Image& src, Image& dst, ThreadPool* pool) {
+    if (src.width != table.srcWidth || src.height != table.srcHeight || src.channels != table.channels) {
+        fprintf(stderr, "Remap table was built for %dx%dx%d, image is %dx%dx%d\n",
+                table.srcWidth, table.srcHeight, table.channels, src.width, src.height, src.channels);
+        return false;
+    }
+    remapPixels(table, src.pixels.data(), dst, pool);
+    return true;
+}
+
+// Synthetic test pattern: checkerboard with a colored border (channels = 1 or 3)
+inline void makeCheckerboard(Image& image, int width, int height, int channels, int squareSize) {
+    allocateImage(image, width, height, channels);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool white = ((x / squareSize) + (y / squareSize)) % 2 == 0;
+            unsigned char* p = &image.pixels[((size_t)y * width + x) * channels];
+            for (int c = 0; c < channels; c++)
+                p[c] = white ? 230 : 40;
+            if (channels == 3 && (x < squareSize / 4 || y < squareSize / 4 ||
+                                  x >= width - squareSize / 4 || y >= height - squareSize / 4)) {
+                p[0] = 255; p[1] = 128; p[2] = 0;  // Orange frame shows the image edge
+            }
+        }
+    }
+}
+
+// ./main --bench-cpu undistort: megapixels per second versus thread count
+inline void runUndistortBenchmark(int frames) {
+    const int width = 1920, height = 1080, channels = 3;
+    LensModel lens = makeLensModel(width, height, -0.28f, 0.08f, 0.0f, 0.001f, -0.0005f);
+
+    ThreadPool pool;
+    RemapTable table;
+    double start = wallTimeMs();
+    buildRemapTable(lens, REMAP_UNDISTORT, width, height, channels, table, &pool);
+    double buildMs = wallTimeMs() - start;
+
+    Image src, dst;
+    makeCheckerboard(src, width, height, channels, 60);
+
+    double megapixels = (double)width * height * frames / 1.0e6;
+    // Bytes touched per pixel: 8 (table) + channels (output) + ~channels (source)
+    double bytesPerPixel = sizeof(RemapEntry) + 2.0 * channels;
+
+    printf("Undistort benchmark: %d frames of %dx%d RGB (remap table built in %.2f ms)\n\n",
+           frames, width, height, buildMs);
+    printf("Threads    Time ms        MP/s       GB/s   Speedup\n");
+    printf("-------  ---------  ----------  ---------  --------\n");
+
+    double baseline = 0.0;
+    int maxThreads = pool.size();
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads) threads = maxThreads;
+        ThreadPool runPool(threads);
+
+        remapImage(table, src, dst, &runPool);  // Warm-up
+        start = wallTimeMs();
+        for (int f = 0; f < frames; f++)
+            remapImage(table, src, dst, &runPool);
+        double elapsed = wallTimeMs() - start;
+
+        double rate = megapixels / (elapsed / 1000.0);
+        if (threads == 1) baseline = rate;
+        printf("%7d  %9.2f  %10.1f  %9.2f  %7.2fx\n", threads, elapsed, rate,
+               rate * bytesPerPixel / 1000.0, rate / baseline);
+
+        if (threads == maxThreads) break;
+    }
+    printf("\n");
+}
+
+#endif // UNDISTORT_H
@@ -0,0 +1,161 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "opengl_setup.h"
+
+/*
+ * Compact vertex formats
+ *
+ * geometry.h writes float (x, y, z) vertices; the activities pack them with
+ * the helpers below before upload and describe the packed layout to
+ * glVertexAttribPointer with a VertexAttribFormat. Vertex fetch converts
+ * normalized integers and half floats back to float, so the shaders keep
+ * their vec2/vec3/vec4 inputs unchanged.
+ *
+ *   VERTEX_SNORM16x2   2D positions in [-1, 1] (unit discs, quads, orbits)  4 bytes
+ *   VERTEX_HALFx2      2D positions in scene units (11-bit mantissa)       4 bytes
+ *   VERTEX_SNORM10x3   unit vectors (icosphere vertices and normals)       4 bytes
+ *   VERTEX_UNORM8x4    RGBA colors                                         4 bytes
+ *
+ * Positions that do not fit [-1, 1] can be divided by a scale before
+ * packing to snorm16, with the scale folded back into the projection
+ * (scaleMatrixColumns). A color shared by a whole draw needs no per-vertex
+ * storage at all: leave its attribute array disabled and set the value with
+ * glVertexAttrib4f before drawing.
+ *
+ * Every format is a multiple of 4 bytes so packed vertices stay aligned
+ * (Metal-based macOS drivers require it). The software renderer decodes the
+ * same types (soft_gl.h).
+ */
+
+struct VertexAttribFormat {
+    GLint size;            // Components, as passed to glVertexAttribPointer
+    GLenum type;
+    GLboolean normalized;
+    int bytes;             // One element
+};
+
+const VertexAttribFormat VERTEX_SNORM16x2 = { 2, GL_SHORT, GL_TRUE, 4 };
+const VertexAttribFormat VERTEX_HALFx2 = { 2, GL_HALF_FLOAT, GL_FALSE, 4 };
+// GL requires size 4 for the packed 2_10_10_10 type; w is 0 and vec3 inputs ignore it
+const VertexAttribFormat VERTEX_SNORM10x3 = { 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4 };
+const VertexAttribFormat VERTEX_UNORM8x4 = { 4, GL_UNSIGNED_BYTE, GL_TRUE, 4 };
+
+// RGBA color as four normalized bytes (VERTEX_UNORM8x4)
+struct PackedColor {
+    uint8_t r, g, b, a;
+};
+
+// Half-float position plus RGBA8 color: the 6-float position + color layout in 8 bytes
+struct PackedColorVertex {
+    uint16_t x, y;
+    PackedColor color;
+};
+
+// ---- Scalar packing ----
+
+inline int16_t packSnorm16(float v) {
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int16_t)lrintf(v * 32767.0f);
+}
+
+inline uint8_t packUnorm8(float v) {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint8_t)lrintf(v * 255.0f);
+}
+
+// IEEE half float, rounded to nearest even; overflow becomes infinity
+inline uint16_t packHalf(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000)  // Infinity or NaN
+        return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+    if (magnitude >= 0x477FF000)  // Rounds to 65520 or more
+        return sign | 0x7C00;
+    if (magnitude < 0x38800000) {  // Below 2^-14: half subnormal or zero
+        if (magnitude < 0x33000000) return sign;
+        uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+        int shift = 126 - (int)(magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return sign | (uint16_t)half;
+    }
+    uint32_t half = (magnitude - 0x38000000) >> 13;  // Rebias the exponent from 127 to 15
+    uint32_t rest = magnitude & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return sign | (uint16_t)half;
+}
+
+// x, y, z in [-1, 1] as GL_INT_2_10_10_10_REV (x in the low bits, w = 0)
+inline uint32_t packSnorm10x3(float x, float y, float z) {
+    float v[3] = { x, y, z };
+    uint32_t packed = 0;
+    for (int c = 0; c < 3; c++) {
+        float clamped = v[c] < -1.0f ? -1.0f : (v[c] > 1.0f ? 1.0f : v[c]);
+        packed |= ((uint32_t)lrintf(clamped * 511.0f) & 0x3FF) << (10 * c);
+    }
+    return packed;
+}
+
+inline PackedColor packColor(float r, float g, float b, float a = 1.0f) {
+    PackedColor color = { packUnorm8(r), packUnorm8(g), packUnorm8(b), packUnorm8(a) };
+    return color;
+}
+
+// ---- Mesh packing (input stride in floats, as in geometry.h) ----
+
+// x and y of each vertex divided by scale, as snorm16 pairs
+inline void packPositionsSnorm16(const float* in, int stride, int count, float scale, std::vector<int16_t>& out) {
+    float inverse = 1.0f / scale;
+    out.resize((size_t)count * 2);
+    for (int i = 0; i < count; i++, in += stride) {
+        out[2 * i] = packSnorm16(in[0] * inverse);
+        out[2 * i + 1] = packSnorm16(in[1] * inverse);
+    }
+}
+
+// x, y, z of each vertex (unit length) as GL_INT_2_10_10_10_REV
+inline void packNormalsSnorm10(const float* in, int stride, int count, std::vector<uint32_t>& out) {
+    out.resize(count);
+    for (int i = 0; i < count; i++, in += stride)
+        out[i] = packSnorm10x3(in[0], in[1], in[2]);
+}
+
+// Position (x, y, z) + color (r, g, b) vertices: half-float x, y and RGBA8 color
+inline void packColorVertices(const float* in, int stride, int count, std::vector<PackedColorVertex>& out) {
+    out.resize(count);
+    for (int i = 0; i < count; i++, in += stride) {
+        out[i].x = packHalf(in[0]);
+        out[i].y = packHalf(in[1]);
+        out[i].color = packColor(in[3], in[4], in[5]);
+    }
+}
+
+// Undo a packing scale inside a column-major matrix: M * diag(scale, scale, scale, 1)
+inline void scaleMatrixColumns(const float in[16], float scale, float out[16]) {
+    for (int i = 0; i < 16; i++)
+        out[i] = i < 12 ? in[i] * scale : in[i];
+}
+
+// ---- Attribute setup ----
+
+// Point attribute 'index' at the array buffer bound now, 'offset' bytes in
+inline void pointVertexAttribute(GLuint index, const VertexAttribFormat& format, GLsizei stride, size_t offset) {
+    glVertexAttribPointer(index, format.size, format.type, format.normalized, stride, (void*)offset);
+}
+
+inline void setVertexAttribute(GLuint index, const VertexAttribFormat& format, GLsizei stride, size_t offset) {
+    pointVertexAttribute(index, format, stride, offset);
+    glEnableVertexAttribArray(index);
+}
+
+#endif // VERTEX_FORMAT_H